@@ -0,0 +1,537 @@
+#include "bitstring.h"
+
+
+/* ==== BitString ========================================================== */
+
+/* A BitString holds the bits like PostgreSQL does, left aligned in bytes. The
+ * bytes are exposed through the buffer protocol.
+ */
+
+typedef struct {
+    PyObject_VAR_HEAD           /* ob_size is the number of bytes */
+    Py_ssize_t bit_len;         /* number of bits */
+    unsigned char data[1];
+} PoqueBitString;
+
+
+#define BitString_BYTES(bits) (((bits) + 7) / 8)
+
+
+static PoqueBitString *
+BitString_New(Py_ssize_t bit_len)
+{
+    /* Creates a BitString with all bits zero */
+    PoqueBitString *self;
+    Py_ssize_t byte_len = BitString_BYTES(bit_len);
+
+    self = PyObject_NewVar(PoqueBitString, &PoqueBitStringType, byte_len);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->bit_len = bit_len;
+    memset(self->data, 0, byte_len);
+    return self;
+}
+
+
+static PyObject *
+bit_long_from_bytes(unsigned char *data, Py_ssize_t byte_len, int rest)
+{
+    /* Creates an int from left aligned bits in one go */
+    PyObject *val, *shift, *ret;
+
+    val = _PyLong_FromByteArray(data, byte_len, 0, 0);
+    if (val == NULL || rest == 0) {
+        return val;
+    }
+
+    /* correct for the fact that the pg bitstring is left aligned */
+    shift = PyLong_FromLong(8 - rest);
+    if (shift == NULL) {
+        Py_DECREF(val);
+        return NULL;
+    }
+    ret = PyNumber_Rshift(val, shift);
+    Py_DECREF(shift);
+    Py_DECREF(val);
+    return ret;
+}
+
+
+static int
+bitstring_parse(unsigned char *dest, const char *data, Py_ssize_t len)
+{
+    /* sets the bits from a string of '0' and '1' characters */
+    Py_ssize_t i;
+
+    for (i = 0; i < len; i++) {
+        if (data[i] == '1') {
+            dest[i / 8] |= 0x80 >> (i % 8);
+        }
+        else if (data[i] != '0') {
+            PyErr_SetString(PyExc_ValueError,
+                            "Invalid character in bit string");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static PyObject *
+BitString_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"bits", NULL};
+    const char *bits;
+    Py_ssize_t len;
+    PoqueBitString *self;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "s#", kwlist, &bits, &len)) {
+        return NULL;
+    }
+    /* the bit length is an int32 in the pg value */
+    if (len > INT32_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Bit string too long");
+        return NULL;
+    }
+    self = BitString_New(len);
+    if (self == NULL) {
+        return NULL;
+    }
+    if (bitstring_parse(self->data, bits, len) == -1) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+BitString_from_bytes(PyTypeObject *type, PyObject *args)
+{
+    Py_buffer buf;
+    Py_ssize_t bit_len = -1;
+    PoqueBitString *self;
+
+    if (!PyArg_ParseTuple(args, "y*|n", &buf, &bit_len)) {
+        return NULL;
+    }
+    if (bit_len == -1) {
+        bit_len = buf.len * 8;
+    }
+    if (bit_len < 0 || BitString_BYTES(bit_len) != buf.len) {
+        PyBuffer_Release(&buf);
+        PyErr_SetString(PyExc_ValueError,
+                        "Number of bits does not match the data");
+        return NULL;
+    }
+    self = BitString_New(bit_len);
+    if (self != NULL) {
+        memcpy(self->data, buf.buf, buf.len);
+        if (bit_len % 8) {
+            /* keep the unused bits zero */
+            self->data[buf.len - 1] &= 0xFF << (8 - bit_len % 8);
+        }
+    }
+    PyBuffer_Release(&buf);
+    return (PyObject *)self;
+}
+
+
+static Py_ssize_t
+bitstring_popcount(unsigned char *data, Py_ssize_t len)
+{
+    Py_ssize_t count = 0, i = 0;
+
+#if defined(__GNUC__)
+    for (; i + 8 <= len; i += 8) {
+        unsigned long long chunk;
+
+        memcpy(&chunk, data + i, 8);
+        count += __builtin_popcountll(chunk);
+    }
+    for (; i < len; i++) {
+        count += __builtin_popcount(data[i]);
+    }
+#else
+    for (; i < len; i++) {
+        unsigned char c = data[i];
+
+        for (; c; c &= c - 1) {
+            count++;
+        }
+    }
+#endif
+    return count;
+}
+
+
+static PyObject *
+BitString_popcount(PoqueBitString *self, PyObject *unused)
+{
+    return PyLong_FromSsize_t(
+        bitstring_popcount(self->data, Py_SIZE(self)));
+}
+
+
+static PyObject *
+BitString_bitop(PyObject *a, PyObject *b, int op)
+{
+    PoqueBitString *x, *y, *ret;
+    Py_ssize_t i;
+
+    if (Py_TYPE(a) != &PoqueBitStringType ||
+            Py_TYPE(b) != &PoqueBitStringType) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    x = (PoqueBitString *)a;
+    y = (PoqueBitString *)b;
+    if (x->bit_len != y->bit_len) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Bit strings must be of the same length");
+        return NULL;
+    }
+    ret = BitString_New(x->bit_len);
+    if (ret == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < Py_SIZE(x); i++) {
+        switch (op) {
+        case '&':
+            ret->data[i] = x->data[i] & y->data[i];
+            break;
+        case '|':
+            ret->data[i] = x->data[i] | y->data[i];
+            break;
+        default:
+            ret->data[i] = x->data[i] ^ y->data[i];
+        }
+    }
+    return (PyObject *)ret;
+}
+
+
+static PyObject *
+BitString_and(PyObject *a, PyObject *b)
+{
+    return BitString_bitop(a, b, '&');
+}
+
+
+static PyObject *
+BitString_or(PyObject *a, PyObject *b)
+{
+    return BitString_bitop(a, b, '|');
+}
+
+
+static PyObject *
+BitString_xor(PyObject *a, PyObject *b)
+{
+    return BitString_bitop(a, b, '^');
+}
+
+
+static PyObject *
+BitString_int(PoqueBitString *self)
+{
+    /* the bits as an unsigned int, like the default bit conversion */
+    return bit_long_from_bytes(self->data, Py_SIZE(self), self->bit_len % 8);
+}
+
+
+static Py_ssize_t
+BitString_length(PoqueBitString *self)
+{
+    return self->bit_len;
+}
+
+
+static PyObject *
+BitString_item(PoqueBitString *self, Py_ssize_t i)
+{
+    if (i < 0 || i >= self->bit_len) {
+        PyErr_SetString(PyExc_IndexError, "BitString index out of range");
+        return NULL;
+    }
+    return PyBool_FromLong(self->data[i / 8] & (0x80 >> (i % 8)));
+}
+
+
+static PyObject *
+BitString_str(PoqueBitString *self)
+{
+    PyObject *ret;
+    Py_UCS1 *pos;
+    Py_ssize_t i;
+
+    ret = PyUnicode_New(self->bit_len, 127);
+    if (ret == NULL) {
+        return NULL;
+    }
+    pos = PyUnicode_1BYTE_DATA(ret);
+    for (i = 0; i < self->bit_len; i++) {
+        pos[i] = (self->data[i / 8] & (0x80 >> (i % 8))) ? '1' : '0';
+    }
+    return ret;
+}
+
+
+static PyObject *
+BitString_repr(PoqueBitString *self)
+{
+    PyObject *str, *ret;
+
+    str = BitString_str(self);
+    if (str == NULL) {
+        return NULL;
+    }
+    ret = PyUnicode_FromFormat("BitString('%U')", str);
+    Py_DECREF(str);
+    return ret;
+}
+
+
+static PyObject *
+BitString_richcompare(PyObject *a, PyObject *b, int op)
+{
+    PoqueBitString *x, *y;
+    int equal;
+
+    if (Py_TYPE(b) != &PoqueBitStringType || (op != Py_EQ && op != Py_NE)) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    x = (PoqueBitString *)a;
+    y = (PoqueBitString *)b;
+    equal = x->bit_len == y->bit_len &&
+        memcmp(x->data, y->data, Py_SIZE(x)) == 0;
+    return PyBool_FromLong(op == Py_EQ ? equal : !equal);
+}
+
+
+static int
+BitString_GetBuffer(PyObject *exporter, Py_buffer *view, int flags)
+{
+    PoqueBitString *self = (PoqueBitString *)exporter;
+
+    return PyBuffer_FillInfo(
+        view, exporter, self->data, Py_SIZE(self), 1, flags);
+}
+
+
+static PyBufferProcs BitString_BufProcs = {
+    BitString_GetBuffer,
+    NULL
+};
+
+
+static PyNumberMethods BitString_as_number = {
+    0,                                          /* nb_add */
+    0,                                          /* nb_subtract */
+    0,                                          /* nb_multiply */
+    0,                                          /* nb_remainder */
+    0,                                          /* nb_divmod */
+    0,                                          /* nb_power */
+    0,                                          /* nb_negative */
+    0,                                          /* nb_positive */
+    0,                                          /* nb_absolute */
+    0,                                          /* nb_bool */
+    0,                                          /* nb_invert */
+    0,                                          /* nb_lshift */
+    0,                                          /* nb_rshift */
+    BitString_and,                              /* nb_and */
+    BitString_xor,                              /* nb_xor */
+    BitString_or,                               /* nb_or */
+    (unaryfunc)BitString_int,                   /* nb_int */
+};
+
+
+static PySequenceMethods BitString_as_sequence = {
+    (lenfunc)BitString_length,                  /* sq_length */
+    0,                                          /* sq_concat */
+    0,                                          /* sq_repeat */
+    (ssizeargfunc)BitString_item,               /* sq_item */
+};
+
+
+static PyMethodDef BitString_methods[] = {
+    {"popcount", (PyCFunction)BitString_popcount, METH_NOARGS,
+     PyDoc_STR("number of bits set")},
+    {"from_bytes", (PyCFunction)BitString_from_bytes,
+     METH_VARARGS | METH_CLASS,
+     PyDoc_STR("creates a BitString from left aligned bytes and optionally "
+               "the number of bits")},
+    {NULL}  /* Sentinel */
+};
+
+
+PyTypeObject PoqueBitStringType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.BitString",                          /* tp_name */
+    offsetof(PoqueBitString, data),             /* tp_basicsize */
+    1,                                          /* tp_itemsize */
+    0,                                          /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)BitString_repr,                   /* tp_repr */
+    &BitString_as_number,                       /* tp_as_number */
+    &BitString_as_sequence,                     /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    PyObject_HashNotImplemented,                /* tp_hash  */
+    0,                                          /* tp_call */
+    (reprfunc)BitString_str,                    /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    &BitString_BufProcs,                        /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    "PostgreSQL bit string",                    /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    BitString_richcompare,                      /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    BitString_methods,                          /* tp_methods */
+    0,                                          /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    BitString_new,                              /* tp_new */
+};
+
+
+/* ==== bit readers ======================================================== */
+
+static PyObject *
+bit_strval(
+        PoqueResult *result, char *data, int len, PoqueValueHandler *unused) {
+    /* Reads a bitstring from text, by packing the characters into bytes */
+    PoqueBitString *bits;
+    PyObject *ret;
+
+    bits = BitString_New(len);
+    if (bits == NULL) {
+        return NULL;
+    }
+    if (bitstring_parse(bits->data, data, len) == -1) {
+        PyErr_Clear();
+        PyErr_SetString(PoqueError, "Invalid character in bit string");
+        Py_DECREF(bits);
+        return NULL;
+    }
+    if (result->conn->bit_as == BIT_AS_BITSTRING) {
+        return (PyObject *)bits;
+    }
+    ret = bit_long_from_bytes(bits->data, Py_SIZE(bits), len % 8);
+    Py_DECREF(bits);
+    return ret;
+}
+
+
+static PyObject *
+bit_binval(
+        PoqueResult *result, char *data, int len, PoqueValueHandler *unused) {
+    /* Reads a bitstring as a Python integer or BitString
+
+    Format:
+       * signed int: number of bits (bit_len)
+       * bytes: All the bits left aligned
+
+    */
+    int bit_len, rest, byte_len;
+
+    /* first get the number of bits in the bit string */
+    if (len < 4) {
+        PyErr_SetString(PoqueError,
+                        "Invalid binary bit string");
+        return NULL;
+    }
+    bit_len = read_int32((unsigned char *)data);
+    if (bit_len < 0) {
+        PyErr_SetString(PoqueError,
+                        "Invalid length value in binary bit string");
+        return NULL;
+    }
+
+    rest = bit_len % 8;  /* number of bits in remaining byte */
+    byte_len = BitString_BYTES(bit_len); /* total number of data bytes */
+    if (len != byte_len + 4) {
+        PyErr_SetString(PoqueError,
+                        "Invalid binary bit string");
+        return NULL;
+    }
+
+    if (result->conn->bit_as == BIT_AS_BITSTRING) {
+        PoqueBitString *bits;
+
+        bits = BitString_New(bit_len);
+        if (bits != NULL) {
+            memcpy(bits->data, data + 4, byte_len);
+        }
+        return (PyObject *)bits;
+    }
+    return bit_long_from_bytes((unsigned char *)data + 4, byte_len, rest);
+}
+
+
+/* ==== BitString parameter ================================================ */
+
+static int
+bitstring_examine(param_handler *handler, PyObject *param) {
+    Py_ssize_t size = 4 + Py_SIZE(param);
+
+    if (size > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Bit string too long");
+        return -1;
+    }
+    return (int)size;
+}
+
+
+static int
+bitstring_encode_at(param_handler *handler, PyObject *param, char *loc) {
+    PoqueBitString *bits = (PoqueBitString *)param;
+
+    write_uint32(&loc, (PY_UINT32_T)bits->bit_len);
+    memcpy(loc, bits->data, Py_SIZE(bits));
+    return 4 + (int)Py_SIZE(bits);
+}
+
+
+static param_handler bitstring_param_handler = {
+    bitstring_examine,      /* examine */
+    NULL,                   /* total_size */
+    NULL,                   /* encode */
+    bitstring_encode_at,    /* encode_at */
+    NULL,                   /* free */
+    VARBITOID,              /* oid */
+    VARBITARRAYOID          /* array_oid */
+}; /* static initialized handler */
+
+
+static param_handler *
+new_bitstring_param_handler(int num_param) {
+    return &bitstring_param_handler;
+}
+
+
+PoqueValueHandler bit_val_handler = {{bit_strval, bit_binval}, ',', NULL};
+PoqueValueHandler bitarray_val_handler = {
+        {array_strval, array_binval}, ',', &bit_val_handler};
+
+
+int
+init_bitstring(void)
+{
+    register_parameter_handler(
+        &PoqueBitStringType, new_bitstring_param_handler);
+    return 0;
+}
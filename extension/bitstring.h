@@ -0,0 +1,11 @@
+#ifndef _POQUE_BITSTRING_H_
+#define _POQUE_BITSTRING_H_
+
+#include "poque_type.h"
+
+int init_bitstring(void);
+
+extern PoqueValueHandler bit_val_handler;
+extern PoqueValueHandler bitarray_val_handler;
+
+#endif
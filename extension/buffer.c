@@ -0,0 +1,1135 @@
+#include "buffer.h"
+#include "numeric.h"
+
+
+/* ==== ArrayBuffer ======================================================== */
+
+PoqueArrayBuffer *
+ArrayBuffer_New(const char *format, int itemsize, int ndim, Py_ssize_t *shape)
+{
+    /* Creates an uninitialized C contiguous ArrayBuffer */
+    PoqueArrayBuffer *self;
+    Py_ssize_t nbytes = itemsize;
+    int i;
+
+    for (i = 0; i < ndim; i++) {
+        if (shape[i] && nbytes > PY_SSIZE_T_MAX / shape[i]) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        nbytes *= shape[i];
+    }
+    self = PyObject_NewVar(PoqueArrayBuffer, &PoqueArrayBufferType, nbytes);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->ndim = ndim;
+    self->itemsize = itemsize;
+    strncpy(self->format, format, sizeof(self->format) - 1);
+    self->format[sizeof(self->format) - 1] = '\0';
+    for (i = ndim - 1; i >= 0; i--) {
+        self->shape[i] = shape[i];
+        self->strides[i] = (i == ndim - 1) ?
+            itemsize : self->strides[i + 1] * shape[i + 1];
+    }
+    return self;
+}
+
+
+static PyObject *
+ArrayBuffer_tuple(Py_ssize_t *values, int n)
+{
+    PyObject *ret, *val;
+    int i;
+
+    ret = PyTuple_New(n);
+    if (ret == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < n; i++) {
+        val = PyLong_FromSsize_t(values[i]);
+        if (val == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, i, val);
+    }
+    return ret;
+}
+
+
+static PyObject *
+ArrayBuffer_get_shape(PoqueArrayBuffer *self, void *unused)
+{
+    return ArrayBuffer_tuple(self->shape, self->ndim);
+}
+
+
+static PyObject *
+ArrayBuffer_get_format(PoqueArrayBuffer *self, void *unused)
+{
+    return PyUnicode_FromString(self->format);
+}
+
+
+static PyObject *
+ArrayBuffer_get_itemsize(PoqueArrayBuffer *self, void *unused)
+{
+    return PyLong_FromLong(self->itemsize);
+}
+
+
+static PyObject *
+ArrayBuffer_get_ndim(PoqueArrayBuffer *self, void *unused)
+{
+    return PyLong_FromLong(self->ndim);
+}
+
+
+static PyObject *
+ArrayBuffer_get_nbytes(PoqueArrayBuffer *self, void *unused)
+{
+    return PyLong_FromSsize_t(Py_SIZE(self));
+}
+
+
+static PyObject *
+ArrayBuffer_tolist(PoqueArrayBuffer *self, PyObject *unused)
+{
+    /* the items as (nested) list, same as the default array conversion */
+    PyObject *view, *ret;
+    _Py_IDENTIFIER(tolist);
+
+    view = PyMemoryView_FromObject((PyObject *)self);
+    if (view == NULL) {
+        return NULL;
+    }
+    ret = _PyObject_CallMethodIdObjArgs(view, &PyId_tolist, NULL);
+    Py_DECREF(view);
+    return ret;
+}
+
+
+static Py_ssize_t
+ArrayBuffer_length(PoqueArrayBuffer *self)
+{
+    return self->shape[0];
+}
+
+
+static PyObject *
+ArrayBuffer_repr(PoqueArrayBuffer *self)
+{
+    PyObject *shape, *ret;
+
+    shape = ArrayBuffer_get_shape(self, NULL);
+    if (shape == NULL) {
+        return NULL;
+    }
+    ret = PyUnicode_FromFormat(
+        "ArrayBuffer(format='%s', shape=%R)", self->format, shape);
+    Py_DECREF(shape);
+    return ret;
+}
+
+
+static int
+ArrayBuffer_GetBuffer(PyObject *exporter, Py_buffer *view, int flags)
+{
+    PoqueArrayBuffer *self = (PoqueArrayBuffer *)exporter;
+
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "ArrayBuffer is read only");
+        view->obj = NULL;
+        return -1;
+    }
+    /* The items are C contiguous. Without a shape a consumer can only take
+     * a single dimension, and F order only matches for a single dimension.
+     */
+    if (self->ndim > 1 && (!(flags & PyBUF_ND) ||
+            (flags & PyBUF_F_CONTIGUOUS) == PyBUF_F_CONTIGUOUS)) {
+        PyErr_SetString(PyExc_BufferError,
+                        (flags & PyBUF_ND) ?
+                        "ArrayBuffer is not Fortran contiguous" :
+                        "ArrayBuffer has more than one dimension");
+        view->obj = NULL;
+        return -1;
+    }
+    view->buf = self->data;
+    view->obj = exporter;
+    Py_INCREF(exporter);
+    view->len = Py_SIZE(self);
+    view->readonly = 1;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+    view->ndim = (flags & PyBUF_ND) ? self->ndim : 1;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ?
+        self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+
+static PyBufferProcs ArrayBuffer_BufProcs = {
+    ArrayBuffer_GetBuffer,
+    NULL
+};
+
+
+static PySequenceMethods ArrayBuffer_as_sequence = {
+    (lenfunc)ArrayBuffer_length,                /* sq_length */
+};
+
+
+static PyGetSetDef ArrayBuffer_getset[] = {{
+        "shape", (getter)ArrayBuffer_get_shape, NULL,
+        PyDoc_STR("length of each dimension"), NULL
+    }, {
+        "format", (getter)ArrayBuffer_get_format, NULL,
+        PyDoc_STR("struct module format of the items"), NULL
+    }, {
+        "itemsize", (getter)ArrayBuffer_get_itemsize, NULL,
+        PyDoc_STR("size of an item in bytes"), NULL
+    }, {
+        "ndim", (getter)ArrayBuffer_get_ndim, NULL,
+        PyDoc_STR("number of dimensions"), NULL
+    }, {
+        "nbytes", (getter)ArrayBuffer_get_nbytes, NULL,
+        PyDoc_STR("size of the data in bytes"), NULL
+    }, {
+        NULL
+}};
+
+
+static PyMethodDef ArrayBuffer_methods[] = {
+    {"tolist", (PyCFunction)ArrayBuffer_tolist, METH_NOARGS,
+     PyDoc_STR("the items as nested lists")},
+    {NULL}  /* Sentinel */
+};
+
+
+PyTypeObject PoqueArrayBufferType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.ArrayBuffer",                        /* tp_name */
+    offsetof(PoqueArrayBuffer, data),           /* tp_basicsize */
+    1,                                          /* tp_itemsize */
+    0,                                          /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)ArrayBuffer_repr,                 /* tp_repr */
+    0,                                          /* tp_as_number */
+    &ArrayBuffer_as_sequence,                   /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    PyObject_HashNotImplemented,                /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    &ArrayBuffer_BufProcs,                      /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    "Array of fixed width items in native byte order",  /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    ArrayBuffer_methods,                        /* tp_methods */
+    0,                                          /* tp_members */
+    ArrayBuffer_getset,                         /* tp_getset */
+};
+
+
+/* ==== item types ========================================================= */
+
+static const ArrayItemType item_types[] = {
+    {&int2_val_handler, "h", 2, INT2OID, INT2ARRAYOID},
+    {&int4_val_handler, "i", 4, INT4OID, INT4ARRAYOID},
+    {&int8_val_handler, "q", 8, INT8OID, INT8ARRAYOID},
+    {&float4_val_handler, "f", 4, FLOAT4OID, FLOAT4ARRAYOID},
+    {&float8_val_handler, "d", 8, FLOAT8OID, FLOAT8ARRAYOID},
+    {&id_val_handler, "I", 4, OIDOID, OIDARRAYOID},
+    {&bool_val_handler, "?", 1, BOOLOID, BOOLARRAYOID},
+    {NULL}
+};
+
+
+const ArrayItemType *
+array_item_type(PoqueValueHandler *el_handler)
+{
+    /* The item type for the element handler, NULL if not fixed width */
+    const ArrayItemType *item_type;
+
+    for (item_type = item_types; item_type->handler; item_type++) {
+        if (item_type->handler == el_handler) {
+            return item_type;
+        }
+    }
+    return NULL;
+}
+
+
+/* ==== binary array values ================================================ */
+
+/* In a binary array value every item is preceded by its length as a 32 bit
+ * word. A kernel converts n items of one size to native byte order, it stops
+ * early at an item with an unexpected length and returns the number of
+ * converted items. For 4 byte items the SSSE3 kernel checks and swaps four
+ * items at a time, the scalar code finishes the remaining items. For 8 byte
+ * items the scalar loop, which compiles to a bswap per item, is just as fast.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POQUE_SWAP_SIMD
+#include <immintrin.h>
+#endif
+
+
+typedef Py_ssize_t (*swap_kernel)(
+    const unsigned char *src, Py_ssize_t n, char *dest);
+
+
+static Py_ssize_t
+swap_items1(const unsigned char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++, src += 5) {
+        if (read_uint32(src) != 1) {
+            break;
+        }
+        dest[i] = (src[4] != 0);
+    }
+    return i;
+}
+
+
+static Py_ssize_t
+swap_items2(const unsigned char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    poque_uint16 val;
+
+    for (i = 0; i < n; i++, src += 6) {
+        if (read_uint32(src) != 2) {
+            break;
+        }
+        val = read_uint16(src + 4);
+        memcpy(dest + i * 2, &val, 2);
+    }
+    return i;
+}
+
+
+static Py_ssize_t
+swap_items4_scalar(const unsigned char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    PY_UINT32_T val;
+
+    for (i = 0; i < n; i++, src += 8) {
+        if (read_uint32(src) != 4) {
+            break;
+        }
+        val = read_uint32(src + 4);
+        memcpy(dest + i * 4, &val, 4);
+    }
+    return i;
+}
+
+
+static Py_ssize_t
+swap_items8(const unsigned char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    PY_UINT64_T val;
+
+    for (i = 0; i < n; i++, src += 12) {
+        if (read_uint32(src) != 8) {
+            break;
+        }
+        val = read_uint64(src + 4);
+        memcpy(dest + i * 8, &val, 8);
+    }
+    return i;
+}
+
+
+#ifdef POQUE_SWAP_SIMD
+
+__attribute__((target("ssse3")))
+static Py_ssize_t
+swap_items4_ssse3(const unsigned char *src, Py_ssize_t n, char *dest)
+{
+    /* four items of 8 bytes (length and value) into 16 bytes per iteration
+     */
+    const __m128i shuffle = _mm_setr_epi8(
+        7, 6, 5, 4, 15, 14, 13, 12, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i length = _mm_set1_epi32(0x04000000);
+    Py_ssize_t i = 0;
+
+    for (; i + 4 <= n; i += 4, src += 32) {
+        __m128i a, b;
+        int valid;
+
+        a = _mm_loadu_si128((const __m128i *)src);
+        b = _mm_loadu_si128((const __m128i *)(src + 16));
+
+        /* the length words are in the even lanes */
+        valid = _mm_movemask_ps(_mm_castsi128_ps(
+            _mm_cmpeq_epi32(a, length))) & _mm_movemask_ps(
+            _mm_castsi128_ps(_mm_cmpeq_epi32(b, length)));
+        if ((valid & 5) != 5) {
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(dest + i * 4), _mm_unpacklo_epi64(
+            _mm_shuffle_epi8(a, shuffle), _mm_shuffle_epi8(b, shuffle)));
+    }
+    return i + swap_items4_scalar(src, n - i, dest + i * 4);
+}
+
+
+#endif
+
+static swap_kernel swap_items4 = swap_items4_scalar;
+
+
+PyObject *
+array_buffer_binval(char *data, int len, int ndim, PY_INT32_T *dims,
+                    const ArrayItemType *item_type)
+{
+    /* Creates an ArrayBuffer from the items of a binary array value without
+     * NULLs. data is positioned after the dimensions.
+     */
+    PoqueArrayBuffer *buf;
+    Py_ssize_t shape[ARRAY_MAXDIM], n, done;
+    PY_INT64_T total = 1;
+    int i, itemsize = item_type->itemsize;
+
+    if (ndim == 0) {
+        /* empty array */
+        ndim = 1;
+        shape[0] = 0;
+        total = 0;
+    }
+    else {
+        for (i = 0; i < ndim; i++) {
+            shape[i] = dims[i];
+            total *= dims[i];
+            /* anything larger than a value can hold will do, this keeps the
+             * product from overflowing */
+            if (total > INT_MAX) {
+                total = (PY_INT64_T)INT_MAX + 1;
+            }
+        }
+    }
+    if (len != total * (4 + itemsize)) {
+        PyErr_SetString(PoqueError, "Invalid data format");
+        return NULL;
+    }
+    n = (Py_ssize_t)total;
+    buf = ArrayBuffer_New(item_type->format, itemsize, ndim, shape);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    switch (itemsize) {
+    case 1:
+        done = swap_items1((unsigned char *)data, n, ArrayBuffer_DATA(buf));
+        break;
+    case 2:
+        done = swap_items2((unsigned char *)data, n, ArrayBuffer_DATA(buf));
+        break;
+    case 4:
+        done = swap_items4((unsigned char *)data, n, ArrayBuffer_DATA(buf));
+        break;
+    default:
+        done = swap_items8((unsigned char *)data, n, ArrayBuffer_DATA(buf));
+    }
+    if (done != n) {
+        Py_DECREF(buf);
+        PyErr_SetString(PoqueError, "Invalid length");
+        return NULL;
+    }
+    return (PyObject *)buf;
+}
+
+
+/* ==== packed values ====================================================== */
+
+/* Swaps the byte order of n packed 4 byte items, in either direction. Used
+ * for values that hold their items without a length per item, like pgvector
+ * values.
+ */
+
+static void
+swap_packed4_scalar(const char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    PY_UINT32_T val;
+
+    for (i = 0; i < n; i++) {
+        val = read_uint32(src + i * 4);
+        memcpy(dest + i * 4, &val, 4);
+    }
+}
+
+
+#ifdef POQUE_SWAP_SIMD
+
+__attribute__((target("ssse3")))
+static void
+swap_packed4_ssse3(const char *src, Py_ssize_t n, char *dest)
+{
+    const __m128i shuffle = _mm_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    Py_ssize_t i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i *)(dest + i * 4), _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *)(src + i * 4)), shuffle));
+    }
+    swap_packed4_scalar(src + i * 4, n - i, dest + i * 4);
+}
+
+#endif
+
+static void (*swap_packed4_kernel)(const char *, Py_ssize_t, char *) =
+    swap_packed4_scalar;
+
+
+void
+swap_packed4(const char *src, Py_ssize_t n, char *dest)
+{
+    swap_packed4_kernel(src, n, dest);
+}
+
+
+/* ==== MaskedArray ======================================================== */
+
+/* Wraps a buffer of values with a mask to send an array parameter with NULLs.
+ * The mask holds a byte per item, a nonzero byte makes the item NULL.
+ */
+typedef struct {
+    PyObject_HEAD
+    PyObject *values;
+    PyObject *mask;
+} PoqueMaskedArray;
+
+
+static PyObject *
+MaskedArray_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"values", "mask", NULL};
+    PyObject *values, *mask;
+    PoqueMaskedArray *self;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "OO", kwlist, &values, &mask)) {
+        return NULL;
+    }
+    if (!PyObject_CheckBuffer(values) || !PyObject_CheckBuffer(mask)) {
+        PyErr_SetString(
+            PyExc_TypeError, "values and mask must support the buffer protocol");
+        return NULL;
+    }
+    self = (PoqueMaskedArray *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    Py_INCREF(values);
+    self->values = values;
+    Py_INCREF(mask);
+    self->mask = mask;
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+MaskedArray_repr(PoqueMaskedArray *self)
+{
+    return PyUnicode_FromFormat(
+        "MaskedArray(%R, %R)", self->values, self->mask);
+}
+
+
+static int
+MaskedArray_traverse(PoqueMaskedArray *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->values);
+    Py_VISIT(self->mask);
+    return 0;
+}
+
+
+static int
+MaskedArray_clear(PoqueMaskedArray *self)
+{
+    Py_CLEAR(self->values);
+    Py_CLEAR(self->mask);
+    return 0;
+}
+
+
+static void
+MaskedArray_dealloc(PoqueMaskedArray *self)
+{
+    PyObject_GC_UnTrack(self);
+    MaskedArray_clear(self);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+static PyMemberDef MaskedArray_members[] = {
+    {"values", T_OBJECT, offsetof(PoqueMaskedArray, values), READONLY,
+     "buffer with the items"},
+    {"mask", T_OBJECT, offsetof(PoqueMaskedArray, mask), READONLY,
+     "buffer with a byte per item, nonzero for NULL"},
+    {NULL}  /* Sentinel */
+};
+
+
+PyTypeObject PoqueMaskedArrayType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.MaskedArray",                        /* tp_name */
+    sizeof(PoqueMaskedArray),                   /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)MaskedArray_dealloc,            /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)MaskedArray_repr,                 /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "Wraps a buffer and a NULL mask to send as array",  /* tp_doc */
+    (traverseproc)MaskedArray_traverse,         /* tp_traverse */
+    (inquiry)MaskedArray_clear,                 /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    MaskedArray_members,                        /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    MaskedArray_new,                            /* tp_new */
+};
+
+
+/* ==== binary array parameters ============================================ */
+
+/* The reverse of the value kernels: a kernel writes n native items as a
+ * binary array, every item preceded by its length. The SSSE3 kernel turns
+ * four 4 byte items into 32 bytes of output per iteration.
+ */
+
+typedef void (*write_kernel)(const char *src, Py_ssize_t n, char *dest);
+
+
+static void
+write_items1(const char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++, dest += 5) {
+        put_uint32(dest, 1);
+        dest[4] = src[i];
+    }
+}
+
+
+static void
+write_items2(const char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    poque_uint16 val;
+
+    for (i = 0; i < n; i++, dest += 6) {
+        put_uint32(dest, 2);
+        memcpy(&val, src + i * 2, 2);
+        put_uint16(dest + 4, val);
+    }
+}
+
+
+static void
+write_items4_scalar(const char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    PY_UINT32_T val;
+
+    for (i = 0; i < n; i++, dest += 8) {
+        put_uint32(dest, 4);
+        memcpy(&val, src + i * 4, 4);
+        put_uint32(dest + 4, val);
+    }
+}
+
+
+static void
+write_items8(const char *src, Py_ssize_t n, char *dest)
+{
+    Py_ssize_t i;
+    PY_UINT64_T val;
+
+    for (i = 0; i < n; i++, dest += 12) {
+        put_uint32(dest, 8);
+        memcpy(&val, src + i * 8, 8);
+        put_uint64(dest + 4, val);
+    }
+}
+
+
+#ifdef POQUE_SWAP_SIMD
+
+__attribute__((target("ssse3")))
+static void
+write_items4_ssse3(const char *src, Py_ssize_t n, char *dest)
+{
+    const __m128i lo = _mm_setr_epi8(
+        -1, -1, -1, -1, 3, 2, 1, 0, -1, -1, -1, -1, 7, 6, 5, 4);
+    const __m128i hi = _mm_setr_epi8(
+        -1, -1, -1, -1, 11, 10, 9, 8, -1, -1, -1, -1, 15, 14, 13, 12);
+    const __m128i length = _mm_set1_epi64x(0x04000000);
+    Py_ssize_t i = 0;
+
+    for (; i + 4 <= n; i += 4, dest += 32) {
+        __m128i a;
+
+        a = _mm_loadu_si128((const __m128i *)(src + i * 4));
+        _mm_storeu_si128((__m128i *)dest,
+                         _mm_or_si128(_mm_shuffle_epi8(a, lo), length));
+        _mm_storeu_si128((__m128i *)(dest + 16),
+                         _mm_or_si128(_mm_shuffle_epi8(a, hi), length));
+    }
+    write_items4_scalar(src + i * 4, n - i, dest);
+}
+
+#endif
+
+static write_kernel write_items4 = write_items4_scalar;
+
+
+static void
+write_items_ordered(const char *src, Py_ssize_t n, char *dest, int itemsize)
+{
+    /* for items that are already in network order */
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++) {
+        write_uint32(&dest, itemsize);
+        memcpy(dest, src + i * itemsize, itemsize);
+        dest += itemsize;
+    }
+}
+
+
+static const ArrayItemType *
+buffer_item_type(const char *format, Py_ssize_t itemsize, int *native)
+{
+    /* Maps a struct module format to an item type. Integer formats map to
+     * the pg integer of the same size.
+     */
+    const ArrayItemType *item_type;
+    char code;
+
+    *native = 1;
+    if (format == NULL) {
+        /* unsigned bytes */
+        return NULL;
+    }
+    switch (*format) {
+    case '@':
+    case '=':
+        format++;
+        break;
+    case '<':
+#if !PY_LITTLE_ENDIAN
+        return NULL;
+#endif
+        format++;
+        break;
+    case '>':
+    case '!':
+        /* already in network order */
+        *native = 0;
+        format++;
+        break;
+    }
+    if (format[0] == '\0' || format[1] != '\0') {
+        return NULL;
+    }
+    switch (format[0]) {
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+    case 'n':
+        code = itemsize == 2 ? 'h' : itemsize == 4 ? 'i' : 'q';
+        break;
+    case 'I':
+    case 'L':
+        code = 'I';
+        break;
+    case 'f':
+    case 'd':
+    case '?':
+        code = format[0];
+        break;
+    default:
+        return NULL;
+    }
+    for (item_type = item_types; item_type->handler; item_type++) {
+        if (item_type->format[0] == code) {
+            return item_type->itemsize == itemsize ? item_type : NULL;
+        }
+    }
+    return NULL;
+}
+
+
+static int
+is_byte_format(const char *format, Py_ssize_t itemsize)
+{
+    /* bytes like buffers are sent as bytea */
+    if (itemsize != 1) {
+        return 0;
+    }
+    if (format == NULL) {
+        return 1;
+    }
+    if (*format == '@' || *format == '=' || *format == '<' ||
+            *format == '>' || *format == '!') {
+        format++;
+    }
+    return ((format[0] == 'B' || format[0] == 'b' || format[0] == 'c') &&
+            format[1] == '\0');
+}
+
+
+typedef struct {
+    Py_buffer values;
+    Py_buffer mask;
+    const ArrayItemType *item_type;     /* NULL for bytea */
+    int native;             /* items are in native byte order */
+    int has_null;
+    int size;               /* encoded size */
+} BufferParam;
+
+
+typedef struct {
+    param_handler handler;
+    int num_params;
+    int examine_pos;
+    int encode_pos;
+    char *data;             /* encoded array value */
+    BufferParam params[];
+} BufferParamHandler;
+
+
+static int
+buffer_examine_array(BufferParam *bp, PyObject *mask)
+{
+    Py_buffer *view = &bp->values;
+    const char *m;
+    Py_ssize_t i, n, num_null = 0;
+    PY_INT64_T size;
+
+    if (view->ndim == 0 || view->ndim > ARRAY_MAXDIM) {
+        PyErr_SetString(PyExc_ValueError, "Invalid number of dimensions");
+        return -1;
+    }
+    n = view->len / view->itemsize;
+
+    if (mask) {
+        if (PyObject_GetBuffer(mask, &bp->mask, PyBUF_C_CONTIGUOUS) < 0) {
+            return -1;
+        }
+        if (bp->mask.itemsize != 1 || bp->mask.len != n) {
+            PyErr_SetString(
+                PyExc_ValueError, "Mask must have a byte for every item");
+            return -1;
+        }
+        m = bp->mask.buf;
+        for (i = 0; i < n; i++) {
+            num_null += (m[i] != 0);
+        }
+        bp->has_null = (num_null != 0);
+    }
+
+    /* header, dimensions, a length per item and the non NULL items */
+    size = 12 + (n ? view->ndim * 8 : 0) +
+        (PY_INT64_T)n * 4 + (PY_INT64_T)(n - num_null) * view->itemsize;
+    if (size > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Array too large");
+        return -1;
+    }
+    return (int)size;
+}
+
+
+static int
+buffer_examine(BufferParamHandler *handler, PyObject *param)
+{
+    PyObject *values = param, *mask = NULL;
+    BufferParam *bp;
+    Py_buffer *view;
+
+    bp = current_examine_param(handler);
+    bp->values.obj = NULL;
+    bp->mask.obj = NULL;
+    bp->has_null = 0;
+    view = &bp->values;
+
+    if (Py_TYPE(param) == &PoqueMaskedArrayType) {
+        values = ((PoqueMaskedArray *)param)->values;
+        mask = ((PoqueMaskedArray *)param)->mask;
+    }
+    if (PyObject_GetBuffer(
+            values, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        return -1;
+    }
+
+    if (mask == NULL && is_byte_format(view->format, view->itemsize)) {
+        /* bytea, the value is sent straight from the buffer */
+        if (handler->examine_pos > 1 && handler->handler.oid != BYTEAOID) {
+            PyErr_SetString(PyExc_ValueError, "Can not mix types");
+            return -1;
+        }
+        if (view->len > INT_MAX) {
+            PyErr_SetString(PyExc_ValueError,
+                            "Size of bytes value is too large");
+            return -1;
+        }
+        bp->item_type = NULL;
+        bp->size = (int)view->len;
+        handler->handler.oid = BYTEAOID;
+        handler->handler.array_oid = BYTEAARRAYOID;
+        return bp->size;
+    }
+
+    /* array of fixed width items */
+    if (handler->examine_pos > 1) {
+        /* buffers are arrays, an array of them is not supported */
+        PyErr_SetString(PyExc_ValueError, "Can not nest buffers");
+        return -1;
+    }
+    bp->item_type = buffer_item_type(view->format, view->itemsize,
+                                     &bp->native);
+    if (bp->item_type == NULL) {
+        PyErr_Format(PyExc_ValueError, "Unsupported buffer format '%s'",
+                     view->format ? view->format : "B");
+        return -1;
+    }
+    bp->size = buffer_examine_array(bp, mask);
+    handler->handler.oid = bp->item_type->array_oid;
+    handler->handler.array_oid = InvalidOid;
+    return bp->size;
+}
+
+
+static void
+buffer_write_items(BufferParam *bp, const char *src, Py_ssize_t n, char *dest)
+{
+    int itemsize = bp->item_type->itemsize;
+
+    if (!bp->native) {
+        write_items_ordered(src, n, dest, itemsize);
+        return;
+    }
+    switch (itemsize) {
+    case 1:
+        write_items1(src, n, dest);
+        break;
+    case 2:
+        write_items2(src, n, dest);
+        break;
+    case 4:
+        write_items4(src, n, dest);
+        break;
+    default:
+        write_items8(src, n, dest);
+    }
+}
+
+
+static void
+buffer_write_array(BufferParam *bp, char *loc)
+{
+    Py_buffer *view = &bp->values;
+    const char *src = view->buf, *mask = bp->mask.buf;
+    Py_ssize_t i, j, n;
+    int itemsize = (int)view->itemsize;
+
+    n = view->len / itemsize;
+
+    /* write array header, an empty array has no dimensions */
+    write_uint32(&loc, n ? view->ndim : 0);
+    write_uint32(&loc, bp->has_null);
+    write_uint32(&loc, bp->item_type->oid);
+    if (n) {
+        for (i = 0; i < view->ndim; i++) {
+            write_uint32(&loc, (PY_UINT32_T)view->shape[i]);
+            write_uint32(&loc, 1);
+        }
+    }
+
+    if (!bp->has_null) {
+        buffer_write_items(bp, src, n, loc);
+        return;
+    }
+
+    /* write the runs of non NULL items in between the NULLs */
+    i = 0;
+    while (i < n) {
+        if (mask[i]) {
+            write_uint32(&loc, -1);
+            i++;
+            continue;
+        }
+        for (j = i + 1; j < n && !mask[j]; j++);
+        buffer_write_items(bp, src + i * itemsize, j - i, loc);
+        loc += (j - i) * (4 + itemsize);
+        i = j;
+    }
+}
+
+
+static int
+buffer_encode(BufferParamHandler *handler, PyObject *param, char **loc)
+{
+    BufferParam *bp;
+
+    bp = current_encode_param(handler);
+    if (bp->item_type == NULL) {
+        /* point libpq to the buffer itself */
+        *loc = bp->size ? bp->values.buf : (char *)"";
+        return 0;
+    }
+    handler->data = PyMem_Malloc(bp->size);
+    if (handler->data == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    buffer_write_array(bp, handler->data);
+    *loc = handler->data;
+    return 0;
+}
+
+
+static int
+buffer_encode_at(BufferParamHandler *handler, PyObject *param, char *loc)
+{
+    BufferParam *bp;
+
+    bp = current_encode_param(handler);
+    if (bp->item_type == NULL) {
+        memcpy(loc, bp->values.buf, bp->size);
+    }
+    else {
+        buffer_write_array(bp, loc);
+    }
+    return bp->size;
+}
+
+
+static void
+buffer_free(BufferParamHandler *handler)
+{
+    BufferParam *bp;
+    int i;
+
+    for (i = 0; i < handler->examine_pos; i++) {
+        bp = &handler->params[i];
+        if (bp->values.obj) {
+            PyBuffer_Release(&bp->values);
+        }
+        if (bp->mask.obj) {
+            PyBuffer_Release(&bp->mask);
+        }
+    }
+    PyMem_Free(handler->data);
+    PyMem_Free(handler);
+}
+
+
+param_handler *
+new_buffer_param_handler(int num_params)
+{
+    /* Parameter handler for objects that support the buffer protocol. Bytes
+     * like buffers are sent as bytea, straight from the buffer. Others are
+     * sent as a binary array of the matching fixed width type.
+     *
+     * The buffers are held until the handler is freed.
+     */
+    static BufferParamHandler def_handler = {{
+            (ph_examine)buffer_examine,     /* examine */
+            NULL,                           /* total_size */
+            (ph_encode)buffer_encode,       /* encode */
+            (ph_encode_at)buffer_encode_at, /* encode_at */
+            (ph_free)buffer_free,           /* free */
+            InvalidOid,                     /* oid */
+            InvalidOid                      /* array oid */
+        },
+        0,                                  /* num_params */
+        0,                                  /* examine_pos */
+        0,                                  /* encode_pos */
+        NULL                                /* data */
+    }; /* static initialized handler */
+
+    return new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(BufferParamHandler),
+        num_params, sizeof(BufferParam));
+}
+
+
+int
+init_buffer(void)
+{
+    PyTypeObject *array_type, *mmap_type;
+
+#ifdef POQUE_SWAP_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("ssse3")) {
+        swap_items4 = swap_items4_ssse3;
+        write_items4 = write_items4_ssse3;
+        swap_packed4_kernel = swap_packed4_ssse3;
+    }
+#endif
+    array_type = load_python_type("array", "array");
+    if (array_type == NULL) {
+        return -1;
+    }
+    mmap_type = load_python_type("mmap", "mmap");
+    if (mmap_type == NULL) {
+        return -1;
+    }
+    register_parameter_handler(array_type, new_buffer_param_handler);
+    register_parameter_handler(mmap_type, new_buffer_param_handler);
+    register_parameter_handler(&PyByteArray_Type, new_buffer_param_handler);
+    register_parameter_handler(&PyMemoryView_Type, new_buffer_param_handler);
+    register_parameter_handler(
+        &PoqueArrayBufferType, new_buffer_param_handler);
+    register_parameter_handler(
+        &PoqueMaskedArrayType, new_buffer_param_handler);
+    return 0;
+}
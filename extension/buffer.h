@@ -0,0 +1,40 @@
+#ifndef _POQUE_BUFFER_H_
+#define _POQUE_BUFFER_H_
+
+#include "poque_type.h"
+
+/* An ArrayBuffer holds the items of an array of a fixed width type in native
+ * byte order and exposes them through the buffer protocol.
+ */
+typedef struct {
+    PyObject_VAR_HEAD           /* ob_size is the number of bytes */
+    Py_ssize_t shape[ARRAY_MAXDIM];
+    Py_ssize_t strides[ARRAY_MAXDIM];
+    int ndim;
+    int itemsize;
+    char format[4];             /* struct module format of an item */
+    PY_INT64_T data[1];         /* aligned for any item type */
+} PoqueArrayBuffer;
+
+#define ArrayBuffer_DATA(o) ((char *)((PoqueArrayBuffer *)(o))->data)
+
+/* fixed width pg type that can be held in an ArrayBuffer */
+typedef struct {
+    PoqueValueHandler *handler;
+    const char *format;
+    int itemsize;
+    Oid oid;
+    Oid array_oid;
+} ArrayItemType;
+
+int init_buffer(void);
+
+PoqueArrayBuffer *ArrayBuffer_New(
+    const char *format, int itemsize, int ndim, Py_ssize_t *shape);
+const ArrayItemType *array_item_type(PoqueValueHandler *el_handler);
+param_handler *new_buffer_param_handler(int num_param);
+PyObject *array_buffer_binval(char *data, int len, int ndim, PY_INT32_T *dims,
+                              const ArrayItemType *item_type);
+void swap_packed4(const char *src, Py_ssize_t n, char *dest);
+
+#endif
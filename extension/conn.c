@@ -2,6 +2,10 @@
 
 #include "poque.h"
 #include "poque_type.h"
+#include "text.h"
+#include "encoded.h"
+#include "hstore.h"
+#include "vector.h"
 
 
 static void Conn_set_error(PGconn *conn) {
@@ -203,10 +207,14 @@ Conn_fileno(PoqueConn *self, PyObject *unused)
 
 static inline int
 text_encode(PyObject *param, char **pg_param, int *len) {
+    /* Encodes a str parameter. Returns 1 if memory was allocated for the
+     * value, 0 if the value points to the data of an ASCII str.
+     */
+    const char *direct;
     Py_ssize_t size;
 
-    *pg_param = PyUnicode_AsUTF8AndSize(param, &size);
-    if (*pg_param == NULL) {
+    size = text_utf8_size(param, &direct);
+    if (size < 0) {
         return -1;
     }
 #if SIZEOF_SIZE_T > SIZEOF_INT
@@ -217,7 +225,17 @@ text_encode(PyObject *param, char **pg_param, int *len) {
     }
 #endif
     *len = (int)size;
-    return 0;
+    if (direct) {
+        *pg_param = (char *)direct;
+        return 0;
+    }
+    *pg_param = PyMem_Malloc(size);
+    if (*pg_param == NULL) {
+        PyErr_SetNone(PyExc_MemoryError);
+        return -1;
+    }
+    text_utf8_write(param, *pg_param);
+    return 1;
 }
 
 static int
@@ -363,10 +381,147 @@ bytes_encode(PyObject *param, char **pg_param, int *len) {
 }
 
 
+static PGresult *
+Conn_exec_params_after(
+    PGconn *conn, const char *before, const char *sql, int num_params,
+    const Oid *param_types, const char * const *param_values,
+    const int *param_lengths, const int *param_formats, int format)
+{
+    /* Executes a parameterized statement. When a parameterless statement to
+     * execute before it is given, both are sent in a single network write
+     * using pipeline mode. The result of the statement is returned, unless
+     * the one before failed. Called without holding the GIL.
+     */
+#ifdef LIBPQ_HAS_PIPELINING
+    PGresult *res, *before_res = NULL, *stmt_res = NULL, *send_error = NULL;
+    ExecStatusType res_status;
+    int query = 0, num_queries = 2;
+
+    if (before == NULL) {
+        return PQexecParams(conn, sql, num_params, param_types, param_values,
+                            param_lengths, param_formats, format);
+    }
+    if (!PQenterPipelineMode(conn)) {
+        return NULL;
+    }
+    if (!PQsendQueryParams(
+            conn, before, 0, NULL, NULL, NULL, NULL, FORMAT_TEXT)) {
+        /* nothing is queued, so leaving pipeline mode can not fail */
+        PQexitPipelineMode(conn);
+        return NULL;
+    }
+    if (!PQsendQueryParams(conn, sql, num_params, param_types, param_values,
+                           param_lengths, param_formats, format)) {
+        /* The statement before is still synced and read, that can replace
+         * the error message, so it is kept in a result.
+         */
+        send_error = PQmakeEmptyPGresult(conn, PGRES_FATAL_ERROR);
+        num_queries = 1;
+    }
+
+    /* Without the sync the queued statements never complete, and the
+     * connection stays in pipeline mode. The caller handles that.
+     */
+    if (!PQpipelineSync(conn)) {
+        PQclear(send_error);
+        return NULL;
+    }
+
+    /* Results are read until the sync, each query ends with a NULL result */
+    for (;;) {
+        res = PQgetResult(conn);
+        if (res == NULL) {
+            if (++query > num_queries) {
+                break;
+            }
+            continue;
+        }
+        res_status = PQresultStatus(res);
+        if (res_status == PGRES_PIPELINE_SYNC) {
+            PQclear(res);
+            break;
+        }
+        if (query == 0 && before_res == NULL) {
+            before_res = res;
+        }
+        else if (query == 1 && stmt_res == NULL) {
+            stmt_res = res;
+        }
+        else {
+            PQclear(res);
+        }
+    }
+    if (!PQexitPipelineMode(conn)) {
+        PQclear(before_res);
+        PQclear(stmt_res);
+        PQclear(send_error);
+        return NULL;
+    }
+
+    if (before_res == NULL) {
+        PQclear(stmt_res);
+        PQclear(send_error);
+        return NULL;
+    }
+    res_status = PQresultStatus(before_res);
+    if (res_status == PGRES_FATAL_ERROR || res_status == PGRES_BAD_RESPONSE) {
+        PQclear(stmt_res);
+        PQclear(send_error);
+        return before_res;
+    }
+    PQclear(before_res);
+    if (num_queries == 1) {
+        /* NULL when out of memory, the error message tells */
+        return send_error;
+    }
+    return stmt_res;
+#else
+    PGresult *res;
+
+    if (before != NULL) {
+        ExecStatusType res_status;
+
+        /* no pipelining available, execute it separately */
+        res = PQexec(conn, before);
+        res_status = PQresultStatus(res);
+        if (res == NULL || res_status == PGRES_BAD_RESPONSE ||
+                res_status == PGRES_FATAL_ERROR) {
+            return res;
+        }
+        PQclear(res);
+    }
+    return PQexecParams(conn, sql, num_params, param_types, param_values,
+                        param_lengths, param_formats, format);
+#endif
+}
+
+
+param_handler *
+_Conn_param_handler(PoqueConn *self, PyObject *param)
+{
+    /* Gets the parameter handler for a value. Dicts, also in lists, are
+     * hstore values once that type is registered. Vectors get the registered
+     * pgvector oids.
+     */
+    if (self->hstore_oid != InvalidOid && PyDict_Check(param)) {
+        return new_hstore_param_handler(
+            self->hstore_oid, self->hstore_array_oid);
+    }
+    if (self->hstore_oid != InvalidOid && PyList_CheckExact(param)) {
+        return new_hstore_array_param_handler(
+            self->hstore_oid, self->hstore_array_oid);
+    }
+    if (Py_TYPE(param) == &PoqueVectorType) {
+        return new_vector_param_handler(self->vector_oid, self->halfvec_oid);
+    }
+    return get_param_handler_constructor(Py_TYPE(param))(1);
+}
+
+
 static PGresult *
 Conn_exec_params(
-    PoqueConn *self, PyObject *command, PyObject *parameters,
-    Py_ssize_t num_params, int format)
+    PoqueConn *self, const char *before, PyObject *command,
+    PyObject *parameters, Py_ssize_t num_params, int format)
 {
     param_handler **param_handlers=NULL;
 	Oid *param_types=NULL, param_type;
@@ -387,7 +542,10 @@ Conn_exec_params(
     ExecStatusType res_status;
 
 	same = 0;
-	if (num_params == self->last_oids_len && self->last_command) {
+	/* The statement before replaces the unnamed prepared statement, so it
+	 * can not be reused in that case. */
+	if (before == NULL && num_params == self->last_oids_len &&
+	        self->last_command) {
 	    int cmp = PyUnicode_Compare(self->last_command, command);
 	    if (cmp == 0) {
 	        same = 1;
@@ -448,9 +606,16 @@ Conn_exec_params(
                 clean_up[clean_up_count++] = param_values[i];
             }
             else if (PyUnicode_Check(param)) {
-                if (text_encode(param, &param_values[i], &param_lengths[i]) == -1) {
+                int allocated;
+
+                allocated = text_encode(
+                    param, &param_values[i], &param_lengths[i]);
+                if (allocated == -1) {
                     goto end;
                 }
+                if (allocated) {
+                    clean_up[clean_up_count++] = param_values[i];
+                }
                 param_type = TEXTOID;
             }
             else if (PyFloat_Check(param)) {
@@ -461,6 +626,15 @@ Conn_exec_params(
                 param_lengths[i] = 8;
                 clean_up[clean_up_count++] = param_values[i];
             }
+            else if (Py_TYPE(param) == &PoqueEncodedType) {
+                /* already encoded, send as is */
+                PoqueEncoded *enc = (PoqueEncoded *)param;
+
+                param_values[i] = enc->data;
+                param_lengths[i] = Encoded_SIZE(enc);
+                param_formats[i] = enc->format;
+                param_type = enc->oid;
+            }
             else if (PyBytes_Check(param)) {
                 if (bytes_encode(
                         param, &param_values[i], &param_lengths[i]) == -1) {
@@ -473,7 +647,7 @@ Conn_exec_params(
                 param_handler *handler;
 
                 /* get the parameter handler based on type */
-                handler = get_param_handler_constructor(Py_TYPE(param))(1);
+                handler = _Conn_param_handler(self, param);
                 if (handler == NULL) {
                     goto end;
                 }
@@ -575,9 +749,10 @@ Conn_exec_params(
         }
 
         Py_BEGIN_ALLOW_THREADS
-        res = PQexecParams(self->conn, sql, (int)num_params, param_types,
-                           (const char * const*)param_values, param_lengths,
-                           param_formats, format);
+        res = Conn_exec_params_after(
+            self->conn, before, sql, (int)num_params, param_types,
+            (const char * const*)param_values, param_lengths, param_formats,
+            format);
         Py_END_ALLOW_THREADS
 
         res_status = PQresultStatus(res);
@@ -595,6 +770,13 @@ Conn_exec_params(
 	}
     if (res == NULL) {
         Conn_set_error(self->conn);
+#ifdef LIBPQ_HAS_PIPELINING
+        if (PQpipelineStatus(self->conn) != PQ_PIPELINE_OFF) {
+            /* stuck in pipeline mode, the connection is of no use anymore */
+            PQfinish(self->conn);
+            self->conn = NULL;
+        }
+#endif
     }
 
 end:
@@ -633,14 +815,260 @@ Conn_execute(PoqueConn *self, PyObject *args, PyObject *kwds) {
 
 #define PG_UTF8 6
 
+static int
+Conn_check_result(PoqueConn *self, PGresult *res) {
+    /* Raises an error for failed results and wrong client encodings. The
+     * result is left untouched, the caller should clear it on failure.
+     */
+    ExecStatusType res_status;
+
+    if (PQclientEncoding(self->conn) != PG_UTF8) {
+        PyErr_SetString(PoqueError, "Invalid client encoding, must be UTF-8");
+        return -1;
+    }
+
+    res_status = PQresultStatus(res);
+    if (res_status == PGRES_BAD_RESPONSE || res_status == PGRES_FATAL_ERROR) {
+        PyErr_SetString(PoqueError, PQresultErrorMessage(res));
+        return -1;
+    }
+    return 0;
+}
+
+
+static int
+Conn_send_query(PoqueConn *self, const char *before, PyObject *command) {
+    /* Sends a statement using the simple protocol. The statement can contain
+     * multiple commands, each returning its own result.
+     *
+     * A BEGIN to execute before the statement is sent along in the same
+     * query string. Returns 1 in that case, because its result comes first.
+     * The server parses a query string as a whole, so a syntax error in the
+     * statement drops the BEGIN too, which loses nothing. A COMMIT or
+     * ROLLBACK must not be dropped like that, so those are executed on their
+     * own first. Returns -1 on failure, 0 otherwise.
+     */
+    const char *sql;
+    char *query = NULL;
+    Py_ssize_t sql_len;
+    PGresult *res;
+    int ok, ret = 0;
+
+    sql = PyUnicode_AsUTF8AndSize(command, &sql_len);
+    if (sql == NULL) {
+        return -1;
+    }
+    if (self->last_command) {
+        Py_CLEAR(self->last_command);
+        PyMem_Free(self->last_oids);
+        self->last_oids = NULL;
+        self->last_oids_len = 0;
+    }
+    if (before != NULL && strcmp(before, "BEGIN") == 0) {
+        size_t before_len = strlen(before);
+
+        query = PyMem_Malloc(before_len + sql_len + 2);
+        if (query == NULL) {
+            PyErr_SetNone(PyExc_MemoryError);
+            return -1;
+        }
+        memcpy(query, before, before_len);
+        query[before_len] = ';';
+        memcpy(query + before_len + 1, sql, sql_len + 1);
+        sql = query;
+        ret = 1;
+    }
+    else if (before != NULL) {
+        Py_BEGIN_ALLOW_THREADS
+        res = PQexec(self->conn, before);
+        Py_END_ALLOW_THREADS
+        if (res == NULL) {
+            Conn_set_error(self->conn);
+            return -1;
+        }
+        ok = (Conn_check_result(self, res) == 0);
+        PQclear(res);
+        if (!ok) {
+            return -1;
+        }
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ok = PQsendQuery(self->conn, sql);
+    Py_END_ALLOW_THREADS
+    PyMem_Free(query);
+    if (!ok) {
+        Conn_set_error(self->conn);
+        return -1;
+    }
+    return ret;
+}
+
+
+static PGresult *
+Conn_get_result(PoqueConn *self) {
+    PGresult *res;
+
+    Py_BEGIN_ALLOW_THREADS
+    res = PQgetResult(self->conn);
+    Py_END_ALLOW_THREADS
+    return res;
+}
+
+
+static inline int
+Conn_result_ends_query(PGresult *res) {
+    /* Copy results keep on coming back until the copy is handled, so these
+     * end the result loop, just like PQexec does.
+     */
+    ExecStatusType res_status = PQresultStatus(res);
+
+    return (res_status == PGRES_COPY_IN || res_status == PGRES_COPY_OUT ||
+            res_status == PGRES_COPY_BOTH);
+}
+
+
+static PGresult *
+Conn_exec_simple(PoqueConn *self, const char *before, PyObject *command) {
+    /* Executes the statement and returns the last result. An error result
+     * takes precedence, because the server stops after a failing command.
+     */
+    PGresult *res, *last_res = NULL, *before_res = NULL;
+    int is_before;
+
+    is_before = Conn_send_query(self, before, command);
+    if (is_before == -1) {
+        return NULL;
+    }
+    while ((res = Conn_get_result(self)) != NULL) {
+        if (is_before) {
+            /* The result of the command before is only kept for an empty
+             * statement, unless it failed. */
+            is_before = 0;
+            if (PQresultStatus(res) != PGRES_FATAL_ERROR) {
+                before_res = res;
+                continue;
+            }
+        }
+        if (last_res != NULL) {
+            if (PQresultStatus(last_res) == PGRES_FATAL_ERROR) {
+                PQclear(res);
+                continue;
+            }
+            PQclear(last_res);
+        }
+        last_res = res;
+        if (Conn_result_ends_query(res)) {
+            break;
+        }
+    }
+    if (last_res == NULL) {
+        last_res = before_res;
+    }
+    else {
+        PQclear(before_res);
+    }
+    if (last_res == NULL) {
+        Conn_set_error(self->conn);
+    }
+    return last_res;
+}
+
+
+static int
+Conn_append_result(PoqueConn *self, PyObject *results, PGresult *res) {
+    PoqueResult *result;
+    int ret;
+
+    if (Conn_check_result(self, res) == -1) {
+        PQclear(res);
+        return -1;
+    }
+    result = PoqueResult_New(res, self);
+    if (result == NULL) {
+        PQclear(res);
+        return -1;
+    }
+    ret = PyList_Append(results, (PyObject *)result);
+    Py_DECREF(result);
+    return ret;
+}
+
+
+PyObject *
+_Conn_execute_multi(PoqueConn *self, const char *before, PyObject *command) {
+    /* Executes the statement and returns a list with a PoqueResult for every
+     * command in it. The result of the command before is left out.
+     */
+    PGresult *res, *before_res = NULL;
+    PyObject *results;
+    int failed = 0, is_before;
+
+    is_before = Conn_send_query(self, before, command);
+    if (is_before == -1) {
+        return NULL;
+    }
+    results = PyList_New(0);
+    if (results == NULL) {
+        failed = 1;
+    }
+
+    /* All results must be retrieved, even after a failure, to make the
+     * connection available for the next statement.
+     */
+    while ((res = Conn_get_result(self)) != NULL) {
+        int ends_query = Conn_result_ends_query(res);
+
+        if (is_before) {
+            /* The result of the command before is only kept for an empty
+             * statement, unless it failed. */
+            is_before = 0;
+            if (PQresultStatus(res) != PGRES_FATAL_ERROR) {
+                before_res = res;
+                continue;
+            }
+        }
+        if (failed) {
+            PQclear(res);
+        }
+        else {
+            failed = Conn_append_result(self, results, res) == -1;
+        }
+        if (ends_query) {
+            break;
+        }
+    }
+    if (before_res != NULL) {
+        if (!failed && PyList_GET_SIZE(results) == 0) {
+            failed = Conn_append_result(self, results, before_res) == -1;
+        }
+        else {
+            PQclear(before_res);
+        }
+    }
+    if (failed) {
+        Py_XDECREF(results);
+        return NULL;
+    }
+    if (PyList_GET_SIZE(results) == 0) {
+        Conn_set_error(self->conn);
+        Py_DECREF(results);
+        return NULL;
+    }
+    return results;
+}
+
+
 PGresult *
-_Conn_execute(
-        PoqueConn *self, PyObject *command, PyObject *parameters, int format) {
+_Conn_execute_after(
+        PoqueConn *self, const char *before, PyObject *command,
+        PyObject *parameters, int format) {
+    /* Executes a statement. The optional parameterless command before it,
+     * like a BEGIN, is sent along in the same network write.
+     */
 
     PGresult *res = NULL;
-    ExecStatusType res_status;
     Py_ssize_t num_params = 0;
-    char *sql;
 
     if (parameters != NULL) {
         parameters = PySequence_Fast(
@@ -657,44 +1085,96 @@ _Conn_execute(
 
     if (num_params == 0 && format == FORMAT_TEXT) {
         // Use simple protocol, less network traffic while sending
-        sql = PyUnicode_AsUTF8(command);
-        if (sql != NULL) {
-            if (self->last_command) {
-                Py_CLEAR(self->last_command);
-                PyMem_Free(self->last_oids);
-                self->last_oids = NULL;
-                self->last_oids_len = 0;
-            }
-
-            Py_BEGIN_ALLOW_THREADS
-            res = PQexec(self->conn, sql);
-            Py_END_ALLOW_THREADS
-            if (res == NULL) {
-                Conn_set_error(self->conn);
-            }
-        }
+        res = Conn_exec_simple(self, before, command);
     } else {
         // Use advanced protocol, capable of parameter binding and binary format
-    	res = Conn_exec_params(self, command, parameters, num_params, format);
+    	res = Conn_exec_params(
+    	    self, before, command, parameters, num_params, format);
     }
     Py_XDECREF(parameters);
 	if (res == NULL) {
         return NULL;
     }
 
-    if (PQclientEncoding(self->conn) != PG_UTF8) {
-        PyErr_SetString(PoqueError, "Invalid client encoding, must be UTF-8");
+    if (Conn_check_result(self, res) == -1) {
         PQclear(res);
         return NULL;
     }
+    return res;
+}
 
-    res_status = PQresultStatus(res);
-    if (res_status == PGRES_BAD_RESPONSE || res_status == PGRES_FATAL_ERROR) {
-        PyErr_SetString(PoqueError, PQresultErrorMessage(res));
-        PQclear(res);
+
+PGresult *
+_Conn_execute(
+        PoqueConn *self, PyObject *command, PyObject *parameters, int format) {
+    return _Conn_execute_after(self, NULL, command, parameters, format);
+}
+
+
+static PyObject *
+Conn_execute_multi(PoqueConn *self, PyObject *args, PyObject *kwds) {
+    PyObject *command;
+
+    static char *kwlist[] = {"command", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "U", kwlist, &command))
+        return NULL;
+    return _Conn_execute_multi(self, NULL, command);
+}
+
+
+static PyObject *
+Conn_end_transaction(
+        PoqueConn *self, PyObject *args, PyObject *kwds, const char *end) {
+    /* Ends the current transaction, if any. An optional statement is
+     * executed right after it, in the same network round trip.
+     */
+    PyObject *command = NULL, *parameters = NULL, *end_command;
+    const char *before = NULL;
+    int format = FORMAT_AUTO;
+    PGresult *res;
+
+    static char *kwlist[] = {"command", "parameters", "result_format", NULL};
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "|UOi", kwlist, &command, &parameters, &format))
         return NULL;
+
+    if (PQtransactionStatus(self->conn) != PQTRANS_IDLE) {
+        before = end;
     }
-    return res;
+    if (command != NULL) {
+        res = _Conn_execute_after(self, before, command, parameters, format);
+        if (res == NULL) {
+            return NULL;
+        }
+        return (PyObject *)PoqueResult_New(res, self);
+    }
+    if (before == NULL) {
+        Py_RETURN_NONE;
+    }
+
+    end_command = PyUnicode_FromString(end);
+    if (end_command == NULL) {
+        return NULL;
+    }
+    res = _Conn_execute(self, end_command, NULL, FORMAT_TEXT);
+    Py_DECREF(end_command);
+    if (res == NULL) {
+        return NULL;
+    }
+    PQclear(res);
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Conn_commit(PoqueConn *self, PyObject *args, PyObject *kwds) {
+    return Conn_end_transaction(self, args, kwds, "COMMIT");
+}
+
+
+static PyObject *
+Conn_rollback(PoqueConn *self, PyObject *args, PyObject *kwds) {
+    return Conn_end_transaction(self, args, kwds, "ROLLBACK");
 }
 
 
@@ -842,12 +1322,258 @@ Conn_escape_identifier(PoqueConn *self, PyObject *args, PyObject *kwds) {
 }
 
 
+static PyObject *
+Conn_encode(PoqueConn *self, PyObject *value) {
+    return Encoded_FromValue(value, self);
+}
+
+
+static PyObject *
+Conn_register_composite(PoqueConn *self, PyObject *args, PyObject *kwds) {
+    /* Loads the field names of a composite type once and registers a named
+     * tuple type for its values. Binary values of the type and of its array
+     * type are returned as named tuples in subsequent results.
+     */
+    PyObject *name, *command, *parameters, *names = NULL, *field_name;
+    PyObject *namedtuple = NULL, *nt_args = NULL, *nt_kwds = NULL;
+    PyObject *cls = NULL, *type_handlers;
+    PGresult *res;
+    Oid oid, array_oid;
+    int i, ntuples;
+    char *type_name;
+
+    static char *kwlist[] = {"name", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "U", kwlist, &name))
+        return NULL;
+
+    command = PyUnicode_FromString(
+        "SELECT t.oid, t.typarray, t.typname, a.attname "
+        "FROM pg_type t LEFT JOIN pg_attribute a "
+        "ON a.attrelid = t.typrelid AND a.attnum > 0 AND NOT a.attisdropped "
+        "WHERE t.oid = $1::regtype AND t.typtype = 'c' "
+        "ORDER BY a.attnum");
+    if (command == NULL) {
+        return NULL;
+    }
+    parameters = PyTuple_Pack(1, name);
+    if (parameters == NULL) {
+        Py_DECREF(command);
+        return NULL;
+    }
+    res = _Conn_execute(self, command, parameters, FORMAT_TEXT);
+    Py_DECREF(command);
+    Py_DECREF(parameters);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    ntuples = PQntuples(res);
+    if (ntuples == 0) {
+        PyErr_Format(PoqueError, "%R is not a composite type", name);
+        goto end;
+    }
+    oid = strtoul(PQgetvalue(res, 0, 0), NULL, 10);
+    array_oid = strtoul(PQgetvalue(res, 0, 1), NULL, 10);
+
+    /* one row without a field name for a type without fields */
+    names = PyList_New(0);
+    if (names == NULL) {
+        goto end;
+    }
+    for (i = 0; i < ntuples; i++) {
+        if (PQgetisnull(res, i, 3)) {
+            continue;
+        }
+        field_name = PyUnicode_FromString(PQgetvalue(res, i, 3));
+        if (field_name == NULL || PyList_Append(names, field_name) == -1) {
+            Py_XDECREF(field_name);
+            goto end;
+        }
+        Py_DECREF(field_name);
+    }
+
+    /* the type name is used for the named tuple if possible */
+    type_name = PQgetvalue(res, 0, 2);
+    nt_args = Py_BuildValue("(sO)", type_name, names);
+    if (nt_args == NULL) {
+        goto end;
+    }
+    if (!PyUnicode_IsIdentifier(PyTuple_GET_ITEM(nt_args, 0))) {
+        type_name = "Record";
+        Py_SETREF(nt_args, Py_BuildValue("(sO)", type_name, names));
+        if (nt_args == NULL) {
+            goto end;
+        }
+    }
+    nt_kwds = Py_BuildValue("{sO}", "rename", Py_True);
+    if (nt_kwds == NULL) {
+        goto end;
+    }
+    namedtuple = load_python_object("collections", "namedtuple");
+    if (namedtuple == NULL) {
+        goto end;
+    }
+    cls = PyObject_Call(namedtuple, nt_args, nt_kwds);
+    if (cls == NULL) {
+        goto end;
+    }
+    if (!PyType_Check(cls) ||
+            !PyType_IsSubtype((PyTypeObject *)cls, &PyTuple_Type)) {
+        PyErr_SetString(PyExc_TypeError, "namedtuple did not return a type");
+        Py_CLEAR(cls);
+        goto end;
+    }
+
+    type_handlers = add_composite_type(
+        self->type_handlers, oid, array_oid, (PyTypeObject *)cls,
+        PyList_GET_SIZE(names));
+    if (type_handlers == NULL) {
+        Py_CLEAR(cls);
+        goto end;
+    }
+    Py_XSETREF(self->type_handlers, type_handlers);
+
+end:
+    PQclear(res);
+    Py_XDECREF(names);
+    Py_XDECREF(nt_args);
+    Py_XDECREF(nt_kwds);
+    Py_XDECREF(namedtuple);
+    return cls;
+}
+
+
+static PyObject *
+Conn_register_hstore(PoqueConn *self, PyObject *args, PyObject *kwds) {
+    /* Looks up the oids of the hstore extension type. Values of hstore and
+     * its array type are returned as dicts in subsequent results and dict
+     * parameters are sent as hstore values.
+     */
+    PyObject *name = NULL, *command, *parameters, *type_handlers;
+    PGresult *res;
+    Oid oid, array_oid;
+
+    static char *kwlist[] = {"name", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|U", kwlist, &name))
+        return NULL;
+
+    command = PyUnicode_FromString(
+        "SELECT t.oid, t.typarray FROM pg_type t "
+        "WHERE t.oid = $1::regtype AND t.typname = 'hstore'");
+    if (command == NULL) {
+        return NULL;
+    }
+    parameters = name ? PyTuple_Pack(1, name) : Py_BuildValue("(s)", "hstore");
+    if (parameters == NULL) {
+        Py_DECREF(command);
+        return NULL;
+    }
+    res = _Conn_execute(self, command, parameters, FORMAT_TEXT);
+    Py_DECREF(command);
+    if (res == NULL) {
+        Py_DECREF(parameters);
+        return NULL;
+    }
+    if (PQntuples(res) == 0) {
+        PQclear(res);
+        PyErr_Format(PoqueError, "%R is not the hstore type",
+                     PyTuple_GET_ITEM(parameters, 0));
+        Py_DECREF(parameters);
+        return NULL;
+    }
+    Py_DECREF(parameters);
+    oid = strtoul(PQgetvalue(res, 0, 0), NULL, 10);
+    array_oid = strtoul(PQgetvalue(res, 0, 1), NULL, 10);
+    PQclear(res);
+
+    type_handlers = add_type_handlers(
+        self->type_handlers, oid, &hstore_val_handler, array_oid,
+        &hstorearray_val_handler);
+    if (type_handlers == NULL) {
+        return NULL;
+    }
+    Py_XSETREF(self->type_handlers, type_handlers);
+    self->hstore_oid = oid;
+    self->hstore_array_oid = array_oid;
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+Conn_register_vector(PoqueConn *self, PyObject *unused) {
+    /* Looks up the oids of the pgvector vector and halfvec types. Their
+     * values are returned as Vector objects in subsequent results and Vector
+     * parameters are sent with the oid of their type.
+     */
+    PyObject *command, *type_handlers;
+    PoqueValueHandler *handler, *array_handler;
+    PGresult *res;
+    Oid oid, array_oid, vector_oid = InvalidOid, halfvec_oid = InvalidOid;
+    int i;
+    char *type_name;
+
+    command = PyUnicode_FromString(
+        "SELECT t.typname, t.oid, t.typarray FROM pg_type t "
+        "WHERE t.oid IN (to_regtype('vector'), to_regtype('halfvec'))");
+    if (command == NULL) {
+        return NULL;
+    }
+    res = _Conn_execute(self, command, NULL, FORMAT_TEXT);
+    Py_DECREF(command);
+    if (res == NULL) {
+        return NULL;
+    }
+
+    /* halfvec is only available in later versions of pgvector */
+    type_handlers = self->type_handlers;
+    Py_XINCREF(type_handlers);
+    for (i = 0; i < PQntuples(res); i++) {
+        type_name = PQgetvalue(res, i, 0);
+        oid = strtoul(PQgetvalue(res, i, 1), NULL, 10);
+        array_oid = strtoul(PQgetvalue(res, i, 2), NULL, 10);
+        if (strcmp(type_name, "vector") == 0) {
+            vector_oid = oid;
+            handler = &vector_val_handler;
+            array_handler = &vectorarray_val_handler;
+        }
+        else if (strcmp(type_name, "halfvec") == 0) {
+            halfvec_oid = oid;
+            handler = &halfvec_val_handler;
+            array_handler = &halfvecarray_val_handler;
+        }
+        else {
+            continue;
+        }
+        Py_XSETREF(type_handlers, add_type_handlers(
+            type_handlers, oid, handler, array_oid, array_handler));
+        if (type_handlers == NULL) {
+            PQclear(res);
+            return NULL;
+        }
+    }
+    PQclear(res);
+    if (vector_oid == InvalidOid) {
+        Py_XDECREF(type_handlers);
+        PyErr_SetString(PoqueError, "The vector type is not available");
+        return NULL;
+    }
+    Py_XSETREF(self->type_handlers, type_handlers);
+    self->vector_oid = vector_oid;
+    self->halfvec_oid = halfvec_oid;
+    Py_RETURN_NONE;
+}
+
+
 static void
 Conn_dealloc(PoqueConn *self)
 {
     PQfinish(self->conn);
     if (self->wr_list != NULL)
         PyObject_ClearWeakRefs((PyObject *) self);
+    Py_CLEAR(self->session_tz);
+    Py_CLEAR(self->session_tz_name);
+    Py_CLEAR(self->json_loads);
+    Py_CLEAR(self->type_handlers);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
 
@@ -872,9 +1598,105 @@ Conn_charprop(PoqueConn *self, char *(*func)(PGconn *))
 }
 
 
+/* ==== conversion options ================================================== */
+
+/* An option is stored as a char on the connection and exposed as a string
+ * attribute. The index in names is the stored value.
+ */
+
+typedef struct _connOption {
+    size_t offset;
+    const char *names[8];
+} ConnOption;
+
+
+static ConnOption uuid_as_option = {
+    offsetof(PoqueConn, uuid_as), {"uuid", "bytes", "int", "str", NULL}};
+
+static ConnOption numeric_as_option = {
+    offsetof(PoqueConn, numeric_as), {"decimal", "int", "float", NULL}};
+
+static ConnOption json_as_option = {
+    offsetof(PoqueConn, json_as), {"object", "str", "bytes", "lazy", NULL}};
+
+static ConnOption bit_as_option = {
+    offsetof(PoqueConn, bit_as), {"int", "bitstring", NULL}};
+
+static ConnOption array_as_option = {
+    offsetof(PoqueConn, array_as), {"list", "buffer", NULL}};
+
+static ConnOption geometry_as_option = {
+    offsetof(PoqueConn, geometry_as), {"tuple", "buffer", NULL}};
+
+static ConnOption inet_as_option = {
+    offsetof(PoqueConn, inet_as), {"ipaddress", "raw", NULL}};
+
+
+static PyObject *
+Conn_get_option(PoqueConn *self, ConnOption *option)
+{
+    char value = *((char *)self + option->offset);
+    return PyUnicode_FromString(option->names[(int)value]);
+}
+
+
+static int
+Conn_set_option(PoqueConn *self, PyObject *value, ConnOption *option)
+{
+    const char *name;
+    int i;
+
+    if (value == NULL) {
+        PyErr_SetString(PyExc_AttributeError, "Can not delete attribute");
+        return -1;
+    }
+    name = PyUnicode_AsUTF8(value);
+    if (name == NULL) {
+        return -1;
+    }
+    for (i = 0; option->names[i] != NULL; i++) {
+        if (strcmp(name, option->names[i]) == 0) {
+            *((char *)self + option->offset) = (char)i;
+            return 0;
+        }
+    }
+    PyErr_Format(PyExc_ValueError, "Invalid value: '%s'", name);
+    return -1;
+}
+
+
+static PyObject *
+Conn_get_json_loads(PoqueConn *self, void *unused)
+{
+    PyObject *ret = self->json_loads ? self->json_loads : Py_None;
+
+    Py_INCREF(ret);
+    return ret;
+}
+
+
+static int
+Conn_set_json_loads(PoqueConn *self, PyObject *value, void *unused)
+{
+    /* None (or delete) restores json.loads */
+    if (value == Py_None) {
+        value = NULL;
+    }
+    if (value != NULL && !PyCallable_Check(value)) {
+        PyErr_SetString(PyExc_TypeError, "json_loads must be callable");
+        return -1;
+    }
+    Py_XINCREF(value);
+    Py_XSETREF(self->json_loads, value);
+    return 0;
+}
+
+
 static PyMemberDef Conn_members[] = {
     {"autocommit", T_BOOL, offsetof(PoqueConn, autocommit), 0,
      "Autocommit"},
+    {"session_timezone", T_BOOL, offsetof(PoqueConn, session_timezone), 0,
+     "Return timestamptz values in the session time zone"},
     {NULL}
 };
 
@@ -956,6 +1778,61 @@ static PyGetSetDef Conn_getset[] = {{
         NULL,
         PyDoc_STR("error message"),
         PQerrorMessage
+    }, {
+        "uuid_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of uuid values: 'uuid', 'bytes', 'int' or 'str'"),
+        &uuid_as_option
+    }, {
+        "numeric_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of numeric values: 'decimal', 'int' (when the scale "
+                  "is zero) or 'float'"),
+        &numeric_as_option
+    }, {
+        "json_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of json values: 'object', 'str', 'bytes' or 'lazy' "
+                  "for a JsonValue that is parsed on first access"),
+        &json_as_option
+    }, {
+        "bit_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of bit values: 'int' or 'bitstring'"),
+        &bit_as_option
+    }, {
+        "array_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of array values: 'list' or 'buffer' for an "
+                  "ArrayBuffer of binary int, float, oid and bool arrays "
+                  "without NULLs"),
+        &array_as_option
+    }, {
+        "geometry_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of path and polygon values: 'tuple' or 'buffer' for "
+                  "a Path or Polygon with an N x 2 float64 ArrayBuffer"),
+        &geometry_as_option
+    }, {
+        "inet_as",
+        (getter)Conn_get_option,
+        (setter)Conn_set_option,
+        PyDoc_STR("type of inet and cidr values: 'ipaddress' or 'raw' for a "
+                  "(family, int, prefixlen) tuple"),
+        &inet_as_option
+    }, {
+        "json_loads",
+        (getter)Conn_get_json_loads,
+        (setter)Conn_set_json_loads,
+        PyDoc_STR("function to parse json values, called with bytes. None "
+                  "for json.loads"),
+        NULL
     }, {
         NULL
 }};
@@ -990,6 +1867,16 @@ static PyMethodDef Conn_methods[] = {{
     }, {
         "execute", (PyCFunction)Conn_execute, METH_VARARGS| METH_KEYWORDS,
         PyDoc_STR("execute a statement")
+    }, {
+        "execute_multi", (PyCFunction)Conn_execute_multi,
+        METH_VARARGS| METH_KEYWORDS,
+        PyDoc_STR("execute statements and return all results")
+    }, {
+        "commit", (PyCFunction)Conn_commit, METH_VARARGS| METH_KEYWORDS,
+        PyDoc_STR("commit the current transaction")
+    }, {
+        "rollback", (PyCFunction)Conn_rollback, METH_VARARGS| METH_KEYWORDS,
+        PyDoc_STR("roll back the current transaction")
     }, {
         "escape_literal", (PyCFunction)Conn_escape_literal,
         METH_VARARGS| METH_KEYWORDS,
@@ -1001,6 +1888,21 @@ static PyMethodDef Conn_methods[] = {{
     }, {
         "cursor", (PyCFunction)Conn_cursor, METH_NOARGS,
         PyDoc_STR("create cursor")
+    }, {
+        "encode", (PyCFunction)Conn_encode, METH_O,
+        PyDoc_STR("encode a parameter value to send it many times")
+    }, {
+        "register_composite", (PyCFunction)Conn_register_composite,
+        METH_VARARGS | METH_KEYWORDS,
+        PyDoc_STR("return values of a composite type as named tuples, "
+                  "unregistered composite values are returned as raw data")
+    }, {
+        "register_hstore", (PyCFunction)Conn_register_hstore,
+        METH_VARARGS | METH_KEYWORDS,
+        PyDoc_STR("read and send hstore values as dicts")
+    }, {
+        "register_vector", (PyCFunction)Conn_register_vector, METH_NOARGS,
+        PyDoc_STR("read and send pgvector values as Vector objects")
     }, {
         NULL
 }};
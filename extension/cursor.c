@@ -5,6 +5,8 @@ typedef struct PoqueCursor {
     PyObject *wr_list;
     PoqueConn *conn;
     PoqueResult *result;
+    PyObject *results;
+    Py_ssize_t result_idx;
     int arraysize;
     int pos;
     int ntuples;
@@ -26,44 +28,90 @@ PoqueCursor_CheckClosed(PoqueCursor *self)
 }
 
 
-static PGresult *
-_PoqueCursor_execute(PoqueCursor *self, PyObject *command, PyObject *parameters,
-                     int format)
+static int
+_PoqueCursor_begin(PoqueCursor *self, const char **before)
 {
     PoqueConn *cn;
-    PGresult *res;
 
     if (PoqueCursor_CheckClosed(self) == -1) {
-        return NULL;
+        return -1;
     }
     cn = self->conn;
 
-    /* check if we should start a transaction */
+    /* check if we should start a transaction, the BEGIN is sent along with
+     * the statement */
     if (!cn->autocommit && PQtransactionStatus(cn->conn) == PQTRANS_IDLE) {
-        PyObject *begin = PyUnicode_FromString("BEGIN");
+        *before = "BEGIN";
+    }
+    else {
+        *before = NULL;
+    }
+    return 0;
+}
 
-        if (begin == NULL) {
-            return NULL;
-        }
-        res = _Conn_execute(cn, begin, NULL, FORMAT_TEXT);
-        Py_DECREF(begin);
 
-        if (res == NULL) {
-            return NULL;
-        }
-        PQclear(res);
+static PGresult *
+_PoqueCursor_execute(PoqueCursor *self, PyObject *command, PyObject *parameters,
+                     int format)
+{
+    const char *before;
+
+    if (_PoqueCursor_begin(self, &before) == -1) {
+        return NULL;
     }
 
     /* execute statement */
-    return _Conn_execute(cn, command, parameters, format);
+    return _Conn_execute_after(self->conn, before, command, parameters, format);
+}
+
+
+static void
+PoqueCursor_set_result(PoqueCursor *self, Py_ssize_t idx)
+{
+    PoqueResult *result;
+
+    result = (PoqueResult *)PyList_GET_ITEM(self->results, idx);
+    Py_INCREF(result);
+    Py_XSETREF(self->result, result);
+    self->result_idx = idx;
+    self->pos = 0;
+    self->ntuples = PQntuples(result->result);
+    self->nfields = Py_SIZE(result);
+}
+
+
+static Py_ssize_t
+PoqueCursor_next_set_idx(PoqueCursor *self, Py_ssize_t idx)
+{
+    /* Finds the next result with fields, or -1 if there is none */
+    Py_ssize_t num_results = PyList_GET_SIZE(self->results);
+
+    for (; idx < num_results; idx++) {
+        if (Py_SIZE(PyList_GET_ITEM(self->results, idx))) {
+            return idx;
+        }
+    }
+    return -1;
+}
+
+
+static void
+PoqueCursor_clear_results(PoqueCursor *self)
+{
+    Py_CLEAR(self->result);
+    Py_CLEAR(self->results);
+    self->result_idx = 0;
+    self->pos = 0;
+    self->ntuples = 0;
+    self->nfields = 0;
 }
 
 
 static PyObject *
 PoqueCursor_execute(PoqueCursor *self, PyObject *args, PyObject *kwds) {
-    PyObject *command, *parameters = NULL;
+    PyObject *command, *parameters = NULL, *results;
     int format = FORMAT_AUTO;
-    PoqueResult *result;
+    Py_ssize_t idx, num_params = 0;
     PGresult *res;
     static char *kwlist[] = {"operation", "parameters", "result_format", NULL};
 
@@ -73,31 +121,84 @@ PoqueCursor_execute(PoqueCursor *self, PyObject *args, PyObject *kwds) {
         return NULL;
     }
 
-    Py_CLEAR(self->result);
+    PoqueCursor_clear_results(self);
 
-    res = _PoqueCursor_execute(self, command, parameters, format);
-    if (res == NULL) {
-        return NULL;
+    if (parameters != NULL) {
+        num_params = PyObject_Length(parameters);
+        if (num_params == -1) {
+            /* not a sequence, the parameter path reports that */
+            PyErr_Clear();
+        }
     }
 
-    result = PoqueResult_New(res, self->conn);
-    if (result == NULL) {
-        PQclear(res);
-        return NULL;
+    /* an empty parameter list uses the simple protocol, like Conn.execute */
+    if (num_params == 0 && format != FORMAT_BINARY) {
+        /* Plain statements can contain multiple commands, keep all of
+         * their results for nextset */
+        const char *before;
+
+        if (_PoqueCursor_begin(self, &before) == -1) {
+            return NULL;
+        }
+        results = _Conn_execute_multi(self->conn, before, command);
+        if (results == NULL) {
+            return NULL;
+        }
     }
+    else {
+        PoqueResult *result;
 
-    /* set PoqueResult on cursor */
-    self->result = result;
+        res = _PoqueCursor_execute(self, command, parameters, format);
+        if (res == NULL) {
+            return NULL;
+        }
+        result = PoqueResult_New(res, self->conn);
+        if (result == NULL) {
+            PQclear(res);
+            return NULL;
+        }
+        results = PyList_New(1);
+        if (results == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(results, 0, (PyObject *)result);
+    }
 
-    self->pos = 0;
-    self->ntuples = PQntuples(res);
-    self->nfields = Py_SIZE(result);
+    /* set PoqueResult on cursor, positioned on the first result set, or on
+     * the last result if no command returned rows */
+    self->results = results;
+    idx = PoqueCursor_next_set_idx(self, 0);
+    if (idx == -1) {
+        idx = PyList_GET_SIZE(results) - 1;
+    }
+    PoqueCursor_set_result(self, idx);
 
     /* and done */
     Py_RETURN_NONE;
 }
 
 
+static PyObject *
+PoqueCursor_nextset(PoqueCursor *self, PyObject *unused) {
+    Py_ssize_t idx;
+
+    if (PoqueCursor_CheckClosed(self) == -1) {
+        return NULL;
+    }
+    if (self->results == NULL) {
+        PyErr_SetString(PoqueInterfaceError, "No result set");
+        return NULL;
+    }
+    idx = PoqueCursor_next_set_idx(self, self->result_idx + 1);
+    if (idx == -1) {
+        Py_RETURN_NONE;
+    }
+    PoqueCursor_set_result(self, idx);
+    Py_RETURN_TRUE;
+}
+
+
 static PyObject *
 PoqueCursor_executemany(PoqueCursor *self, PyObject *args, PyObject *kwds) {
     PyObject *command, *seq_of_parameters = NULL, *parameters;
@@ -128,11 +229,7 @@ PoqueCursor_executemany(PoqueCursor *self, PyObject *args, PyObject *kwds) {
         PQclear(res);
     }
     /* reset PoqueResult on cursor */
-    Py_CLEAR(self->result);
-
-    self->pos = 0;
-    self->ntuples = 0;
-    self->nfields = 0;
+    PoqueCursor_clear_results(self);
 
     /* and done */
     Py_RETURN_NONE;
@@ -358,20 +455,25 @@ static PyObject *
 _PoqueCursor_FetchMany(PoqueCursor *self, int nrows)
 {
     PyObject *rows;
-    int i;
+    PoqueResult *result = self->result;
 
     rows = PyList_New(nrows);
     if (rows == NULL) {
         return NULL;
     }
-    for (i = 0; i < nrows; i++) {
-        PyObject *row = _PoqueCursor_FetchOne(self);
-        if (row == NULL) {
-            Py_DECREF(rows);
-            return NULL;
-        }
-        PyList_SET_ITEM(rows, i, row);
+
+    /* The GIL might be released during conversion. Hold on to the result to
+     * detect if the cursor was reused in the meantime */
+    Py_INCREF(result);
+    if (_Result_rows(result, self->pos, nrows, rows) == -1) {
+        Py_DECREF(result);
+        Py_DECREF(rows);
+        return NULL;
+    }
+    if (self->result == result) {
+        self->pos += nrows;
     }
+    Py_DECREF(result);
     return rows;
 }
 
@@ -475,9 +577,7 @@ PoqueCursor_iternext(PoqueCursor *self)
 static PyObject *
 PoqueCursor_close(PoqueCursor *self, PyObject *unused) {
     Py_CLEAR(self->conn);
-    Py_CLEAR(self->result);
-    self->nfields = 0;
-    self->ntuples = 0;
+    PoqueCursor_clear_results(self);
     Py_RETURN_NONE;
 }
 
@@ -488,6 +588,7 @@ PoqueCursor_dealloc(PoqueCursor *self) {
     if (self->wr_list != NULL)
         PyObject_ClearWeakRefs((PyObject *) self);
     Py_CLEAR(self->result);
+    Py_CLEAR(self->results);
     Py_CLEAR(self->conn);
     Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -555,6 +656,9 @@ static PyMethodDef Cursor_methods[] = {{
         "executemany", (PyCFunction)PoqueCursor_executemany,
         METH_VARARGS | METH_KEYWORDS, PyDoc_STR(
             "executes a statement multiple times")
+    }, {
+        "nextset", (PyCFunction)PoqueCursor_nextset, METH_NOARGS,
+        PyDoc_STR("skip to the next result set")
     }, {
         "fetchone", (PyCFunction)PoqueCursor_FetchOne, METH_NOARGS,
         PyDoc_STR("fetch a row")
@@ -621,6 +725,8 @@ PoqueCursor_New(PoqueConn *conn)
     Py_INCREF(conn);
     cursor->conn = conn;
     cursor->result = NULL;
+    cursor->results = NULL;
+    cursor->result_idx = 0;
     cursor->arraysize = 1;
     cursor->pos = 0;
     cursor->ntuples = 0;
@@ -6,6 +6,13 @@ static long min_year;
 static long max_year;
 
 static PyObject *utc;
+static PyObject *zoneinfo;
+
+#ifndef PyDateTime_DATE_GET_TZINFO
+#define PyDateTime_DATE_GET_TZINFO(o) \
+    (((_PyDateTime_BaseTZInfo *)(o))->hastzinfo ? \
+     ((PyDateTime_DateTime *)(o))->tzinfo : Py_None)
+#endif
 
 
 #define POSTGRES_EPOCH_JDATE    2451545
@@ -17,23 +24,116 @@ static PyObject *utc;
 #define USECS_PER_SEC       Py_LL(1000000)
 
 
+/* ======= timezone cache =================================================== */
+
+/* Postgres limits UTC offsets to less than 16 hours. Timezones for offsets in
+ * whole minutes within that range are created once and reused.
+ */
+#define TZ_CACHE_MINUTES    (16 * 60)
+#define TZ_CACHE_SIZE       (2 * TZ_CACHE_MINUTES + 1)
+
+static PyObject *tz_cache[TZ_CACHE_SIZE];
+
+
+static PyObject *
+timezone_from_offset(int seconds)
+{
+    /* Returns a datetime.timezone for an offset in seconds east of UTC */
+    PyObject *offset, *tz;
+    int idx = -1;
+
+    if (seconds == 0) {
+        Py_INCREF(utc);
+        return utc;
+    }
+    if (seconds % 60 == 0 && seconds / 60 >= -TZ_CACHE_MINUTES &&
+            seconds / 60 <= TZ_CACHE_MINUTES) {
+        idx = seconds / 60 + TZ_CACHE_MINUTES;
+        tz = tz_cache[idx];
+        if (tz != NULL) {
+            Py_INCREF(tz);
+            return tz;
+        }
+    }
+
+    offset = PyDelta_FromDSU(0, seconds, 0);
+    if (offset == NULL) {
+        return NULL;
+    }
+    tz = PyTimeZone_FromOffset(offset);
+    Py_DECREF(offset);
+    if (tz != NULL && idx != -1) {
+        Py_INCREF(tz);
+        tz_cache[idx] = tz;
+    }
+    return tz;
+}
+
+
+static PyObject *
+session_timezone(PoqueConn *conn)
+{
+    /* Returns a borrowed reference to the zoneinfo timezone of the TimeZone
+     * setting of the session.
+     */
+    const char *name;
+    PyObject *tz, *tz_name;
+
+    name = PQparameterStatus(conn->conn, "TimeZone");
+    if (name == NULL) {
+        return utc;
+    }
+    if (conn->session_tz != NULL &&
+            strcmp(PyBytes_AS_STRING(conn->session_tz_name), name) == 0) {
+        return conn->session_tz;
+    }
+
+    if (zoneinfo == NULL) {
+        zoneinfo = load_python_object("zoneinfo", "ZoneInfo");
+        if (zoneinfo == NULL) {
+            return NULL;
+        }
+    }
+    tz = PyObject_CallFunction(zoneinfo, "s", name);
+    if (tz == NULL) {
+        return NULL;
+    }
+    tz_name = PyBytes_FromString(name);
+    if (tz_name == NULL) {
+        Py_DECREF(tz);
+        return NULL;
+    }
+    Py_XSETREF(conn->session_tz, tz);
+    Py_XSETREF(conn->session_tz_name, tz_name);
+    return tz;
+}
+
+
 /* ======= parameter helper functions ======================================= */
 
 static int
-date_pgordinal(PyObject *param, int *ordinal)
+ymd_to_pgordinal(int year, int month, int day)
 {
-    PyObject *py_ordinal;
-    _Py_IDENTIFIER(toordinal);
-
-    /* get the Python ordinal */
-    py_ordinal = _PyObject_CallMethodIdObjArgs(param, &PyId_toordinal, NULL);
-    if (py_ordinal == NULL) {
-        return -1;
+    /* Same calculation as the Python date.toordinal(), with the PG offset */
+    static const int days_before_month[] = {
+        0, 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+    int y = year - 1, ordinal;
+
+    ordinal = y * 365 + y / 4 - y / 100 + y / 400 +
+              days_before_month[month] + day;
+    if (month > 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
+        ordinal++;
     }
+    return ordinal - DATE_OFFSET;
+}
+
 
-    /* convert to PG ordinal */
-    *ordinal = (int) (PyLong_AsLong(py_ordinal) - DATE_OFFSET);
-    Py_DECREF(py_ordinal);
+static int
+date_pgordinal(PyObject *param, int *ordinal)
+{
+    *ordinal = ymd_to_pgordinal(
+        PyDateTime_GET_YEAR(param), PyDateTime_GET_MONTH(param),
+        PyDateTime_GET_DAY(param));
     return 0;
 }
 
@@ -124,21 +224,24 @@ new_time_param_handler(int num_param) {
 /* ==== datetime parameter handler ========================================== */
 
 
+static PY_INT64_T
+datetime_pgvalue(PyObject *param)
+{
+    /* microseconds since the PG epoch of the local time of the datetime */
+    return (ymd_to_pgordinal(PyDateTime_GET_YEAR(param),
+                             PyDateTime_GET_MONTH(param),
+                             PyDateTime_GET_DAY(param)) * USECS_PER_DAY +
+            PyDateTime_DATE_GET_HOUR(param)  * USECS_PER_HOUR +
+            PyDateTime_DATE_GET_MINUTE(param) * USECS_PER_MINUTE +
+            PyDateTime_DATE_GET_SECOND(param) * USECS_PER_SEC +
+            PyDateTime_DATE_GET_MICROSECOND(param));
+}
+
+
 static int
 datetime_encode_at(
         param_handler *handler, PyObject *param, char *loc) {
-    int ordinal;
-    PY_INT64_T val;
-
-    if (date_pgordinal(param, &ordinal) < 0) {
-        return -1;
-    }
-    val = (ordinal * USECS_PER_DAY +
-           PyDateTime_DATE_GET_HOUR(param)  * USECS_PER_HOUR +
-           PyDateTime_DATE_GET_MINUTE(param) * USECS_PER_MINUTE +
-           PyDateTime_DATE_GET_SECOND(param) * USECS_PER_SEC +
-           PyDateTime_DATE_GET_MICROSECOND(param));
-    write_uint64(&loc, val);
+    write_uint64(&loc, datetime_pgvalue(param));
     return 8;
 }
 
@@ -146,38 +249,70 @@ datetime_encode_at(
 static int
 datetimetz_encode_at(
         param_handler *handler, PyObject *param, char *loc) {
-    PyObject *utc_param;
-    int ret;
-    _Py_IDENTIFIER(astimezone);
-
-    /* convert datetime object to UTC */
-    utc_param = _PyObject_CallMethodIdObjArgs(
-        param, &PyId_astimezone, utc, NULL);
-    if (utc_param == NULL) {
-        return -1;
+    PyObject *offset;
+    PY_INT64_T val;
+    _Py_IDENTIFIER(utcoffset);
+
+    val = datetime_pgvalue(param);
+    if (PyDateTime_DATE_GET_TZINFO(param) != utc) {
+        /* subtract the UTC offset to get the UTC value */
+        offset = _PyObject_CallMethodIdObjArgs(
+            param, &PyId_utcoffset, NULL);
+        if (offset == NULL) {
+            return -1;
+        }
+        if (!PyDelta_Check(offset)) {
+            Py_DECREF(offset);
+            PyErr_SetString(PyExc_ValueError, "Invalid UTC offset");
+            return -1;
+        }
+        val -= (PyDateTime_DELTA_GET_DAYS(offset) * USECS_PER_DAY +
+                PyDateTime_DELTA_GET_SECONDS(offset) * USECS_PER_SEC +
+                PyDateTime_DELTA_GET_MICROSECONDS(offset));
+        Py_DECREF(offset);
     }
+    write_uint64(&loc, val);
+    return 8;
+}
 
-    /* Use the UTC datetime for serialization */
-    ret = datetime_encode_at(handler, utc_param, loc);
-    Py_DECREF(utc_param);
-    return ret;
 
+static int
+datetime_has_tz(PyObject *param)
+{
+    /* Whether the datetime is aware. Like in Python, a datetime with a tzinfo
+     * that returns None for its UTC offset is naive.
+     */
+    PyObject *tzinfo, *offset;
+    int has_tz;
+    _Py_IDENTIFIER(utcoffset);
+
+    tzinfo = PyDateTime_DATE_GET_TZINFO(param);
+    if (tzinfo == Py_None) {
+        return 0;
+    }
+    if (tzinfo == utc) {
+        return 1;
+    }
+    offset = _PyObject_CallMethodIdObjArgs(param, &PyId_utcoffset, NULL);
+    if (offset == NULL) {
+        return -1;
+    }
+    has_tz = offset != Py_None;
+    Py_DECREF(offset);
+    return has_tz;
 }
 
 
 static int
 datetime_examine(param_handler *handler, PyObject *param) {
-    PyObject *tz;
     int has_tz;
 
     /* Presence of timezone must be the same for all items in an datetime array.
      */
-    tz = PyObject_GetAttrString(param, "tzinfo");
-    if (tz == NULL) {
+    has_tz = datetime_has_tz(param);
+    if (has_tz == -1) {
         return -1;
     }
-    has_tz = tz != Py_None;
-    Py_DECREF(tz);
     if (handler->oid == InvalidOid) {
         /* first time, adjust the handler appropriately */
         if (has_tz) {
@@ -286,30 +421,158 @@ date_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 }
 
 
-static PyObject *
-date_strval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+/* ==== text value helpers ================================================== */
+
+/* The text readers parse the ISO output format of the server by hand. Values
+ * in another DateStyle or IntervalStyle are returned as str.
+ */
+
+static char *
+read_digits(char *p, char *end, int min_len, int max_len, int *val)
 {
-    int count, year, month, day, pos;
+    /* reads a decimal number of min_len up to max_len digits */
+    int n = 0, v = 0;
 
-    // special values
-    if (strncmp(data, "infinity", len) == 0 ||
-            strncmp(data, "-infinity", len) == 0) {
-        return PyUnicode_FromStringAndSize(data, len);
+    while (p < end && n < max_len && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        p++;
+        n++;
     }
+    if (n < min_len) {
+        return NULL;
+    }
+    *val = v;
+    return p;
+}
 
-    count = sscanf(data, "%7d-%2d-%2d%n", &year, &month, &day, &pos);
-    if (count != 3) {
-        printf("%s\n", PQparameterStatus(result->conn->conn, "DateStyle"));
-        PyErr_SetString(PoqueError, "Invalid date value");
+
+static char *
+read_date(char *p, char *end, int *year, int *month, int *day)
+{
+    /* reads 'YYYY-MM-DD', the year may have more than four digits */
+    p = read_digits(p, end, 4, 7, year);
+    if (p == NULL || p == end || *p != '-') {
+        return NULL;
+    }
+    p = read_digits(p + 1, end, 2, 2, month);
+    if (p == NULL || p == end || *p != '-') {
+        return NULL;
+    }
+    p = read_digits(p + 1, end, 2, 2, day);
+    if (p == NULL || *month < 1 || *month > 12 || *day < 1 || *day > 31) {
         return NULL;
     }
+    return p;
+}
 
-    if (pos < len) {
-        if (strcmp(" BC", data + pos) != 0) {
-            PyErr_SetString(PoqueError, "Invalid date value");
-            return NULL;
+
+static char *
+read_fraction(char *p, char *end, int *usec)
+{
+    /* reads an optional fraction of up to six digits as microseconds */
+    char *start;
+    int n;
+
+    *usec = 0;
+    if (p == end || *p != '.') {
+        return p;
+    }
+    start = ++p;
+    p = read_digits(p, end, 1, 6, usec);
+    if (p == NULL) {
+        return NULL;
+    }
+    /* multiply by 10 for every missing digit */
+    for (n = (int)(p - start); n < 6; n++) {
+        *usec *= 10;
+    }
+    return p;
+}
+
+
+static char *
+read_time(char *p, char *end, int *hour, int *minute, int *second, int *usec)
+{
+    /* reads 'HH:MM:SS' with optional fraction of up to six digits */
+    p = read_digits(p, end, 2, 2, hour);
+    if (p == NULL || p == end || *p != ':') {
+        return NULL;
+    }
+    p = read_digits(p + 1, end, 2, 2, minute);
+    if (p == NULL || p == end || *p != ':') {
+        return NULL;
+    }
+    p = read_digits(p + 1, end, 2, 2, second);
+    if (p == NULL || *hour > 24 || *minute > 59 || *second > 59) {
+        return NULL;
+    }
+    return read_fraction(p, end, usec);
+}
+
+
+static char *
+read_tz(char *p, char *end, int *offset)
+{
+    /* reads a UTC offset '+HH[:MM[:SS]]' as seconds east of UTC */
+    int hours, minutes = 0, seconds = 0, sign;
+
+    if (p == end || (*p != '+' && *p != '-')) {
+        return NULL;
+    }
+    sign = (*p == '-') ? -1 : 1;
+    p = read_digits(p + 1, end, 2, 2, &hours);
+    if (p != NULL && p < end && *p == ':') {
+        p = read_digits(p + 1, end, 2, 2, &minutes);
+        if (p != NULL && p < end && *p == ':') {
+            p = read_digits(p + 1, end, 2, 2, &seconds);
+        }
+    }
+    if (p == NULL || minutes > 59 || seconds > 59) {
+        return NULL;
+    }
+    *offset = sign * (hours * 3600 + minutes * 60 + seconds);
+    return p;
+}
+
+
+static PyObject *
+datetime_strval_other(
+    PoqueResult *result, char *data, int len, const char *type_name)
+{
+    /* Handles a value that is not in ISO format. Only ISO is parsed, for other
+     * DateStyle settings the text is returned.
+     */
+    const char *style;
+
+    style = PQparameterStatus(result->conn->conn, "DateStyle");
+    if (style != NULL && strncmp(style, "ISO", 3) == 0) {
+        PyErr_Format(PoqueError, "Invalid %s value", type_name);
+        return NULL;
+    }
+    return text_val(result, data, len, NULL);
+}
+
+
+static PyObject *
+date_strval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+{
+    int year, month, day;
+    char *p, *end = data + len;
+
+    p = read_date(data, end, &year, &month, &day);
+    if (p == NULL) {
+        // special values
+        if ((len == 8 && memcmp(data, "infinity", 8) == 0) ||
+                (len == 9 && memcmp(data, "-infinity", 9) == 0)) {
+            return text_val(result, data, len, NULL);
+        }
+        return datetime_strval_other(result, data, len, "date");
+    }
+    if (p != end) {
+        if (end - p != 3 || memcmp(p, " BC", 3) != 0) {
+            return datetime_strval_other(result, data, len, "date");
         }
-        return PyUnicode_FromStringAndSize(data, len);
+        return text_val(result, data, len, NULL);
     }
     return date_fromymd(year, month, day);
 }
@@ -358,80 +621,42 @@ time_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 static PyObject *
 time_strval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 {
-    int count, pos;
-    unsigned int hour, minute, second, usec=0;
-    char *end;
-    PyObject *tz_type, *tz, *time_val;
+    int hour, minute, second, usec;
 
-    count = sscanf(data, "%2u:%2u:%2u%n", &hour, &minute, &second, &pos);
-    if (pos != 8 || count != 3 || hour > 24 || minute > 59 || second > 59) {
+    if (read_time(data, data + len, &hour, &minute, &second, &usec) !=
+            data + len) {
         PyErr_SetString(PoqueError, "Invalid time value");
         return NULL;
     }
+    return PyDateTimeAPI->Time_FromTime(hour % 24, minute, second, usec,
+                                       Py_None, PyDateTimeAPI->TimeType);
+}
 
-    end = data + len;
-
-    data += pos;
-
-    if (data[0] == '.') {
-        // read microseconds (max 6 digits)
-        count = sscanf(data, ".%6u%n", &usec, &pos);
-        if (count != 1) {
-            PyErr_SetString(PoqueError, "Invalid time value");
-            return NULL;
-        }
-        for (int i = pos; i < 7; i++) {
-            // multiply by 10 for every missing digit
-            usec *= 10;
-        }
-        data += pos;
-    }
-
-    if (data[0] == '+' || data[0] == '-') {
-        // read timezone
-        unsigned int tz_hour, tz_minute=0, tz_second=0;
 
-        data++;
+static PyObject *
+timetz_strval(
+    PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+{
+    int hour, minute, second, usec, offset;
+    char *p, *end = data + len;
+    PyObject *tz, *time_val;
 
-        PyObject *tz_offset;
-        count = sscanf(
-                data, "%2u:%2u:%2u%n", &tz_hour, &tz_minute, &tz_second, &pos);
-        if (count == 0 || tz_hour > 24 || tz_minute > 59 || tz_second > 59) {
-            PyErr_SetString(PoqueError, "Invalid time value");
-            return NULL;
-        }
-        tz_second = tz_hour * 3600 + tz_minute * 60 + tz_second;
-        if (data[0] == '+') {
-            tz_second = -(tz_second);
-        }
-        tz_offset = PyDelta_FromDSU(0, tz_second, 0);
-        if (tz_offset == NULL)
-            return NULL;
-        tz_type = load_python_object("datetime", "timezone");
-        if (tz_type == NULL) {
-            Py_DECREF(tz_offset);
-            return NULL;
-        }
-        tz = PyObject_CallFunctionObjArgs(tz_type, tz_offset, NULL);
-        Py_DECREF(tz_offset);
-        Py_DECREF(tz_type);
-        if (tz == NULL)
-            return NULL;
-        data += pos;
+    p = read_time(data, end, &hour, &minute, &second, &usec);
+    if (p == NULL || read_tz(p, end, &offset) != end) {
+        PyErr_SetString(PoqueError, "Invalid timetz value");
+        return NULL;
     }
-    else {
-        tz = Py_None;
-        Py_INCREF(tz);
+    if (offset % 60 != 0) {
+        // Python timezone only accepts offset in whole minutes, same as the
+        // binary reader return the string instead
+        return text_val(result, data, len, NULL);
     }
-
-    if (end != data) {
-        PyErr_SetString(PoqueError, "Invalid time value");
-        Py_DECREF(tz);
+    tz = timezone_from_offset(offset);
+    if (tz == NULL) {
         return NULL;
     }
-    hour = hour % 24;
-    time_val = PyDateTimeAPI->Time_FromTime(hour, minute, second, usec, tz,
-                                            PyDateTimeAPI->TimeType);
+    time_val = PyDateTimeAPI->Time_FromTime(hour % 24, minute, second, usec,
+                                            tz, PyDateTimeAPI->TimeType);
     Py_DECREF(tz);
     return time_val;
 }
@@ -441,7 +666,7 @@ static PyObject *
 timetz_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
     int hour, minute, second, usec;
-    PyObject *tz, *ret, *offset, *tzone;
+    PyObject *ret, *tzone;
     PY_INT64_T value;
     int tz_seconds;
 
@@ -481,18 +706,7 @@ timetz_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_ha
             tz_sign, tz_hour, tz_seconds / 60, tz_seconds % 60);
 	}
 
-    offset = PyDelta_FromDSU(0, -tz_seconds, 0);
-    if (offset == NULL)
-        return NULL;
-
-    tz = load_python_object("datetime", "timezone");
-    if (tz == NULL) {
-        Py_DECREF(offset);
-        return NULL;
-    }
-    tzone = PyObject_CallFunctionObjArgs(tz, offset, NULL);
-    Py_DECREF(offset);
-    Py_DECREF(tz);
+    tzone = timezone_from_offset(-tz_seconds);
     if (tzone == NULL)
         return NULL;
 
@@ -504,20 +718,14 @@ timetz_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_ha
 
 
 static PyObject *
-_timestamp_binval(char *data, int len, PyObject *tz)
+timestamp_from_value(PY_INT64_T value, PyObject *tz)
 {
-    PY_INT64_T value, time;
+    /* Creates a datetime from microseconds since the PG epoch */
+    PY_INT64_T time;
     PY_INT32_T date;
     int year, month, day, hour, minute, second, usec;
     char usec_str[8], *bc_str, *tz_str;
 
-	if (len != 8) {
-        PyErr_SetString(PoqueError, "Invalid timestamp value");
-        return NULL;
-	}
-
-	value = read_int64(data);
-
     if (value == PY_LLONG_MAX)
         return PyUnicode_FromString("infinity");
     if (value == PY_LLONG_MIN)
@@ -573,11 +781,41 @@ _timestamp_binval(char *data, int len, PyObject *tz)
 }
 
 
+static PyObject *
+timestamptz_from_value(PoqueResult *result, PY_INT64_T value)
+{
+    /* Creates an aware datetime from UTC microseconds since the PG epoch */
+    PyObject *tz, *dt, *ret;
+    _Py_IDENTIFIER(fromutc);
+
+    if (!result->conn->session_timezone) {
+        return timestamp_from_value(value, utc);
+    }
+
+    /* convert to the session time zone */
+    tz = session_timezone(result->conn);
+    if (tz == NULL) {
+        return NULL;
+    }
+    dt = timestamp_from_value(value, tz);
+    if (dt == NULL || !PyDateTime_Check(dt) || tz == utc) {
+        return dt;
+    }
+    ret = _PyObject_CallMethodIdObjArgs(tz, &PyId_fromutc, dt, NULL);
+    Py_DECREF(dt);
+    return ret;
+}
+
+
 static PyObject *
 timestamp_binval(
     PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
-    return _timestamp_binval(data, len, Py_None);
+	if (len != 8) {
+        PyErr_SetString(PoqueError, "Invalid timestamp value");
+        return NULL;
+	}
+    return timestamp_from_value(read_int64(data), Py_None);
 }
 
 
@@ -585,24 +823,108 @@ static PyObject *
 timestamptz_binval(
     PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
-    return _timestamp_binval(data, len, utc);
+	if (len != 8) {
+        PyErr_SetString(PoqueError, "Invalid timestamp value");
+        return NULL;
+	}
+    return timestamptz_from_value(result, read_int64(data));
 }
 
 
-static PyObject *
-interval_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
+static char *
+read_timestamp(char *p, char *end, int *year, int *month, int *day,
+               PY_INT64_T *time)
 {
-    PY_INT64_T secs, usecs;
-    PY_INT32_T days, months;
-    PyObject *interval, *value;
+    /* reads 'YYYY-MM-DD HH:MM:SS[.ffffff]' with the time as microseconds */
+    int hour, minute, second, usec;
 
-	if (len != 16) {
-        PyErr_SetString(PoqueError, "Invalid interval value");
+    p = read_date(p, end, year, month, day);
+    if (p == NULL || p == end || *p != ' ') {
         return NULL;
-	}
-	usecs = read_int64(data);
-	days = read_int32(data + 8);
-	months = read_int32(data + 12);
+    }
+    p = read_time(p + 1, end, &hour, &minute, &second, &usec);
+    if (p != NULL) {
+        *time = (hour * USECS_PER_HOUR + minute * USECS_PER_MINUTE +
+                 second * USECS_PER_SEC + usec);
+    }
+    return p;
+}
+
+
+static PyObject *
+timestamp_strval(
+    PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
+{
+    int year, month, day;
+    PY_INT64_T time;
+    char *p, *end = data + len;
+
+    p = read_timestamp(data, end, &year, &month, &day, &time);
+    if (p == NULL) {
+        if (len && data[0] != '-' && (data[0] < '0' || data[0] > '9')) {
+            // infinity or another DateStyle
+            return text_val(result, data, len, NULL);
+        }
+        return datetime_strval_other(result, data, len, "timestamp");
+    }
+    if (p != end) {
+        if (end - p != 3 || memcmp(p, " BC", 3) != 0) {
+            return datetime_strval_other(result, data, len, "timestamp");
+        }
+        return text_val(result, data, len, NULL);
+    }
+    if (year < min_year || year > max_year) {
+        // same as the string the binary reader creates
+        return text_val(result, data, len, NULL);
+    }
+    return timestamp_from_value(
+        ymd_to_pgordinal(year, month, day) * USECS_PER_DAY + time, Py_None);
+}
+
+
+static PyObject *
+timestamptz_strval(
+    PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
+{
+    /* The text value is in the session time zone, it is converted to a UTC
+     * value first, so the result is the same as the binary one.
+     */
+    int year, month, day, offset;
+    PY_INT64_T time;
+    char *p, *end = data + len;
+
+    p = read_timestamp(data, end, &year, &month, &day, &time);
+    if (p != NULL) {
+        p = read_tz(p, end, &offset);
+    }
+    if (p == NULL) {
+        if (len && data[0] != '-' && (data[0] < '0' || data[0] > '9')) {
+            // infinity or another DateStyle
+            return text_val(result, data, len, NULL);
+        }
+        return datetime_strval_other(result, data, len, "timestamptz");
+    }
+    if (p != end) {
+        if (end - p != 3 || memcmp(p, " BC", 3) != 0) {
+            return datetime_strval_other(result, data, len, "timestamptz");
+        }
+        return text_val(result, data, len, NULL);
+    }
+    if (year < min_year || year > max_year) {
+        return text_val(result, data, len, NULL);
+    }
+    return timestamptz_from_value(
+        result, ymd_to_pgordinal(year, month, day) * USECS_PER_DAY + time -
+        offset * USECS_PER_SEC);
+}
+
+
+static PyObject *
+interval_from_values(PY_INT32_T months, PY_INT32_T days, PY_INT64_T usecs)
+{
+    /* Creates the tuple of months and timedelta */
+    PY_INT64_T secs, total_days;
+    PyObject *interval, *value;
 
 	interval = PyTuple_New(2);
     if (interval == NULL)
@@ -615,7 +937,15 @@ interval_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_
     PyTuple_SET_ITEM(interval, 0, value);
     secs = usecs / USECS_PER_SEC;
     usecs -= secs * USECS_PER_SEC;
-    value = PyDelta_FromDSU(days, secs, usecs);
+    /* move whole days out of the seconds, which must fit in an int */
+    total_days = days + secs / 86400;
+    secs %= 86400;
+    if (total_days > INT_MAX || total_days < INT_MIN) {
+        Py_DECREF(interval);
+        PyErr_SetString(PyExc_OverflowError, "Interval out of range");
+        return NULL;
+    }
+    value = PyDelta_FromDSU((int)total_days, (int)secs, (int)usecs);
     if (value == NULL) {
         Py_DECREF(interval);
         return NULL;
@@ -625,6 +955,119 @@ interval_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_
 }
 
 
+static PyObject *
+interval_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
+{
+	if (len != 16) {
+        PyErr_SetString(PoqueError, "Invalid interval value");
+        return NULL;
+	}
+    return interval_from_values(
+        read_int32(data + 12), read_int32(data + 8), read_int64(data));
+}
+
+
+static char *
+read_interval_number(char *p, char *end, PY_INT64_T *val)
+{
+    /* reads an optionally signed number of at most 10 digits */
+    PY_INT64_T v = 0;
+    int neg = 0, n = 0;
+
+    if (p < end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        p++;
+    }
+    while (p < end && n < 10 && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        p++;
+        n++;
+    }
+    if (n == 0) {
+        return NULL;
+    }
+    *val = neg ? -v : v;
+    return p;
+}
+
+
+static PyObject *
+interval_strval(
+    PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
+{
+    /* Parses the default 'postgres' IntervalStyle, for example
+     * '-1 years +2 mons 3 days -04:05:06.5'
+     */
+    PY_INT64_T months = 0, days = 0, usecs = 0, val;
+    char *p = data, *end = data + len;
+    const char *style;
+
+    while (p < end) {
+        char *unit;
+        int neg, minute, second, usec;
+
+        neg = (*p == '-');
+        p = read_interval_number(p, end, &val);
+        if (p == NULL || p == end) {
+            goto other;
+        }
+        if (*p == ':') {
+            // time part, the hours are not limited to a day
+            PY_INT64_T time;
+
+            p = read_digits(p + 1, end, 2, 2, &minute);
+            if (p == NULL || p == end || *p != ':') {
+                goto other;
+            }
+            p = read_digits(p + 1, end, 2, 2, &second);
+            if (p == NULL || (p = read_fraction(p, end, &usec)) != end) {
+                goto other;
+            }
+            time = ((neg ? -val : val) * USECS_PER_HOUR +
+                    minute * USECS_PER_MINUTE + second * USECS_PER_SEC + usec);
+            usecs += neg ? -time : time;
+            break;
+        }
+        if (*p != ' ') {
+            goto other;
+        }
+        unit = ++p;
+        while (p < end && *p != ' ') {
+            p++;
+        }
+        if (p - unit >= 3 && memcmp(unit, "mon", 3) == 0) {
+            months += val;
+        }
+        else if (p - unit >= 4 && memcmp(unit, "year", 4) == 0) {
+            months += val * 12;
+        }
+        else if (p - unit >= 3 && memcmp(unit, "day", 3) == 0) {
+            days += val;
+        }
+        else {
+            goto other;
+        }
+        if (p < end) {
+            p++;
+        }
+    }
+    if (months < INT32_MIN || months > INT32_MAX || days < INT32_MIN ||
+            days > INT32_MAX) {
+        goto other;
+    }
+    return interval_from_values(
+        (PY_INT32_T)months, (PY_INT32_T)days, usecs);
+
+other:
+    style = PQparameterStatus(result->conn->conn, "IntervalStyle");
+    if (style != NULL && strcmp(style, "postgres") == 0) {
+        PyErr_SetString(PoqueError, "Invalid interval value");
+        return NULL;
+    }
+    return text_val(result, data, len, NULL);
+}
+
+
 static PyObject *
 abstime_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
@@ -689,15 +1132,17 @@ tinterval_binval(
     return tinterval;
 }
 
-PoqueValueHandler date_val_handler = {{date_strval, date_binval}, ',', NULL};
+PoqueValueHandler date_val_handler = {
+        {date_strval, date_binval}, ',', NULL, {NULL, NULL}, 1};
 PoqueValueHandler time_val_handler = {{time_strval, time_binval}, ',', NULL};
-PoqueValueHandler timetz_val_handler = {{text_val, timetz_binval}, ',', NULL};
+PoqueValueHandler timetz_val_handler = {
+        {timetz_strval, timetz_binval}, ',', NULL};
 PoqueValueHandler timestamp_val_handler = {
-        {text_val, timestamp_binval}, ',', NULL};
+        {timestamp_strval, timestamp_binval}, ',', NULL, {NULL, NULL}, 1};
 PoqueValueHandler timestamptz_val_handler = {
-        {text_val, timestamptz_binval}, ',', NULL};
+        {timestamptz_strval, timestamptz_binval}, ',', NULL, {NULL, NULL}, 1};
 PoqueValueHandler interval_val_handler = {
-        {text_val, interval_binval}, ',', NULL};
+        {interval_strval, interval_binval}, ',', NULL};
 PoqueValueHandler abstime_val_handler = {
         {text_val, abstime_binval}, ',', NULL};
 PoqueValueHandler reltime_val_handler = {
@@ -710,13 +1155,13 @@ PoqueValueHandler datearray_val_handler = {
 PoqueValueHandler timearray_val_handler = {
         {array_strval, array_binval}, ',', &time_val_handler};
 PoqueValueHandler timetzarray_val_handler = {
-        {text_val, array_binval}, ',', &timetz_val_handler};
+        {array_strval, array_binval}, ',', &timetz_val_handler};
 PoqueValueHandler timestamparray_val_handler = {
-        {text_val, array_binval}, ',', &timestamp_val_handler};
+        {array_strval, array_binval}, ',', &timestamp_val_handler};
 PoqueValueHandler timestamptzarray_val_handler = {
-        {text_val, array_binval}, ',', &timestamptz_val_handler};
+        {array_strval, array_binval}, ',', &timestamptz_val_handler};
 PoqueValueHandler intervalarray_val_handler = {
-        {text_val, array_binval}, ',', &interval_val_handler};
+        {array_strval, array_binval}, ',', &interval_val_handler};
 PoqueValueHandler abstimearray_val_handler = {
         {text_val, array_binval}, ',', &abstime_val_handler};
 PoqueValueHandler reltimearray_val_handler = {
@@ -0,0 +1,229 @@
+#include "encoded.h"
+
+
+PyObject *
+Encoded_FromValue(PyObject *value, PoqueConn *conn)
+{
+    /* Encodes a value with its parameter handler into a new Encoded object.
+     * With a connection, the handler is chosen like for its parameters, so
+     * types registered on the connection are taken into account.
+     */
+    param_handler *handler;
+    PoqueEncoded *self = NULL;
+    char *data;
+    int size;
+
+    if (Py_TYPE(value) == &PoqueEncodedType) {
+        Py_INCREF(value);
+        return value;
+    }
+    if (value == Py_None) {
+        PyErr_SetString(PyExc_TypeError, "None can not be encoded");
+        return NULL;
+    }
+
+    if (conn != NULL) {
+        handler = _Conn_param_handler(conn, value);
+    }
+    else if (Py_TYPE(value) == &PoqueVectorType) {
+        /* the vector oids are only known to a registered connection */
+        PyErr_SetString(
+            PyExc_TypeError, "Vector values are encoded by Conn.encode");
+        return NULL;
+    }
+    else {
+        handler = get_param_handler_constructor(Py_TYPE(value))(1);
+    }
+    if (handler == NULL) {
+        return NULL;
+    }
+    size = PH_Examine(handler, value);
+    if (size < 0) {
+        goto end;
+    }
+    self = PyObject_NewVar(PoqueEncoded, &PoqueEncodedType, size);
+    if (self == NULL) {
+        goto end;
+    }
+    self->oid = PH_Oid(handler);
+    self->array_oid = handler->array_oid;
+    self->format = FORMAT_BINARY;
+
+    if (PH_HasEncode(handler)) {
+        /* the handler points to the value, copy it */
+        if (PH_EncodeValue(handler, value, &data) < 0) {
+            Py_CLEAR(self);
+            goto end;
+        }
+        memcpy(self->data, data, size);
+    }
+    else if (PH_EncodeValueAt(handler, value, self->data) < 0) {
+        Py_CLEAR(self);
+    }
+
+end:
+    if (PH_HasFree(handler)) {
+        PH_Free(handler);
+    }
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+Encoded_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"value", NULL};
+    PyObject *value;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &value)) {
+        return NULL;
+    }
+    return Encoded_FromValue(value, NULL);
+}
+
+
+static PyObject *
+Encoded_repr(PoqueEncoded *self)
+{
+    return PyUnicode_FromFormat(
+        "Encoded(oid=%u, size=%zd)", self->oid, Py_SIZE(self));
+}
+
+
+static PyObject *
+Encoded_get_data(PoqueEncoded *self, void *unused)
+{
+    return PyBytes_FromStringAndSize(self->data, Py_SIZE(self));
+}
+
+
+static PyObject *
+Encoded_get_oid(PoqueEncoded *self, void *unused)
+{
+    return PyLong_FromUnsignedLong(self->oid);
+}
+
+
+static PyObject *
+Encoded_get_format(PoqueEncoded *self, void *unused)
+{
+    return PyLong_FromLong(self->format);
+}
+
+
+static PyGetSetDef Encoded_getset[] = {{
+        "oid", (getter)Encoded_get_oid, NULL,
+        PyDoc_STR("pg type oid of the value"), NULL
+    }, {
+        "format", (getter)Encoded_get_format, NULL,
+        PyDoc_STR("format of the value, 0 for text, 1 for binary"), NULL
+    }, {
+        "data", (getter)Encoded_get_data, NULL,
+        PyDoc_STR("the encoded value"), NULL
+    }, {
+        NULL
+}};
+
+
+PyTypeObject PoqueEncodedType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.Encoded",                            /* tp_name */
+    offsetof(PoqueEncoded, data),               /* tp_basicsize */
+    1,                                          /* tp_itemsize */
+    0,                                          /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)Encoded_repr,                     /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    "Parameter value encoded once to send many times",  /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    0,                                          /* tp_members */
+    Encoded_getset,                             /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    Encoded_new,                                /* tp_new */
+};
+
+
+/* ==== parameter handler ================================================== */
+
+/* Encoded values can also be items of a list. All items must have the same
+ * type.
+ */
+
+static int
+encoded_examine(param_handler *handler, PyObject *param)
+{
+    PoqueEncoded *enc = (PoqueEncoded *)param;
+
+    if (handler->oid != InvalidOid && handler->oid != enc->oid) {
+        PyErr_SetString(PyExc_ValueError, "Can not mix types");
+        return -1;
+    }
+    handler->oid = enc->oid;
+    handler->array_oid = enc->array_oid;
+    return Encoded_SIZE(param);
+}
+
+
+static int
+encoded_encode(param_handler *handler, PyObject *param, char **loc)
+{
+    *loc = Encoded_DATA(param);
+    return 0;
+}
+
+
+static int
+encoded_encode_at(param_handler *handler, PyObject *param, char *loc)
+{
+    memcpy(loc, Encoded_DATA(param), Encoded_SIZE(param));
+    return Encoded_SIZE(param);
+}
+
+
+static param_handler *
+new_encoded_param_handler(int num_param)
+{
+    static param_handler def_handler = {
+        encoded_examine,            /* examine */
+        NULL,                       /* total_size */
+        encoded_encode,             /* encode */
+        encoded_encode_at,          /* encode_at */
+        (ph_free)PyMem_Free,        /* free */
+        InvalidOid,                 /* oid */
+        InvalidOid                  /* array_oid */
+    }; /* static initialized handler */
+
+    return new_param_handler(&def_handler, sizeof(param_handler));
+}
+
+
+int
+init_encoded(void)
+{
+    register_parameter_handler(&PoqueEncodedType, new_encoded_param_handler);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef _POQUE_ENCODED_H_
+#define _POQUE_ENCODED_H_
+
+#include "poque_type.h"
+
+/* A parameter value that has been run through its parameter handler once.
+ * It holds the wire representation, so it can be sent any number of times
+ * without examining and encoding it again.
+ */
+typedef struct {
+    PyObject_VAR_HEAD           /* ob_size is the size of the value */
+    Oid oid;
+    Oid array_oid;
+    int format;
+    char data[1];
+} PoqueEncoded;
+
+#define Encoded_DATA(o) (((PoqueEncoded *)(o))->data)
+#define Encoded_SIZE(o) ((int)Py_SIZE(o))
+
+PyObject *Encoded_FromValue(PyObject *value, PoqueConn *conn);
+int init_encoded(void);
+
+#endif
@@ -1,7 +1,283 @@
-#include "poque_type.h"
+#include "geometric.h"
+#include "buffer.h"
 #include "text.h"
 
 
+/* ==== Path and Polygon =================================================== */
+
+/* Paths and polygons that keep their points in a buffer of float64 x, y
+ * pairs, so large geometries need no Python objects per vertex. The buffer
+ * protocol is forwarded to the points.
+ */
+typedef struct {
+    PyObject_HEAD
+    PyObject *points;   /* buffer of float64 x, y pairs */
+    char closed;        /* always true for polygons */
+} PoqueGeometry;
+
+
+static Py_ssize_t
+geometry_get_points(PyObject *points, Py_buffer *view)
+{
+    /* Gets the points buffer and returns the number of points */
+    const char *format;
+
+    if (PyObject_GetBuffer(
+            points, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1) {
+        return -1;
+    }
+    format = view->format;
+    if (format[0] == '@' || format[0] == '=') {
+        format++;
+    }
+    if (view->itemsize != 8 || strcmp(format, "d") != 0) {
+        PyErr_SetString(
+            PyExc_ValueError, "Points must be a buffer of float64 values");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (view->len % 16 || view->len / 16 > INT_MAX / 16) {
+        PyErr_SetString(PyExc_ValueError, "Invalid number of points");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return view->len / 16;
+}
+
+
+static PyObject *
+Geometry_create(PyTypeObject *type, PyObject *points, int closed)
+{
+    PoqueGeometry *self;
+
+    self = (PoqueGeometry *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    Py_INCREF(points);
+    self->points = points;
+    self->closed = (char)closed;
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+Geometry_init_new(PyTypeObject *type, PyObject *points, int closed)
+{
+    Py_buffer view;
+
+    /* check the points up front */
+    if (geometry_get_points(points, &view) == -1) {
+        return NULL;
+    }
+    PyBuffer_Release(&view);
+    return Geometry_create(type, points, closed);
+}
+
+
+static PyObject *
+Path_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"points", "closed", NULL};
+    PyObject *points;
+    int closed = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "O|p", kwlist, &points, &closed)) {
+        return NULL;
+    }
+    return Geometry_init_new(type, points, closed);
+}
+
+
+static PyObject *
+Polygon_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"points", NULL};
+    PyObject *points;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O", kwlist, &points)) {
+        return NULL;
+    }
+    return Geometry_init_new(type, points, 1);
+}
+
+
+static PyObject *
+Path_repr(PoqueGeometry *self)
+{
+    return PyUnicode_FromFormat(
+        "Path(%R, closed=%s)", self->points, self->closed ? "True" : "False");
+}
+
+
+static PyObject *
+Polygon_repr(PoqueGeometry *self)
+{
+    return PyUnicode_FromFormat("Polygon(%R)", self->points);
+}
+
+
+static Py_ssize_t
+Geometry_length(PoqueGeometry *self)
+{
+    Py_buffer view;
+    Py_ssize_t npoints;
+
+    npoints = geometry_get_points(self->points, &view);
+    if (npoints != -1) {
+        PyBuffer_Release(&view);
+    }
+    return npoints;
+}
+
+
+static int
+Geometry_GetBuffer(PoqueGeometry *self, Py_buffer *view, int flags)
+{
+    return PyObject_GetBuffer(self->points, view, flags);
+}
+
+
+static int
+Geometry_traverse(PoqueGeometry *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->points);
+    return 0;
+}
+
+
+static int
+Geometry_clear(PoqueGeometry *self)
+{
+    Py_CLEAR(self->points);
+    return 0;
+}
+
+
+static void
+Geometry_dealloc(PoqueGeometry *self)
+{
+    PyObject_GC_UnTrack(self);
+    Geometry_clear(self);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+static PyBufferProcs Geometry_BufProcs = {
+    (getbufferproc)Geometry_GetBuffer,
+    NULL
+};
+
+
+static PySequenceMethods Geometry_as_sequence = {
+    (lenfunc)Geometry_length,                   /* sq_length */
+};
+
+
+static PyMemberDef Path_members[] = {
+    {"points", T_OBJECT, offsetof(PoqueGeometry, points), READONLY,
+     "buffer with float64 x, y pairs"},
+    {"closed", T_BOOL, offsetof(PoqueGeometry, closed), READONLY,
+     "whether the path is closed"},
+    {NULL}  /* Sentinel */
+};
+
+
+static PyMemberDef Polygon_members[] = {
+    {"points", T_OBJECT, offsetof(PoqueGeometry, points), READONLY,
+     "buffer with float64 x, y pairs"},
+    {NULL}  /* Sentinel */
+};
+
+
+PyTypeObject PoquePathType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.Path",                               /* tp_name */
+    sizeof(PoqueGeometry),                      /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)Geometry_dealloc,               /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)Path_repr,                        /* tp_repr */
+    0,                                          /* tp_as_number */
+    &Geometry_as_sequence,                      /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    &Geometry_BufProcs,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "Path with its points in a float64 buffer", /* tp_doc */
+    (traverseproc)Geometry_traverse,            /* tp_traverse */
+    (inquiry)Geometry_clear,                    /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    Path_members,                               /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    Path_new,                                   /* tp_new */
+};
+
+
+PyTypeObject PoquePolygonType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.Polygon",                            /* tp_name */
+    sizeof(PoqueGeometry),                      /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)Geometry_dealloc,               /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)Polygon_repr,                     /* tp_repr */
+    0,                                          /* tp_as_number */
+    &Geometry_as_sequence,                      /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    &Geometry_BufProcs,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "Polygon with its points in a float64 buffer",  /* tp_doc */
+    (traverseproc)Geometry_traverse,            /* tp_traverse */
+    (inquiry)Geometry_clear,                    /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    Polygon_members,                            /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    Polygon_new,                                /* tp_new */
+};
+
+
+/* ==== geometric values =================================================== */
+
+
 static int
 add_float_to_tuple(PyObject *tup, char *data, int idx)
 {
@@ -84,32 +360,61 @@ lseg_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 }
 
 
-static PyObject *
-polygon_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+static char *
+points_header(char *data, int len, PY_INT32_T *npoints)
 {
-    PyObject *points;
-    PY_INT32_T npoints, i;
-
+    /* Reads the number of points and returns the location of the points */
     if (len < 4) {
         PyErr_SetString(PoqueError, "Invalid polygon value");
         return NULL;
     }
 
-    npoints = read_int32(data);
-    if (npoints < 0) {
+    *npoints = read_int32(data);
+    if (*npoints < 0) {
         PyErr_SetString(PoqueError, "Path length can not be less than zero");
         return NULL;
     }
-    if (len != 4 + npoints * 16) {
+    if (len != 4 + (Py_ssize_t)*npoints * 16) {
         PyErr_SetString(PoqueError, "Invalid polygon value");
         return NULL;
     }
+    return data + 4;
+}
+
+
+static PyObject *
+points_buffer(char *data, PY_INT32_T npoints)
+{
+    /* Creates an N x 2 float64 ArrayBuffer of the points */
+    PoqueArrayBuffer *buf;
+    Py_ssize_t shape[2], i;
+    char *dest;
+
+    shape[0] = npoints;
+    shape[1] = 2;
+    buf = ArrayBuffer_New("d", 8, 2, shape);
+    if (buf == NULL) {
+        return NULL;
+    }
+    dest = ArrayBuffer_DATA(buf);
+    for (i = 0; i < 2 * (Py_ssize_t)npoints; i++) {
+        PY_UINT64_T val = read_uint64(data + 8 * i);
+        memcpy(dest + 8 * i, &val, 8);
+    }
+    return (PyObject *)buf;
+}
+
+
+static PyObject *
+points_list(PoqueResult *result, char *data, PY_INT32_T npoints)
+{
+    PyObject *points;
+    PY_INT32_T i;
 
     points = PyList_New(npoints);
     if (points == NULL) {
         return NULL;
     }
-    data += 4;
     for (i = 0; i < npoints; i++) {
         PyObject *point;
 
@@ -124,27 +429,67 @@ polygon_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unus
 }
 
 
+static PyObject *
+polygon_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+{
+    PyObject *points, *polygon;
+    PY_INT32_T npoints;
+
+    data = points_header(data, len, &npoints);
+    if (data == NULL) {
+        return NULL;
+    }
+    if (result->conn->geometry_as != GEOMETRY_AS_BUFFER) {
+        return points_list(result, data, npoints);
+    }
+    points = points_buffer(data, npoints);
+    if (points == NULL) {
+        return NULL;
+    }
+    polygon = Geometry_create(&PoquePolygonType, points, 1);
+    Py_DECREF(points);
+    return polygon;
+}
+
+
 static PyObject *
 path_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 {
     PyObject *path, *points, *closed;
+    PY_INT32_T npoints;
+    int is_closed;
 
     if (len == 0) {
         PyErr_SetString(PoqueError, "Invalid path value");
         return NULL;
     }
-    closed = PyBool_FromLong(data[0]);
+    is_closed = data[0];
+
+    data = points_header(data + 1, len - 1, &npoints);
+    if (data == NULL) {
+        return NULL;
+    }
+    if (result->conn->geometry_as == GEOMETRY_AS_BUFFER) {
+        points = points_buffer(data, npoints);
+        if (points == NULL) {
+            return NULL;
+        }
+        path = Geometry_create(&PoquePathType, points, is_closed);
+        Py_DECREF(points);
+        return path;
+    }
 
-    points = polygon_binval(result, data + 1, len -1, NULL);
+    points = points_list(result, data, npoints);
     if (points == NULL) {
-        Py_DECREF(closed);
         return NULL;
     }
+    closed = PyBool_FromLong(is_closed);
 
     path = PyDict_New();
     if (path == NULL) {
         Py_DECREF(closed);
         Py_DECREF(points);
+        return NULL;
     }
 
     if ((PyDict_SetItemString(path, "closed", closed) < 0) ||
@@ -186,6 +531,133 @@ circle_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unuse
 }
 
 
+/* ==== Path and Polygon parameters ======================================== */
+
+typedef struct _GeometryParam {
+    Py_buffer points;       /* held until the handler is freed */
+    PY_INT32_T npoints;
+} GeometryParam;
+
+
+typedef struct _GeometryParamHandler {
+    param_handler handler;      /* base handler */
+    int num_params;             /* number of parameters */
+    int examine_pos;            /* where to examine next */
+    int encode_pos;             /* where to encode next */
+    GeometryParam params[];     /* parameter cache */
+} GeometryParamHandler;
+
+
+static int
+geometry_examine(GeometryParamHandler *handler, PyObject *param)
+{
+    PoqueGeometry *geom = (PoqueGeometry *)param;
+    GeometryParam *gp;
+    Py_ssize_t npoints;
+
+    gp = &handler->params[handler->examine_pos];
+    npoints = geometry_get_points(geom->points, &gp->points);
+    if (npoints == -1) {
+        return -1;
+    }
+    handler->examine_pos++;
+    gp->npoints = (PY_INT32_T)npoints;
+
+    /* paths start with the closed flag */
+    return (handler->handler.oid == PATHOID) + 4 + (int)npoints * 16;
+}
+
+
+static int
+geometry_encode_at(GeometryParamHandler *handler, PyObject *param, char *loc)
+{
+    PoqueGeometry *geom = (PoqueGeometry *)param;
+    GeometryParam *gp;
+    const char *src;
+    char *start = loc;
+    Py_ssize_t i;
+
+    gp = current_encode_param(handler);
+    if (handler->handler.oid == PATHOID) {
+        *loc++ = geom->closed;
+    }
+    write_uint32(&loc, gp->npoints);
+    src = gp->points.buf;
+    for (i = 0; i < 2 * (Py_ssize_t)gp->npoints; i++) {
+        PY_UINT64_T val;
+
+        memcpy(&val, src + 8 * i, 8);
+        put_uint64(loc + 8 * i, val);
+    }
+    return (int)(loc - start) + gp->npoints * 16;
+}
+
+
+static void
+geometry_free(GeometryParamHandler *handler)
+{
+    int i;
+
+    for (i = 0; i < handler->examine_pos; i++) {
+        PyBuffer_Release(&handler->params[i].points);
+    }
+    PyMem_Free(handler);
+}
+
+
+static param_handler *
+new_geometry_param_handler(int num_params, Oid oid, Oid array_oid)
+{
+    static GeometryParamHandler def_handler = {{
+            (ph_examine)geometry_examine,       /* examine */
+            NULL,                               /* total_size */
+            NULL,                               /* encode */
+            (ph_encode_at)geometry_encode_at,   /* encode_at */
+            (ph_free)geometry_free,             /* free */
+            InvalidOid,                         /* oid */
+            InvalidOid                          /* array_oid */
+        },
+        0,                                      /* num_params */
+        0,                                      /* examine_pos */
+        0                                       /* encode_pos */
+    }; /* static initialized handler */
+    param_handler *handler;
+
+    handler = new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(GeometryParamHandler),
+        num_params, sizeof(GeometryParam));
+    if (handler != NULL) {
+        handler->oid = oid;
+        handler->array_oid = array_oid;
+    }
+    return handler;
+}
+
+
+static param_handler *
+new_path_param_handler(int num_params)
+{
+    return new_geometry_param_handler(num_params, PATHOID, PATHARRAYOID);
+}
+
+
+static param_handler *
+new_polygon_param_handler(int num_params)
+{
+    return new_geometry_param_handler(
+        num_params, POLYGONOID, POLYGONARRAYOID);
+}
+
+
+int
+init_geometric(void)
+{
+    register_parameter_handler(&PoquePathType, new_path_param_handler);
+    register_parameter_handler(&PoquePolygonType, new_polygon_param_handler);
+    return 0;
+}
+
+
 PoqueValueHandler point_val_handler = {{text_val, point_binval}, ',', NULL};
 PoqueValueHandler line_val_handler = {{text_val, line_binval}, ',', NULL};
 PoqueValueHandler lseg_val_handler = {{text_val, lseg_binval}, ',', NULL};
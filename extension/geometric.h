@@ -1,6 +1,8 @@
 #ifndef _POQUE_GEOMETRIC_H_
 #define _POQUE_GEOMETRIC_H_
 
+#include "poque_type.h"
+
 extern PoqueValueHandler point_val_handler;
 extern PoqueValueHandler line_val_handler;
 extern PoqueValueHandler lseg_val_handler;
@@ -17,4 +19,6 @@ extern PoqueValueHandler boxarray_val_handler;
 extern PoqueValueHandler polygonarray_val_handler;
 extern PoqueValueHandler circlearray_val_handler;
 
+int init_geometric(void);
+
 #endif
@@ -0,0 +1,289 @@
+#include "hstore.h"
+#include "text.h"
+
+
+/* ==== hstore values ======================================================= */
+
+static PyObject *
+hstore_str_binval(char **data, int *len)
+{
+    /* reads a length prefixed string, None for a length of -1 */
+    PY_INT32_T str_len;
+    PyObject *val;
+
+    CHECK_LENGTH_LT(*len, 4, "hstore", NULL);
+    str_len = read_int32(*data);
+    ADVANCE_DATA(*data, *len, 4);
+    if (str_len == -1) {
+        Py_RETURN_NONE;
+    }
+    if (str_len < 0 || str_len > *len) {
+        PyErr_SetString(PoqueError, "Invalid data for hstore type.");
+        return NULL;
+    }
+    val = PyUnicode_FromStringAndSize(*data, str_len);
+    ADVANCE_DATA(*data, *len, str_len);
+    return val;
+}
+
+
+static PyObject *
+hstore_binval(PoqueResult *result, char *data, int len,
+              PoqueValueHandler *unused)
+{
+    /* Reads the number of pairs followed by the keys and values */
+    PY_INT32_T num_pairs, i;
+    PyObject *dict, *key = NULL, *value = NULL;
+
+    CHECK_LENGTH_LT(len, 4, "hstore", NULL);
+    num_pairs = read_int32(data);
+    ADVANCE_DATA(data, len, 4);
+    if (num_pairs < 0 || num_pairs > len / 8) {
+        PyErr_SetString(PoqueError, "Invalid data for hstore type.");
+        return NULL;
+    }
+    dict = _PyDict_NewPresized(num_pairs);
+    if (dict == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < num_pairs; i++) {
+        key = hstore_str_binval(&data, &len);
+        if (key == NULL) {
+            goto error;
+        }
+        if (key == Py_None) {
+            PyErr_SetString(PoqueError, "Invalid hstore key.");
+            goto error;
+        }
+        value = hstore_str_binval(&data, &len);
+        if (value == NULL || PyDict_SetItem(dict, key, value) == -1) {
+            goto error;
+        }
+        Py_CLEAR(key);
+        Py_CLEAR(value);
+    }
+    if (len != 0) {
+        PyErr_SetString(PoqueError, "Invalid data for hstore type.");
+        goto error;
+    }
+    return dict;
+
+error:
+    Py_XDECREF(key);
+    Py_XDECREF(value);
+    Py_DECREF(dict);
+    return NULL;
+}
+
+
+static char *
+hstore_skip_spaces(char *p, char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+
+static PyObject *
+hstore_str_strval(char **data, char *end, char *buf, int allow_null)
+{
+    /* Reads a quoted string with backslash escapes, or NULL when allowed */
+    char *p = *data;
+    int n = 0;
+
+    if (allow_null && end - p >= 4 && PyOS_strnicmp(p, "NULL", 4) == 0) {
+        *data = p + 4;
+        Py_RETURN_NONE;
+    }
+    if (p == end || *p != '"') {
+        PyErr_SetString(PoqueError, "Invalid hstore value");
+        return NULL;
+    }
+    for (p++; p < end && *p != '"'; p++) {
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+        }
+        buf[n++] = *p;
+    }
+    if (p == end) {
+        PyErr_SetString(PoqueError, "Invalid hstore value");
+        return NULL;
+    }
+    *data = p + 1;
+    return PyUnicode_FromStringAndSize(buf, n);
+}
+
+
+static PyObject *
+hstore_strval(PoqueResult *result, char *data, int len,
+              PoqueValueHandler *unused)
+{
+    /* Parses the "key"=>"value" pairs, separated by commas */
+    PyObject *dict, *key = NULL, *value = NULL;
+    char *p, *end, *buf;
+
+    dict = PyDict_New();
+    if (dict == NULL) {
+        return NULL;
+    }
+    buf = PyMem_Malloc(len);
+    if (buf == NULL) {
+        Py_DECREF(dict);
+        return PyErr_NoMemory();
+    }
+    end = data + len;
+    p = hstore_skip_spaces(data, end);
+    while (p < end) {
+        key = hstore_str_strval(&p, end, buf, 0);
+        if (key == NULL) {
+            goto error;
+        }
+        p = hstore_skip_spaces(p, end);
+        if (end - p < 2 || p[0] != '=' || p[1] != '>') {
+            PyErr_SetString(PoqueError, "Invalid hstore value");
+            goto error;
+        }
+        p = hstore_skip_spaces(p + 2, end);
+        value = hstore_str_strval(&p, end, buf, 1);
+        if (value == NULL || PyDict_SetItem(dict, key, value) == -1) {
+            goto error;
+        }
+        Py_CLEAR(key);
+        Py_CLEAR(value);
+        p = hstore_skip_spaces(p, end);
+        if (p < end) {
+            if (*p != ',') {
+                PyErr_SetString(PoqueError, "Invalid hstore value");
+                goto error;
+            }
+            p = hstore_skip_spaces(p + 1, end);
+        }
+    }
+    PyMem_Free(buf);
+    return dict;
+
+error:
+    PyMem_Free(buf);
+    Py_XDECREF(key);
+    Py_XDECREF(value);
+    Py_DECREF(dict);
+    return NULL;
+}
+
+
+PoqueValueHandler hstore_val_handler = {
+    {hstore_strval, hstore_binval}, ',', NULL};
+
+PoqueValueHandler hstorearray_val_handler = {
+    {array_strval, array_binval}, ',', &hstore_val_handler};
+
+
+/* ==== hstore parameter handler ============================================ */
+
+static Py_ssize_t
+hstore_str_size(PyObject *str)
+{
+    const char *direct;
+
+    if (str == Py_None) {
+        return 0;
+    }
+    if (!PyUnicode_Check(str)) {
+        PyErr_SetString(
+            PyExc_TypeError, "hstore keys and values must be str or None");
+        return -1;
+    }
+    return text_utf8_size(str, &direct);
+}
+
+
+static int
+hstore_examine(param_handler *handler, PyObject *param) {
+    /* Calculates the size of the pairs, checking their types on the way */
+    PyObject *key, *value;
+    Py_ssize_t pos = 0, size = 4, str_size;
+
+    while (PyDict_Next(param, &pos, &key, &value)) {
+        if (key == Py_None) {
+            PyErr_SetString(PyExc_TypeError, "hstore keys can not be None");
+            return -1;
+        }
+        str_size = hstore_str_size(key);
+        if (str_size < 0) {
+            return -1;
+        }
+        size += 8 + str_size;
+        str_size = hstore_str_size(value);
+        if (str_size < 0) {
+            return -1;
+        }
+        size += str_size;
+        if (size > INT32_MAX) {
+            PyErr_SetString(PyExc_ValueError, "hstore value too long");
+            return -1;
+        }
+    }
+    return (int)size;
+}
+
+
+static char *
+hstore_str_encode_at(PyObject *str, char *loc)
+{
+    /* writes the length and the UTF-8 data, or -1 for None */
+    const char *direct;
+    Py_ssize_t size;
+
+    if (str == Py_None) {
+        put_uint32(loc, (PY_UINT32_T)-1);
+        return loc + 4;
+    }
+    size = text_utf8_size(str, &direct);
+    if (direct) {
+        memcpy(loc + 4, direct, size);
+    }
+    else {
+        text_utf8_write(str, loc + 4);
+    }
+    put_uint32(loc, (PY_UINT32_T)size);
+    return loc + 4 + size;
+}
+
+
+static int
+hstore_encode_at(param_handler *handler, PyObject *param, char *loc) {
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    char *p = loc + 4;
+
+    put_uint32(loc, (PY_UINT32_T)PyDict_GET_SIZE(param));
+    while (PyDict_Next(param, &pos, &key, &value)) {
+        p = hstore_str_encode_at(key, p);
+        p = hstore_str_encode_at(value, p);
+    }
+    return (int)(p - loc);
+}
+
+
+param_handler *
+new_hstore_param_handler(Oid oid, Oid array_oid) {
+    static param_handler def_handler = {
+        (ph_examine)hstore_examine,         /* examine */
+        NULL,                               /* total_size */
+        NULL,                               /* encode */
+        (ph_encode_at)hstore_encode_at,     /* encode_at */
+        (ph_free)PyMem_Free,                /* free */
+        InvalidOid,                         /* oid */
+        InvalidOid                          /* array_oid */
+    }; /* static initialized handler */
+    param_handler *handler;
+
+    handler = new_param_handler(&def_handler, sizeof(param_handler));
+    if (handler != NULL) {
+        handler->oid = oid;
+        handler->array_oid = array_oid;
+    }
+    return handler;
+}
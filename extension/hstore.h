@@ -0,0 +1,11 @@
+#ifndef _POQUE_HSTORE_H_
+#define _POQUE_HSTORE_H_
+
+#include "poque_type.h"
+
+param_handler *new_hstore_param_handler(Oid oid, Oid array_oid);
+
+extern PoqueValueHandler hstore_val_handler;
+extern PoqueValueHandler hstorearray_val_handler;
+
+#endif
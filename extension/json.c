@@ -0,0 +1,899 @@
+#include "json.h"
+#include "text.h"
+
+#if PY_VERSION_HEX < 0x03090000
+#define PyObject_Vectorcall _PyObject_Vectorcall
+#endif
+
+
+/* reference to json.loads, used when the connection has no loads function */
+static PyObject *json_loads;
+
+
+static PyObject *
+json_call(PyObject *func, PyObject *arg)
+{
+    /* calls func with a single argument. Steals the reference to arg */
+    PyObject *args[2], *ret;
+
+    if (arg == NULL) {
+        return NULL;
+    }
+    args[0] = NULL;
+    args[1] = arg;
+    ret = PyObject_Vectorcall(
+        func, args + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    Py_DECREF(arg);
+    return ret;
+}
+
+
+static PyObject *
+json_parse(PyObject *loads, char *data, Py_ssize_t len)
+{
+    /* Parses json text.
+     *
+     * A custom loads function is given bytes, which libraries like orjson
+     * parse without creating an intermediate str. The default json.loads
+     * would have to detect the encoding of bytes, so that one gets a str.
+     */
+    if (loads == NULL) {
+        return json_call(
+            json_loads, PyUnicode_DecodeUTF8(data, len, "strict"));
+    }
+    return json_call(loads, PyBytes_FromStringAndSize(data, len));
+}
+
+
+/* ==== JsonValue ========================================================== */
+
+/* A JsonValue holds the raw json text and parses it on first access. This
+ * saves the parsing of values that are only passed on.
+ */
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *raw;      /* bytes, the json text */
+    PyObject *loads;    /* custom loads function or NULL */
+    PyObject *value;    /* parsed value, NULL until first access */
+} PoqueJsonValue;
+
+
+static PyObject *
+JsonValue_New(char *data, int len, PyObject *loads)
+{
+    PoqueJsonValue *self;
+
+    self = PyObject_GC_New(PoqueJsonValue, &PoqueJsonValueType);
+    if (self == NULL) {
+        return NULL;
+    }
+    self->value = NULL;
+    Py_XINCREF(loads);
+    self->loads = loads;
+    self->raw = PyBytes_FromStringAndSize(data, len);
+    if (self->raw == NULL) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    PyObject_GC_Track(self);
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+JsonValue_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"raw", "loads", NULL};
+    Py_buffer raw;
+    PyObject *loads = NULL, *ret;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "y*|O", kwlist, &raw, &loads)) {
+        return NULL;
+    }
+    if (loads == Py_None) {
+        loads = NULL;
+    }
+    ret = JsonValue_New(raw.buf, (int)raw.len, loads);
+    PyBuffer_Release(&raw);
+    return ret;
+}
+
+
+static PyObject *
+JsonValue_value(PoqueJsonValue *self, void *unused)
+{
+    /* the parsed value, parsed on first access */
+    if (self->value == NULL) {
+        self->value = json_parse(
+            self->loads, PyBytes_AS_STRING(self->raw),
+            PyBytes_GET_SIZE(self->raw));
+        if (self->value == NULL) {
+            return NULL;
+        }
+    }
+    Py_INCREF(self->value);
+    return self->value;
+}
+
+
+static PyObject *
+JsonValue_subscript(PoqueJsonValue *self, PyObject *key)
+{
+    PyObject *value, *ret;
+
+    value = JsonValue_value(self, NULL);
+    if (value == NULL) {
+        return NULL;
+    }
+    ret = PyObject_GetItem(value, key);
+    Py_DECREF(value);
+    return ret;
+}
+
+
+static PyObject *
+JsonValue_str(PoqueJsonValue *self)
+{
+    return PyUnicode_DecodeUTF8(
+        PyBytes_AS_STRING(self->raw), PyBytes_GET_SIZE(self->raw), "strict");
+}
+
+
+static PyObject *
+JsonValue_repr(PoqueJsonValue *self)
+{
+    return PyUnicode_FromFormat("JsonValue(%R)", self->raw);
+}
+
+
+static PyObject *
+JsonValue_bytes(PoqueJsonValue *self, PyObject *unused)
+{
+    Py_INCREF(self->raw);
+    return self->raw;
+}
+
+
+static int
+JsonValue_traverse(PoqueJsonValue *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->loads);
+    Py_VISIT(self->value);
+    return 0;
+}
+
+
+static int
+JsonValue_clear(PoqueJsonValue *self)
+{
+    Py_CLEAR(self->loads);
+    Py_CLEAR(self->value);
+    return 0;
+}
+
+
+static void
+JsonValue_dealloc(PoqueJsonValue *self)
+{
+    PyObject_GC_UnTrack(self);
+    JsonValue_clear(self);
+    Py_XDECREF(self->raw);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+static PyMappingMethods JsonValue_as_mapping = {
+    0,                                          /* mp_length */
+    (binaryfunc)JsonValue_subscript,            /* mp_subscript */
+    0,                                          /* mp_ass_subscript */
+};
+
+
+static PyMethodDef JsonValue_methods[] = {
+    {"__bytes__", (PyCFunction)JsonValue_bytes, METH_NOARGS,
+     PyDoc_STR("the raw json text")},
+    {NULL}  /* Sentinel */
+};
+
+
+static PyMemberDef JsonValue_members[] = {
+    {"raw", T_OBJECT, offsetof(PoqueJsonValue, raw), READONLY,
+     "json text as bytes"},
+    {NULL}  /* Sentinel */
+};
+
+
+static PyGetSetDef JsonValue_getset[] = {{
+        "value",
+        (getter)JsonValue_value,
+        NULL,
+        PyDoc_STR("parsed value"),
+        NULL
+    }, {
+        NULL
+}};
+
+
+PyTypeObject PoqueJsonValueType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.JsonValue",                          /* tp_name */
+    sizeof(PoqueJsonValue),                     /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)JsonValue_dealloc,              /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)JsonValue_repr,                   /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    &JsonValue_as_mapping,                      /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    (reprfunc)JsonValue_str,                    /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "Lazily parsed json value",                 /* tp_doc */
+    (traverseproc)JsonValue_traverse,           /* tp_traverse */
+    (inquiry)JsonValue_clear,                   /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    JsonValue_methods,                          /* tp_methods */
+    JsonValue_members,                          /* tp_members */
+    JsonValue_getset,                           /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    JsonValue_new,                              /* tp_new */
+};
+
+
+/* ==== json parameters ==================================================== */
+
+/* Dicts are sent as jsonb. Other values, like lists which would otherwise be
+ * sent as PostgreSQL arrays, can be wrapped in a Json object. A Json object
+ * can also carry a dumps function to serialize the value, otherwise the
+ * built in serializer is used.
+ */
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *obj;      /* the value to serialize */
+    PyObject *dumps;    /* custom dumps function or NULL */
+} PoqueJson;
+
+
+static PyObject *
+Json_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"obj", "dumps", NULL};
+    PyObject *obj, *dumps = NULL;
+    PoqueJson *self;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "O|O", kwlist, &obj, &dumps)) {
+        return NULL;
+    }
+    if (dumps == Py_None) {
+        dumps = NULL;
+    }
+    if (dumps != NULL && !PyCallable_Check(dumps)) {
+        PyErr_SetString(PyExc_TypeError, "dumps must be callable");
+        return NULL;
+    }
+    self = (PoqueJson *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    Py_INCREF(obj);
+    self->obj = obj;
+    Py_XINCREF(dumps);
+    self->dumps = dumps;
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+Json_repr(PoqueJson *self)
+{
+    return PyUnicode_FromFormat("Json(%R)", self->obj);
+}
+
+
+static int
+Json_traverse(PoqueJson *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->obj);
+    Py_VISIT(self->dumps);
+    return 0;
+}
+
+
+static int
+Json_clear(PoqueJson *self)
+{
+    Py_CLEAR(self->obj);
+    Py_CLEAR(self->dumps);
+    return 0;
+}
+
+
+static void
+Json_dealloc(PoqueJson *self)
+{
+    PyObject_GC_UnTrack(self);
+    Json_clear(self);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+static PyMemberDef Json_members[] = {
+    {"obj", T_OBJECT, offsetof(PoqueJson, obj), READONLY,
+     "value to serialize"},
+    {"dumps", T_OBJECT, offsetof(PoqueJson, dumps), READONLY,
+     "function to serialize the value, None for the built in serializer"},
+    {NULL}  /* Sentinel */
+};
+
+
+PyTypeObject PoqueJsonType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.Json",                               /* tp_name */
+    sizeof(PoqueJson),                          /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)Json_dealloc,                   /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)Json_repr,                        /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "Wraps a value to send as jsonb",           /* tp_doc */
+    (traverseproc)Json_traverse,                /* tp_traverse */
+    (inquiry)Json_clear,                        /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    Json_members,                               /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    Json_new,                                   /* tp_new */
+};
+
+
+/* growing buffer for the serializer */
+typedef struct {
+    char *data;
+    Py_ssize_t len;
+    Py_ssize_t alloc;
+} JsonBuffer;
+
+
+static char *
+json_reserve(JsonBuffer *buf, Py_ssize_t size)
+{
+    /* makes room for size bytes, returns the write position */
+    if (buf->len + size > buf->alloc) {
+        Py_ssize_t alloc;
+        char *data;
+
+        alloc = buf->alloc * 2;
+        if (alloc < buf->len + size) {
+            alloc = buf->len + size;
+        }
+        data = PyMem_Realloc(buf->data, alloc);
+        if (data == NULL) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        buf->data = data;
+        buf->alloc = alloc;
+    }
+    return buf->data + buf->len;
+}
+
+
+static int
+json_write(JsonBuffer *buf, const char *data, Py_ssize_t size)
+{
+    char *pos;
+
+    pos = json_reserve(buf, size);
+    if (pos == NULL) {
+        return -1;
+    }
+    memcpy(pos, data, size);
+    buf->len += size;
+    return 0;
+}
+
+
+static int
+json_write_str(JsonBuffer *buf, PyObject *str)
+{
+    /* writes a quoted and escaped string
+     *
+     * A non ASCII str is encoded into a temporary buffer, instead of having
+     * Python attach a UTF-8 copy to the str for the rest of its life.
+     */
+    static const char hex_chars[] = "0123456789abcdef";
+    const char *data, *end, *start;
+    char *utf8 = NULL;
+    Py_ssize_t size;
+    char *pos;
+
+    size = text_utf8_size(str, &data);
+    if (size < 0) {
+        return -1;
+    }
+    if (data == NULL) {
+        utf8 = PyMem_Malloc(size ? size : 1);
+        if (utf8 == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        text_utf8_write(str, utf8);
+        data = utf8;
+    }
+    end = data + size;
+
+    /* worst case every character is escaped as \u00XX */
+    pos = json_reserve(buf, size * 6 + 2);
+    if (pos == NULL) {
+        PyMem_Free(utf8);
+        return -1;
+    }
+    *pos++ = '"';
+    while (data < end) {
+        unsigned char c;
+
+        /* copy the characters that do not need escaping in one go */
+        start = data;
+        while (data < end && (unsigned char)*data >= 0x20 &&
+                *data != '"' && *data != '\\') {
+            data++;
+        }
+        memcpy(pos, start, data - start);
+        pos += data - start;
+        if (data == end) {
+            break;
+        }
+
+        c = (unsigned char)*data++;
+        *pos++ = '\\';
+        switch (c) {
+        case '"':
+        case '\\':
+            *pos++ = c;
+            break;
+        case '\n':
+            *pos++ = 'n';
+            break;
+        case '\r':
+            *pos++ = 'r';
+            break;
+        case '\t':
+            *pos++ = 't';
+            break;
+        case '\b':
+            *pos++ = 'b';
+            break;
+        case '\f':
+            *pos++ = 'f';
+            break;
+        default:
+            memcpy(pos, "u00", 3);
+            pos[3] = hex_chars[c >> 4];
+            pos[4] = hex_chars[c & 0xf];
+            pos += 5;
+        }
+    }
+    *pos++ = '"';
+    buf->len = pos - buf->data;
+    PyMem_Free(utf8);
+    return 0;
+}
+
+
+static int
+json_write_repr(JsonBuffer *buf, PyObject *obj, reprfunc func)
+{
+    /* writes the result of str() or repr() */
+    PyObject *str;
+    const char *data;
+    Py_ssize_t size;
+    int ret;
+
+    str = func(obj);
+    if (str == NULL) {
+        return -1;
+    }
+    data = PyUnicode_AsUTF8AndSize(str, &size);
+    ret = data ? json_write(buf, data, size) : -1;
+    Py_DECREF(str);
+    return ret;
+}
+
+
+static int
+json_write_float(JsonBuffer *buf, PyObject *obj)
+{
+    double val;
+    char *str;
+    int ret;
+
+    val = PyFloat_AS_DOUBLE(obj);
+    if (!Py_IS_FINITE(val)) {
+        PyErr_SetString(PyExc_ValueError,
+                        "Out of range float values are not JSON compliant");
+        return -1;
+    }
+    str = PyOS_double_to_string(val, 'r', 0, Py_DTSF_ADD_DOT_0, NULL);
+    if (str == NULL) {
+        return -1;
+    }
+    ret = json_write(buf, str, strlen(str));
+    PyMem_Free(str);
+    return ret;
+}
+
+
+static int
+json_write_dumps(JsonBuffer *buf, PyObject *dumps, PyObject *obj)
+{
+    /* writes the result of a custom dumps function, either str or bytes */
+    PyObject *ret;
+    int res = -1;
+
+    Py_INCREF(obj);
+    ret = json_call(dumps, obj);
+    if (ret == NULL) {
+        return -1;
+    }
+    if (PyBytes_Check(ret)) {
+        res = json_write(buf, PyBytes_AS_STRING(ret), PyBytes_GET_SIZE(ret));
+    }
+    else if (PyUnicode_Check(ret)) {
+        Py_ssize_t size;
+        const char *data;
+
+        data = PyUnicode_AsUTF8AndSize(ret, &size);
+        if (data != NULL) {
+            res = json_write(buf, data, size);
+        }
+    }
+    else {
+        PyErr_SetString(PyExc_TypeError, "dumps must return str or bytes");
+    }
+    Py_DECREF(ret);
+    return res;
+}
+
+
+static int json_write_value(JsonBuffer *buf, PyObject *obj);
+
+
+static int
+json_write_key(JsonBuffer *buf, PyObject *key)
+{
+    /* keys are strings, some scalars are converted like json.dumps does */
+    if (PyUnicode_Check(key)) {
+        return json_write_str(buf, key);
+    }
+    if (key == Py_True || key == Py_False || key == Py_None ||
+            PyLong_Check(key) || PyFloat_Check(key)) {
+        /* write the scalar between quotes */
+        if (json_write(buf, "\"", 1) == -1 ||
+                json_write_value(buf, key) == -1) {
+            return -1;
+        }
+        return json_write(buf, "\"", 1);
+    }
+    PyErr_Format(PyExc_TypeError,
+                 "keys must be str, int, float, bool or None, not %.100s",
+                 Py_TYPE(key)->tp_name);
+    return -1;
+}
+
+
+static int
+json_write_dict(JsonBuffer *buf, PyObject *obj)
+{
+    PyObject *key, *value;
+    Py_ssize_t i = 0, size;
+    int first = 1, ret;
+
+    if (json_write(buf, "{", 1) == -1) {
+        return -1;
+    }
+    size = PyDict_GET_SIZE(obj);
+    while (PyDict_Next(obj, &i, &key, &value)) {
+        if (!first && json_write(buf, ", ", 2) == -1) {
+            return -1;
+        }
+        first = 0;
+
+        /* the conversion of values can call back into Python, which could
+         * change the dict */
+        Py_INCREF(key);
+        Py_INCREF(value);
+        ret = (json_write_key(buf, key) == -1 ||
+               json_write(buf, ": ", 2) == -1 ||
+               json_write_value(buf, value) == -1);
+        Py_DECREF(key);
+        Py_DECREF(value);
+        if (ret) {
+            return -1;
+        }
+        if (PyDict_GET_SIZE(obj) != size) {
+            PyErr_SetString(PyExc_RuntimeError,
+                            "dictionary changed size during iteration");
+            return -1;
+        }
+    }
+    return json_write(buf, "}", 1);
+}
+
+
+static int
+json_write_sequence(JsonBuffer *buf, PyObject *obj)
+{
+    PyObject *item;
+    Py_ssize_t i;
+    int ret;
+
+    if (json_write(buf, "[", 1) == -1) {
+        return -1;
+    }
+    /* a list can change while converting its items, like a dict */
+    for (i = 0; i < PySequence_Fast_GET_SIZE(obj); i++) {
+        if (i && json_write(buf, ", ", 2) == -1) {
+            return -1;
+        }
+        item = PySequence_Fast_GET_ITEM(obj, i);
+        Py_INCREF(item);
+        ret = json_write_value(buf, item);
+        Py_DECREF(item);
+        if (ret == -1) {
+            return -1;
+        }
+    }
+    return json_write(buf, "]", 1);
+}
+
+
+static int
+json_write_value(JsonBuffer *buf, PyObject *obj)
+{
+    int ret;
+
+    if (PyUnicode_Check(obj)) {
+        return json_write_str(buf, obj);
+    }
+    if (obj == Py_None) {
+        return json_write(buf, "null", 4);
+    }
+    if (obj == Py_True) {
+        return json_write(buf, "true", 4);
+    }
+    if (obj == Py_False) {
+        return json_write(buf, "false", 5);
+    }
+    if (PyLong_Check(obj)) {
+        return json_write_repr(buf, obj, PyLong_Type.tp_repr);
+    }
+    if (PyFloat_Check(obj)) {
+        return json_write_float(buf, obj);
+    }
+
+    if (Py_EnterRecursiveCall(" while serializing json")) {
+        return -1;
+    }
+    if (PyDict_Check(obj)) {
+        ret = json_write_dict(buf, obj);
+    }
+    else if (PyList_Check(obj) || PyTuple_Check(obj)) {
+        ret = json_write_sequence(buf, obj);
+    }
+    else if (Py_TYPE(obj) == &PoqueJsonType) {
+        PoqueJson *json = (PoqueJson *)obj;
+
+        if (json->dumps) {
+            ret = json_write_dumps(buf, json->dumps, json->obj);
+        }
+        else {
+            ret = json_write_value(buf, json->obj);
+        }
+    }
+    else {
+        PyErr_Format(PyExc_TypeError,
+                     "Object of type %.100s is not JSON serializable",
+                     Py_TYPE(obj)->tp_name);
+        ret = -1;
+    }
+    Py_LeaveRecursiveCall();
+    return ret;
+}
+
+
+/* struct for storing the parameter values */
+typedef struct _JsonParam {
+    char *data;     /* encoded value, jsonb version byte and text */
+    int size;       /* size of encoded value */
+} JsonParam;
+
+
+typedef struct _JsonParamHandler {
+    param_handler handler;      /* base handler */
+    int num_params;             /* number of parameters */
+    int examine_pos;            /* where to examine next */
+    int encode_pos;             /* where to encode next */
+    JsonParam params[];         /* cache of parameter values */
+} JsonParamHandler;
+
+
+static int
+json_examine(JsonParamHandler *handler, PyObject *param)
+{
+    JsonBuffer buf = {NULL, 0, 0};
+    JsonParam *jp;
+
+    /* serialize into a buffer, which is kept for the encode step */
+    if (json_reserve(&buf, 256) == NULL) {
+        return -1;
+    }
+    buf.data[0] = 1;    /* jsonb version */
+    buf.len = 1;
+    if (json_write_value(&buf, param) == -1) {
+        PyMem_Free(buf.data);
+        return -1;
+    }
+    if (buf.len > INT_MAX) {
+        PyMem_Free(buf.data);
+        PyErr_SetString(PyExc_ValueError, "Json value too long");
+        return -1;
+    }
+
+    jp = current_examine_param(handler);
+    jp->data = buf.data;
+    jp->size = (int)buf.len;
+    return jp->size;
+}
+
+
+static int
+json_encode(JsonParamHandler *handler, PyObject *param, char **loc)
+{
+    JsonParam *jp;
+
+    /* return the earlier encoded buffer */
+    jp = current_encode_param(handler);
+    *loc = jp->data;
+    return 0;
+}
+
+
+static int
+json_encode_at(JsonParamHandler *handler, PyObject *param, char *loc)
+{
+    JsonParam *jp;
+
+    /* copy the earlier encoded buffer to location */
+    jp = current_encode_param(handler);
+    memcpy(loc, jp->data, jp->size);
+    return jp->size;
+}
+
+
+static void
+json_handler_free(JsonParamHandler *handler)
+{
+    int i;
+
+    for (i = 0; i < handler->examine_pos; i++) {
+        PyMem_Free(handler->params[i].data);
+    }
+    PyMem_Free(handler);
+}
+
+
+static param_handler *
+new_json_param_handler(int num_params)
+{
+    static JsonParamHandler def_handler = {
+        {
+            (ph_examine)json_examine,           /* examine */
+            NULL,                               /* total_size */
+            (ph_encode)json_encode,             /* encode */
+            (ph_encode_at)json_encode_at,       /* encode_at */
+            (ph_free)json_handler_free,         /* free */
+            JSONBOID,                           /* oid */
+            JSONBARRAYOID,                      /* array_oid */
+        },
+        0
+    }; /* static initialized handler */
+
+    return new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(JsonParamHandler),
+        num_params, sizeof(JsonParam));
+}
+
+
+/* ==== json readers ======================================================= */
+
+static PyObject *
+json_val(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+{
+    PoqueConn *conn = result->conn;
+
+    switch (conn->json_as) {
+    case JSON_AS_STR:
+        return PyUnicode_DecodeUTF8(data, len, "strict");
+    case JSON_AS_BYTES:
+        return PyBytes_FromStringAndSize(data, len);
+    case JSON_AS_LAZY:
+        return JsonValue_New(data, len, conn->json_loads);
+    }
+    return json_parse(conn->json_loads, data, len);
+}
+
+
+static PyObject *
+jsonb_bin_val(
+        PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
+{
+    if (len < 1 || data[0] != 1) {
+        PyErr_SetString(PoqueError, "Invalid jsonb version");
+        return NULL;
+    }
+    return json_val(result, data + 1, len - 1, NULL);
+}
+
+
+PoqueValueHandler json_val_handler = {{json_val, json_val}, ',', NULL};
+PoqueValueHandler jsonb_val_handler = {{json_val, jsonb_bin_val}, ',', NULL};
+
+PoqueValueHandler jsonarray_val_handler = {
+        {array_strval, array_binval}, ',', &json_val_handler};
+PoqueValueHandler jsonbarray_val_handler = {
+        {array_strval, array_binval}, ',', &jsonb_val_handler};
+
+
+int
+init_json(void)
+{
+    json_loads = load_python_object("json", "loads");
+    if (json_loads == NULL)
+        return -1;
+
+    register_parameter_handler(&PyDict_Type, new_json_param_handler);
+    register_parameter_handler(&PoqueJsonType, new_json_param_handler);
+    return 0;
+}
@@ -0,0 +1,14 @@
+#ifndef _POQUE_JSON_H_
+#define _POQUE_JSON_H_
+
+#include "poque_type.h"
+
+int init_json(void);
+
+extern PoqueValueHandler json_val_handler;
+extern PoqueValueHandler jsonb_val_handler;
+
+extern PoqueValueHandler jsonarray_val_handler;
+extern PoqueValueHandler jsonbarray_val_handler;
+
+#endif
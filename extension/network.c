@@ -18,26 +18,53 @@ mac_binval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 }
 
 
-static PyObject *
-mac_strval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
+static int
+read_mac_text(char *data, int len, int n, PY_UINT64_T *val)
 {
-    unsigned int a, b, c, d, e, f;
-    int count;
+    /* reads n colon separated pairs of hex digits */
+    PY_UINT64_T v = 0;
+    int i, j, d;
+    char c;
 
-    if (len != 17) {
-        PyErr_SetString(PoqueError, "Invalid mac address value");
-        return NULL;
+    if (len != n * 3 - 1) {
+        return -1;
     }
+    for (i = 0; i < n; i++) {
+        if (i && *data++ != ':') {
+            return -1;
+        }
+        for (j = 0; j < 2; j++) {
+            c = *data++;
+            if (c >= '0' && c <= '9') {
+                d = c - '0';
+            }
+            else if (c >= 'a' && c <= 'f') {
+                d = c - 'a' + 10;
+            }
+            else if (c >= 'A' && c <= 'F') {
+                d = c - 'A' + 10;
+            }
+            else {
+                return -1;
+            }
+            v = (v << 4) | d;
+        }
+    }
+    *val = v;
+    return 0;
+}
+
+
+static PyObject *
+mac_strval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
+{
+    PY_UINT64_T val;
 
-    count = sscanf(data, "%2x:%2x:%2x:%2x:%2x:%2x", &a, &b, &c, &d, &e, &f);
-    if (count != 6) {
+    if (read_mac_text(data, len, 6, &val) == -1) {
         PyErr_SetString(PoqueError, "Invalid mac address value");
         return NULL;
     }
-    return PyLong_FromUnsignedLongLong(
-        (unsigned long long)a << 40 | (unsigned long long)b << 32 | c << 24 |
-		 d << 16 | e << 8 | f
-	);
+    return PyLong_FromUnsignedLongLong(val);
 }
 
 
@@ -59,33 +86,38 @@ mac8_binval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 static PyObject *
 mac8_strval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 {
-    unsigned int a, b, c, d, e, f, g, h;
-    int count;
-
-    if (len != 23) {
-        PyErr_SetString(PoqueError, "Invalid mac address value");
-        return NULL;
-    }
+    PY_UINT64_T val;
 
-    count = sscanf(
-        data, "%2x:%2x:%2x:%2x:%2x:%2x:%2x:%2x", &a, &b, &c, &d, &e, &f, &g, &h
-	);
-    if (count != 8) {
+    if (read_mac_text(data, len, 8, &val) == -1) {
         PyErr_SetString(PoqueError, "Invalid mac8 address value");
         return NULL;
     }
-    return PyLong_FromUnsignedLongLong(
-        (unsigned long long)a << 56 | (unsigned long long)b << 48 |
-		(unsigned long long)c << 40 | (unsigned long long)d << 32 | e << 24 |
-		f << 16 | g << 8 | h
-	);
+    return PyLong_FromUnsignedLongLong(val);
 }
 
+static PyTypeObject *IPv4Address;
 static PyTypeObject *IPv4Network;
 static PyTypeObject *IPv4Interface;
+static PyTypeObject *IPv6Address;
 static PyTypeObject *IPv6Network;
 static PyTypeObject *IPv6Interface;
 
+/* offsets of the address slots, -1 if not available */
+static Py_ssize_t ipv4_ip_offset = -1;
+static Py_ssize_t ipv6_ip_offset = -1;
+static Py_ssize_t ipv6_scope_id_offset = -1;
+
+static PyObject *str_network;
+static PyObject *str_network_address;
+static PyObject *str_netmask;
+static PyObject *str_prefixlen;
+static PyObject *str_hosts;
+static PyObject *str_iter;
+
+/* netmask addresses by family and prefix length, created on first use */
+static PyObject *ipv4_netmasks[33];
+static PyObject *ipv6_netmasks[129];
+
 /* These constants are a bit weird. PGSQL_AF_INET has the value of whatever
  * AF_INET is on the server. PGSQL_AF_INET6 is that value plus one.
  * AF_INET seems to be consistently 2 on all platforms. If that is true, there's
@@ -94,10 +126,267 @@ static PyTypeObject *IPv6Interface;
 #define PGSQL_AF_INET 2
 #define PGSQL_AF_INET6 3
 
+#define ip_slot(o, offset) (*(PyObject **)((char *)(o) + (offset)))
+
+
+static PyObject *
+ip_int(unsigned char *addr, int is_v6)
+{
+    /* integer value of the address bytes */
+    if (is_v6) {
+        return _PyLong_FromByteArray(addr, 16, 0, 0);
+    }
+    return PyLong_FromUnsignedLong(read_uint32(addr));
+}
+
+
+static void
+ip_apply_mask(unsigned char *addr, int size, int prefixlen)
+{
+    /* clears the host bits */
+    int i;
+
+    for (i = 0; i < size; i++) {
+        if (prefixlen >= 8) {
+            prefixlen -= 8;
+        }
+        else {
+            addr[i] &= 0xFF << (8 - prefixlen);
+            prefixlen = 0;
+        }
+    }
+}
+
+
+static int
+ip_set_attr(PyObject *obj, PyObject *name, PyObject *value)
+{
+    /* Sets an instance attribute. Steals the reference to value */
+    int ret;
+
+    if (value == NULL) {
+        return -1;
+    }
+    ret = PyObject_SetAttr(obj, name, value);
+    Py_DECREF(value);
+    return ret;
+}
+
+
+static int
+ip_set_address(PyObject *obj, unsigned char *addr, int is_v6)
+{
+    /* Fills in the slots of a new address or interface, like the __init__ of
+     * IPv4Address and IPv6Address.
+     */
+    PyObject *ip;
+
+    ip = ip_int(addr, is_v6);
+    if (ip == NULL) {
+        return -1;
+    }
+    if (is_v6) {
+        ip_slot(obj, ipv6_ip_offset) = ip;
+        if (ipv6_scope_id_offset != -1) {
+            Py_INCREF(Py_None);
+            ip_slot(obj, ipv6_scope_id_offset) = Py_None;
+        }
+    }
+    else {
+        ip_slot(obj, ipv4_ip_offset) = ip;
+    }
+    return 0;
+}
+
+
+static PyObject *
+ip_address_new(unsigned char *addr, int is_v6)
+{
+    /* Creates an IPv4Address or IPv6Address without calling __init__ */
+    PyTypeObject *cls = is_v6 ? IPv6Address : IPv4Address;
+    PyObject *obj;
+
+    obj = cls->tp_alloc(cls, 0);
+    if (obj == NULL) {
+        return NULL;
+    }
+    if (ip_set_address(obj, addr, is_v6) == -1) {
+        Py_DECREF(obj);
+        return NULL;
+    }
+    return obj;
+}
+
+
+static PyObject *
+ip_netmask(int prefixlen, int is_v6)
+{
+    /* Returns a new reference to the shared netmask address. The ipaddress
+     * module caches these as well.
+     */
+    PyObject **netmask;
+    unsigned char addr[16];
+
+    netmask = is_v6 ? &ipv6_netmasks[prefixlen] : &ipv4_netmasks[prefixlen];
+    if (*netmask == NULL) {
+        memset(addr, 0xFF, 16);
+        ip_apply_mask(addr, is_v6 ? 16 : 4, prefixlen);
+        *netmask = ip_address_new(addr, is_v6);
+        if (*netmask == NULL) {
+            return NULL;
+        }
+    }
+    Py_INCREF(*netmask);
+    return *netmask;
+}
+
+
+static PyObject *
+ip_single_host(PyObject *address, PyObject *unused)
+{
+    PyObject *ret;
+
+    ret = PyList_New(1);
+    if (ret == NULL) {
+        return NULL;
+    }
+    Py_INCREF(address);
+    PyList_SET_ITEM(ret, 0, address);
+    return ret;
+}
+
+static PyMethodDef ip_single_host_def = {
+    "hosts", (PyCFunction)ip_single_host, METH_NOARGS, NULL};
+
+
+static PyObject *
+ip_network_new(unsigned char *addr, int prefixlen, int is_v6)
+{
+    /* Creates an IPv4Network or IPv6Network from a masked address, setting
+     * the same attributes as its __init__ does.
+     */
+    PyTypeObject *cls = is_v6 ? IPv6Network : IPv4Network;
+    PyObject *obj, *address, *hosts = NULL;
+    int max_prefixlen = is_v6 ? 128 : 32;
+
+    obj = cls->tp_alloc(cls, 0);
+    if (obj == NULL) {
+        return NULL;
+    }
+    address = ip_address_new(addr, is_v6);
+    if (address == NULL) {
+        goto error;
+    }
+    if (prefixlen == max_prefixlen) {
+        /* hosts() returns the single address */
+        hosts = PyCFunction_New(&ip_single_host_def, address);
+        if (hosts == NULL) {
+            Py_DECREF(address);
+            goto error;
+        }
+    }
+    if (ip_set_attr(obj, str_network_address, address) == -1 ||
+            ip_set_attr(obj, str_netmask, ip_netmask(prefixlen, is_v6)) == -1 ||
+            ip_set_attr(
+                obj, str_prefixlen, PyLong_FromLong(prefixlen)) == -1) {
+        goto error;
+    }
+    if (prefixlen == max_prefixlen - 1) {
+        /* hosts() iterates over both addresses */
+        hosts = PyObject_GetAttr(obj, str_iter);
+        if (hosts == NULL) {
+            goto error;
+        }
+    }
+    if (hosts != NULL && ip_set_attr(obj, str_hosts, hosts) == -1) {
+        /* hosts is consumed */
+        Py_DECREF(obj);
+        return NULL;
+    }
+    return obj;
+
+error:
+    Py_XDECREF(hosts);
+    Py_DECREF(obj);
+    return NULL;
+}
+
+
+static PyObject *
+ip_interface_new(unsigned char *addr, int prefixlen, int is_v6)
+{
+    /* Creates an IPv4Interface or IPv6Interface, setting the same slots and
+     * attributes as its __init__ does.
+     */
+    PyTypeObject *cls = is_v6 ? IPv6Interface : IPv4Interface;
+    PyObject *obj;
+    unsigned char net_addr[16];
+    int size = is_v6 ? 16 : 4;
+
+    obj = cls->tp_alloc(cls, 0);
+    if (obj == NULL) {
+        return NULL;
+    }
+    memcpy(net_addr, addr, size);
+    ip_apply_mask(net_addr, size, prefixlen);
+    if (ip_set_address(obj, addr, is_v6) == -1 ||
+            ip_set_attr(obj, str_network,
+                        ip_network_new(net_addr, prefixlen, is_v6)) == -1 ||
+            ip_set_attr(obj, str_netmask, ip_netmask(prefixlen, is_v6)) == -1 ||
+            ip_set_attr(
+                obj, str_prefixlen, PyLong_FromLong(prefixlen)) == -1) {
+        Py_DECREF(obj);
+        return NULL;
+    }
+    return obj;
+}
+
+
+static PyObject *
+ip_value(PoqueResult *result, unsigned char *addr, int prefixlen, int is_v6,
+         int cidr)
+{
+    /* Creates the Python value for a parsed inet or cidr value */
+    PyTypeObject *cls;
+    unsigned char net_addr[16];
+    int size = is_v6 ? 16 : 4;
+
+    if (prefixlen > size * 8) {
+        if (result->conn->inet_as == INET_AS_RAW) {
+            PyErr_SetString(PoqueError, "Invalid prefix length");
+            return NULL;
+        }
+    }
+    else if (result->conn->inet_as == INET_AS_RAW) {
+        return Py_BuildValue("iNi", is_v6 ? 6 : 4, ip_int(addr, is_v6),
+                             prefixlen);
+    }
+    else if (ipv4_ip_offset != -1 && ipv6_ip_offset != -1) {
+        if (!cidr) {
+            return ip_interface_new(addr, prefixlen, is_v6);
+        }
+        memcpy(net_addr, addr, size);
+        ip_apply_mask(net_addr, size, prefixlen);
+        if (memcmp(net_addr, addr, size) == 0) {
+            return ip_network_new(addr, prefixlen, is_v6);
+        }
+        /* host bits set, let the ipaddress module raise the error */
+    }
+
+    /* instantiate class */
+    if (cidr) {
+        cls = is_v6 ? IPv6Network : IPv4Network;
+    }
+    else {
+        cls = is_v6 ? IPv6Interface : IPv4Interface;
+    }
+    return PyObject_CallFunction(
+            (PyObject *)cls, "((Ni))", ip_int(addr, is_v6), prefixlen);
+}
+
 
 static PyObject *
-ip_binval(
-    char *data, int len, int cidr, PyTypeObject *v4_cls, PyTypeObject *v6_cls)
+ip_binval(PoqueResult *result, char *data, int len, int cidr)
 {
     unsigned char *cr;
     int mask, size, is_cidr, family;
@@ -108,8 +397,6 @@ ip_binval(
     }
 
     cr = (unsigned char *)data;
-    if (cr == NULL)
-        return NULL;
     family = cr[0];
     mask = cr[1];
     is_cidr = cr[2];
@@ -120,8 +407,6 @@ ip_binval(
         return NULL;
     }
     if (family == PGSQL_AF_INET ) {
-        PY_UINT32_T addr_data;
-
         if (size != 4) {
             PyErr_SetString(PoqueError, "Invalid address size");
             return NULL;
@@ -131,17 +416,9 @@ ip_binval(
             PyErr_SetString(PoqueError, "Invalid ip value");
             return NULL;
         }
-
-        /* get IP4 address as 4 byte integer */
-        addr_data = read_uint32(data + 4);
-
-        /* instantiate class */
-        return PyObject_CallFunction(
-                (PyObject *)v4_cls, "((Ii))", addr_data, mask);
+        return ip_value(result, cr + 4, mask, 0, cidr);
     }
     else if (family == PGSQL_AF_INET6) {
-        char *addr_data;
-
         if (size != 16) {
             PyErr_SetString(PoqueError, "Invalid address size");
             return NULL;
@@ -151,68 +428,186 @@ ip_binval(
             PyErr_SetString(PoqueError, "Invalid ip value");
             return NULL;
         }
+        return ip_value(result, cr + 4, mask, 1, cidr);
+    }
+    else {
+        PyErr_SetString(PoqueError, "Unknown network family");
+        return NULL;
+    }
+}
+
+
+static PyObject *
+inet_binval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
+{
+    return ip_binval(result, data, len, 0);
+}
 
-        /* get IP6 address as 16 bytes */
-        addr_data = data + 4;
-        if (addr_data == NULL) {
+static char *
+read_ipv4(char *p, char *end, unsigned char *addr)
+{
+    /* reads a dotted quad IPv4 address */
+    int i, n, v;
+
+    for (i = 0; i < 4; i++) {
+        if (i) {
+            if (p == end || *p != '.') {
+                return NULL;
+            }
+            p++;
+        }
+        for (n = 0, v = 0; p < end && n < 3 && *p >= '0' && *p <= '9'; n++) {
+            v = v * 10 + (*p++ - '0');
+        }
+        if (n == 0 || v > 255) {
             return NULL;
         }
+        addr[i] = (unsigned char)v;
+    }
+    return p;
+}
 
-        /* instantiate class */
-        return PyObject_CallFunction(
-                (PyObject *)v6_cls, "((y#i))", addr_data, 16, mask);
+
+static int
+hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
     }
-    else {
-        PyErr_SetString(PoqueError, "Unknown network family");
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+
+static char *
+read_ipv6(char *p, char *end, unsigned char *addr)
+{
+    /* reads an IPv6 address with optional '::' and embedded IPv4 address */
+    poque_uint16 groups[8];
+    int ngroups = 0, gap = -1, i, j, n, v, d;
+    char *start;
+
+    if (end - p >= 2 && p[0] == ':' && p[1] == ':') {
+        gap = 0;
+        p += 2;
+    }
+    while (p < end && *p != '/') {
+        start = p;
+        for (n = 0, v = 0; p < end && n < 4 && (d = hex_digit(*p)) != -1;
+                n++, p++) {
+            v = (v << 4) | d;
+        }
+        if (p < end && *p == '.') {
+            /* IPv4 address in the last 32 bits */
+            unsigned char ipv4[4];
+
+            if (ngroups > 6 || (p = read_ipv4(start, end, ipv4)) == NULL) {
+                return NULL;
+            }
+            groups[ngroups++] = (ipv4[0] << 8) | ipv4[1];
+            groups[ngroups++] = (ipv4[2] << 8) | ipv4[3];
+            break;
+        }
+        if (n == 0 || ngroups == 8) {
+            return NULL;
+        }
+        groups[ngroups++] = v;
+        if (p == end || *p == '/') {
+            break;
+        }
+        if (*p++ != ':') {
+            return NULL;
+        }
+        if (p < end && *p == ':') {
+            if (gap != -1) {
+                return NULL;
+            }
+            gap = ngroups;
+            p++;
+        }
+        else if (p == end || *p == '/') {
+            return NULL;
+        }
+    }
+    if (gap == -1 ? ngroups != 8 : ngroups > 7) {
         return NULL;
     }
+    memset(addr, 0, 16);
+    for (i = 0; i < ngroups; i++) {
+        j = (gap != -1 && i >= gap) ? i + 8 - ngroups : i;
+        addr[2 * j] = groups[i] >> 8;
+        addr[2 * j + 1] = groups[i] & 0xFF;
+    }
+    return p;
 }
 
 
 static PyObject *
-inet_binval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
+ip_strval(PoqueResult *result, char *data, int len, int cidr)
 {
-    return ip_binval(data, len, 0, IPv4Interface, IPv6Interface);
+    /* Parses the address and optional prefix length and creates the value
+     * the same way as the binary reader. Anything unexpected is left to the
+     * ipaddress module, which raises the proper error.
+     */
+    PyTypeObject *cls;
+    unsigned char addr[16];
+    char *p, *end = data + len;
+    int is_v6, mask, max_mask, n;
+
+    is_v6 = memchr(data, ':', len) != NULL;
+    max_mask = is_v6 ? 128 : 32;
+    p = is_v6 ? read_ipv6(data, end, addr) : read_ipv4(data, end, addr);
+    mask = max_mask;
+    if (p != NULL && p < end && *p == '/') {
+        for (p++, n = 0, mask = 0; p < end && n < 3 && *p >= '0' && *p <= '9';
+                n++) {
+            mask = mask * 10 + (*p++ - '0');
+        }
+        if (n == 0 || mask > max_mask) {
+            p = NULL;
+        }
+    }
+    if (p == end) {
+        return ip_value(result, addr, mask, is_v6, cidr);
+    }
+    if (result->conn->inet_as == INET_AS_RAW) {
+        PyErr_SetString(PoqueError, "Invalid ip value");
+        return NULL;
+    }
+    if (cidr) {
+        cls = is_v6 ? IPv6Network : IPv4Network;
+    }
+    else {
+        cls = is_v6 ? IPv6Interface : IPv4Interface;
+    }
+    return PyObject_CallFunction(
+        (PyObject *)cls, "s#", data, (Py_ssize_t)len);
 }
 
+
 static PyObject *
 inet_strval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 {
-	PyTypeObject *inet_cls;
-
-	if (memchr(data, ':', len) == NULL)
-	{
-		inet_cls = IPv4Interface;
-	}
-	else
-	{
-		inet_cls = IPv6Interface;
-	}
-	return PyObject_CallFunction((PyObject *)inet_cls, "s#", data, len);
+    return ip_strval(result, data, len, 0);
 }
 
 
 static PyObject *
 cidr_binval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 {
-    return ip_binval(data, len, 1, IPv4Network, IPv6Network);
+    return ip_binval(result, data, len, 1);
 }
 
 
 static PyObject *
 cidr_strval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 {
-	PyTypeObject *inet_cls;
-
-	if (memchr(data, ':', len) == NULL)
-	{
-		inet_cls = IPv4Network;
-	}
-	else
-	{
-		inet_cls = IPv6Network;
-	}
-	return PyObject_CallFunction((PyObject *)inet_cls, "s#", data, len);
+    return ip_strval(result, data, len, 1);
 }
 
 /* ==== ip interface and ip network parameter handlers ====================== */
@@ -221,24 +616,64 @@ cidr_strval(PoqueResult *result, char *data, int len,PoqueValueHandler *unused)
 
 
 static int
-ip_encode_at(int family, int prefixlen, int is_cidr, PyObject *packed,
+ip_encode_at(PyObject *address, PyObject *prefixlen, int is_v6, int is_cidr,
         char *loc) {
-    Py_ssize_t size;
+    /* Writes the value from the integer in the _ip slot of the address or
+     * interface, which avoids creating the packed bytes.
+     */
     unsigned char *data;
-
-    size = PyBytes_GET_SIZE(packed);
+    Py_ssize_t offset;
+    PyObject *ip;
+    unsigned long ipv4;
+    long mask;
+    int ret = 0;
+
+    mask = PyLong_AsLong(prefixlen);
+    if (mask == -1 && PyErr_Occurred()) {
+        return -1;
+    }
+    offset = is_v6 ? ipv6_ip_offset : ipv4_ip_offset;
+    if (offset != -1 && ip_slot(address, offset) != NULL) {
+        ip = ip_slot(address, offset);
+        Py_INCREF(ip);
+    }
+    else {
+        ip = PyObject_GetAttrString(address, "_ip");
+        if (ip == NULL) {
+            return -1;
+        }
+    }
+    if (!PyLong_Check(ip)) {
+        PyErr_SetString(PyExc_TypeError, "Invalid ip address value");
+        Py_DECREF(ip);
+        return -1;
+    }
 
     data = (unsigned char *)loc;
-    data[0] = family;
-    data[1] = prefixlen;
+    data[0] = is_v6 ? PGSQL_AF_INET6 : PGSQL_AF_INET;
+    data[1] = mask;
     data[2] = is_cidr;
-    data[3] = size;
-    memcpy(loc + 4, PyBytes_AS_STRING(packed), size);
-    return 4 + size;
+    data[3] = is_v6 ? 16 : 4;
+    if (is_v6) {
+        ret = _PyLong_AsByteArray((PyLongObject *)ip, data + 4, 16, 0, 0);
+    }
+    else {
+        ipv4 = PyLong_AsUnsignedLong(ip);
+        if (ipv4 == (unsigned long)-1 && PyErr_Occurred()) {
+            ret = -1;
+        }
+        else if (ipv4 > 0xFFFFFFFFUL) {
+            PyErr_SetString(PyExc_OverflowError, "Invalid ip address value");
+            ret = -1;
+        }
+        else {
+            put_uint32(loc + 4, (PY_UINT32_T)ipv4);
+        }
+    }
+    Py_DECREF(ip);
+    return ret == -1 ? -1 : 4 + data[3];
 }
 
-#define get_family(p, t) (Py_TYPE(p) == t ? PGSQL_AF_INET : PGSQL_AF_INET6)
-
 
 /* ==== ip interface parameter handler specifics ============================ */
 
@@ -252,30 +687,16 @@ static int
 ip_interface_encode_at(param_handler *handler, PyObject *param,
         char *loc) {
 
-    int family, ret;
-    long prefixlen;
-    PyObject *py_obj;
+    int ret;
+    PyObject *prefixlen;
 
-    family = get_family(param, IPv4Interface);
-
-    /* prefixlen = param.network.prefixlen */
-    py_obj = PyObject_GetAttrString(param, "network");
-    if (py_obj == NULL) {
-        return -1;
-    }
-    if (pyobj_long_attr(py_obj, "prefixlen", &prefixlen) == -1) {
-        return -1;
-    }
-    Py_DECREF(py_obj);
-
-    /* packed = param.packed */
-    py_obj = PyObject_GetAttrString(param, "packed");
-    if (py_obj== NULL) {
+    prefixlen = PyObject_GetAttr(param, str_prefixlen);
+    if (prefixlen == NULL) {
         return -1;
     }
-
-    ret = ip_encode_at(family, prefixlen, 0, py_obj, loc);
-    Py_DECREF(py_obj);
+    ret = ip_encode_at(
+        param, prefixlen, Py_TYPE(param) != IPv4Interface, 0, loc);
+    Py_DECREF(prefixlen);
     return ret;
 }
 
@@ -309,30 +730,22 @@ static int
 ip_network_encode_at(param_handler *handler, PyObject *param,
         char *loc) {
 
-    int family, ret;
-    long prefixlen;
-    PyObject *py_obj, *py_packed;
-
-    family = get_family(param, IPv4Network);
+    int ret;
+    PyObject *prefixlen, *address;
 
-    /* prefixlen = param.prefixlen */
-    if (pyobj_long_attr(param, "prefixlen", &prefixlen) == -1) {
+    prefixlen = PyObject_GetAttr(param, str_prefixlen);
+    if (prefixlen == NULL) {
         return -1;
     }
-
-    /* packed = param.network_address.packed */
-    py_obj = PyObject_GetAttrString(param, "network_address");
-    if (py_obj == NULL) {
-        return -1;
-    }
-    py_packed = PyObject_GetAttrString(py_obj, "packed");
-    Py_DECREF(py_obj);
-    if (py_packed == NULL) {
+    address = PyObject_GetAttr(param, str_network_address);
+    if (address == NULL) {
+        Py_DECREF(prefixlen);
         return -1;
     }
-
-    ret = ip_encode_at(family, prefixlen, 1, py_packed, loc);
-    Py_DECREF(py_packed);
+    ret = ip_encode_at(
+        address, prefixlen, Py_TYPE(param) != IPv4Network, 1, loc);
+    Py_DECREF(address);
+    Py_DECREF(prefixlen);
     return ret;
 }
 
@@ -370,13 +783,62 @@ PoqueValueHandler cidrarray_val_handler = {
         {array_strval, array_binval}, ',', &cidr_val_handler};
 
 
+static Py_ssize_t
+ip_slot_offset(PyTypeObject *cls, PyTypeObject *subcls, const char *name)
+{
+    /* Gets the offset of an object slot of an address type, which must be
+     * shared by the interface type.
+     */
+    PyObject *descr;
+    PyMemberDef *member;
+
+    if (!PyType_IsSubtype(subcls, cls)) {
+        return -1;
+    }
+    descr = PyDict_GetItemString(cls->tp_dict, name);
+    if (descr == NULL || Py_TYPE(descr) != &PyMemberDescr_Type) {
+        return -1;
+    }
+    member = ((PyMemberDescrObject *)descr)->d_member;
+    if (member->type != T_OBJECT_EX) {
+        return -1;
+    }
+    return member->offset;
+}
+
+
 int
 init_network(void)
 {
+    IPv4Address = load_python_type("ipaddress", "IPv4Address");
     IPv4Network = load_python_type("ipaddress", "IPv4Network");
     IPv4Interface = load_python_type("ipaddress", "IPv4Interface");
+    IPv6Address = load_python_type("ipaddress", "IPv6Address");
     IPv6Network = load_python_type("ipaddress", "IPv6Network");
     IPv6Interface = load_python_type("ipaddress", "IPv6Interface");
+    if (IPv4Address == NULL || IPv4Network == NULL || IPv4Interface == NULL ||
+            IPv6Address == NULL || IPv6Network == NULL ||
+            IPv6Interface == NULL) {
+        return -1;
+    }
+
+    str_network = PyUnicode_InternFromString("network");
+    str_network_address = PyUnicode_InternFromString("network_address");
+    str_netmask = PyUnicode_InternFromString("netmask");
+    str_prefixlen = PyUnicode_InternFromString("_prefixlen");
+    str_hosts = PyUnicode_InternFromString("hosts");
+    str_iter = PyUnicode_InternFromString("__iter__");
+    if (str_network == NULL || str_network_address == NULL ||
+            str_netmask == NULL || str_prefixlen == NULL ||
+            str_hosts == NULL || str_iter == NULL) {
+        return -1;
+    }
+
+    /* Python 3.9 added the _scope_id slot to IPv6Address */
+    ipv4_ip_offset = ip_slot_offset(IPv4Address, IPv4Interface, "_ip");
+    ipv6_ip_offset = ip_slot_offset(IPv6Address, IPv6Interface, "_ip");
+    ipv6_scope_id_offset = ip_slot_offset(
+        IPv6Address, IPv6Interface, "_scope_id");
 
     register_parameter_handler(IPv4Interface, new_ip_interface_param_handler);
     register_parameter_handler(IPv6Interface, new_ip_interface_param_handler);
@@ -266,9 +266,9 @@ new_int_param_handler(int num_params) {
     }; /* static initialized handler */
     param_handler *handler;
 
-    handler = new_param_handler(
-        (param_handler *)&def_handler,
-        sizeof(IntParamHandler) + num_params * sizeof(IntParam));
+    handler = new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(IntParamHandler),
+        num_params, sizeof(IntParam));
     if (handler == NULL) {
         return NULL;
     }
@@ -276,6 +276,78 @@ new_int_param_handler(int num_params) {
 }
 
 
+static Py_ssize_t
+int_list_examine(PyObject **items, Py_ssize_t n, list_encoding *enc) {
+    /* Checks the range of the values in a single pass. Values that do not
+     * fit in 64 bits are left to the int parameter handler.
+     */
+    Py_ssize_t i, num_null = 0;
+    PyObject *item;
+    long long val;
+    int overflow, wide = 0;
+
+    for (i = 0; i < n; i++) {
+        item = items[i];
+        if (item == Py_None) {
+            num_null++;
+            continue;
+        }
+        if (Py_TYPE(item) != &PyLong_Type) {
+            return -2;
+        }
+        val = PyLong_AsLongLongAndOverflow(item, &overflow);
+        if (overflow) {
+            return -2;
+        }
+        if (val < INT32_MIN || val > INT32_MAX) {
+            wide = 1;
+        }
+    }
+    enc->num_null = num_null;
+    if (wide) {
+        enc->oid = INT8OID;
+        enc->array_oid = INT8ARRAYOID;
+        return (n - num_null) * 8;
+    }
+    enc->oid = INT4OID;
+    enc->array_oid = INT4ARRAYOID;
+    return (n - num_null) * 4;
+}
+
+
+static int
+int_list_write(PyObject **items, Py_ssize_t n, list_encoding *enc, char *loc)
+{
+    Py_ssize_t i;
+
+    if (enc->oid == INT8OID) {
+        for (i = 0; i < n; i++) {
+            if (items[i] == Py_None) {
+                put_uint32(loc, -1);
+                loc += 4;
+                continue;
+            }
+            put_uint32(loc, 8);
+            put_uint64(loc + 4, (PY_UINT64_T)PyLong_AsLongLong(items[i]));
+            loc += 12;
+        }
+    }
+    else {
+        for (i = 0; i < n; i++) {
+            if (items[i] == Py_None) {
+                put_uint32(loc, -1);
+                loc += 4;
+                continue;
+            }
+            put_uint32(loc, 4);
+            put_uint32(loc + 4, (PY_UINT32_T)PyLong_AsLong(items[i]));
+            loc += 8;
+        }
+    }
+    return 0;
+}
+
+
 static PyObject *
 int16_binval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
@@ -338,13 +410,24 @@ _check_int_strval(char *data, int len, char *pend)
     return 0;
 }
 
+static void int_strnative(char *data, int len, NativeValue *value);
+static void float_strnative(char *data, int len, NativeValue *value);
+
+
 static PyObject *
 long_strval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
+    NativeValue value;
     char *pend;
     long val;
 
+    value.kind = NATIVE_NONE;
+    int_strnative(data, len, &value);
+    if (value.kind == NATIVE_INT) {
+        return PyLong_FromLongLong(value.val.i);
+    }
+
     errno = 0;
     val = strtol(data, &pend, 10);
     if (errno) {
@@ -363,9 +446,16 @@ static PyObject *
 ulong_strval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
+    NativeValue value;
     char *pend;
     unsigned long val;
 
+    value.kind = NATIVE_NONE;
+    int_strnative(data, len, &value);
+    if (value.kind == NATIVE_INT && value.val.i >= 0) {
+        return PyLong_FromLongLong(value.val.i);
+    }
+
     errno = 0;
     val = strtoul(data, &pend, 10);
     if (_check_int_strval(data, len, pend) == -1) {
@@ -378,9 +468,17 @@ ulong_strval(
 static PyObject *
 longlong_strval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 {
+    NativeValue value;
     char *pend;
     long long val;
 
+    /* only values of 19 digits take the slow path */
+    value.kind = NATIVE_NONE;
+    int_strnative(data, len, &value);
+    if (value.kind == NATIVE_INT) {
+        return PyLong_FromLongLong(value.val.i);
+    }
+
     errno = 0;
     val = strtoll(data, &pend, 10);
     if (_check_int_strval(data, len, pend) == -1) {
@@ -446,6 +544,44 @@ new_bool_param_handler(int num_param) {
 }
 
 
+static Py_ssize_t
+bool_list_examine(PyObject **items, Py_ssize_t n, list_encoding *enc) {
+    Py_ssize_t i, num_null = 0;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            num_null++;
+        }
+        else if (Py_TYPE(items[i]) != &PyBool_Type) {
+            return -2;
+        }
+    }
+    enc->num_null = num_null;
+    enc->oid = BOOLOID;
+    enc->array_oid = BOOLARRAYOID;
+    return n - num_null;
+}
+
+
+static int
+bool_list_write(PyObject **items, Py_ssize_t n, list_encoding *enc, char *loc)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            put_uint32(loc, -1);
+            loc += 4;
+            continue;
+        }
+        put_uint32(loc, 1);
+        loc[4] = (items[i] == Py_True);
+        loc += 5;
+    }
+    return 0;
+}
+
+
 static PyObject *
 float64_binval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
@@ -488,9 +624,16 @@ static PyObject *
 float_strval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
+	NativeValue value;
 	double val;
 	char *pend;
 
+	value.kind = NATIVE_NONE;
+	float_strnative(data, len, &value);
+	if (value.kind == NATIVE_FLOAT) {
+		return PyFloat_FromDouble(value.val.d);
+	}
+
 	val = PyOS_string_to_double(data, &pend, PoqueError);
 	if (val == -1.0 && PyErr_Occurred())
 		return NULL;
@@ -537,6 +680,50 @@ new_float_param_handler(int num_param) {
 }
 
 
+static Py_ssize_t
+float_list_examine(PyObject **items, Py_ssize_t n, list_encoding *enc) {
+    Py_ssize_t i, num_null = 0;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            num_null++;
+        }
+        else if (Py_TYPE(items[i]) != &PyFloat_Type) {
+            return -2;
+        }
+    }
+    enc->num_null = num_null;
+    enc->oid = FLOAT8OID;
+    enc->array_oid = FLOAT8ARRAYOID;
+    return (n - num_null) * 8;
+}
+
+
+static int
+float_list_write(
+        PyObject **items, Py_ssize_t n, list_encoding *enc, char *loc)
+{
+    /* Like _PyFloat_Pack8 on IEEE 754 platforms, without the call per item */
+    Py_ssize_t i;
+    PY_UINT64_T bits;
+    double val;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            put_uint32(loc, -1);
+            loc += 4;
+            continue;
+        }
+        val = PyFloat_AS_DOUBLE(items[i]);
+        memcpy(&bits, &val, 8);
+        put_uint32(loc, 8);
+        put_uint64(loc + 4, bits);
+        loc += 12;
+    }
+    return 0;
+}
+
+
 /* struct for storing the parameter values */
 typedef struct _DecimalParam {
     char *data;       /* encoded value */
@@ -553,117 +740,130 @@ typedef struct _DecimalParamHandler {
 } DecimalParamHandler;
 
 
-static inline int
-decimal_check_infinite(PyObject *decimal) {
-    PyObject *py_obj;
-    int ret;
-    _Py_IDENTIFIER(is_infinite);
-
-    py_obj = _PyObject_CallMethodIdObjArgs(decimal, &PyId_is_infinite, NULL);
-    if (py_obj == NULL) {
-        return -1;
-    }
-    ret = PyObject_IsTrue(py_obj);
-    if (ret && ret != -1) {
-		PyErr_SetString(PyExc_ValueError,
-						"PostgreSQL does not support decimal infinites");
-		ret = -1;
-    }
-    Py_DECREF(py_obj);
-    return ret;
-}
-
-static inline int
-decimal_check_nan(PyObject *decimal) {
-    PyObject *py_obj;
-    int ret;
-    _Py_IDENTIFIER(is_nan);
-
-    py_obj = _PyObject_CallMethodIdObjArgs(decimal, &PyId_is_nan, NULL);
-    if (py_obj == NULL) {
-        return -1;
-    }
-    ret = PyObject_IsTrue(py_obj);
-    Py_DECREF(py_obj);
-    return ret;
-}
-
-
 #define MAX_PG_WEIGHT 0x7FFF
 #define MAX_DEC_WEIGHT ((MAX_PG_WEIGHT + 1) * 4)
 
+/* exponents beyond this are out of range anyway, used to prevent overflow */
+#define MAX_DEC_EXP 0x40000000
+
+
 static int
 decimal_examine(DecimalParamHandler *handler, PyObject *param)
 {
-    PyObject *py_obj, *val = NULL;
+    PyObject *str;
     DecimalParam *np;
-    int i, j, size=-1, isnan;
-    char *data, *pos;
+    int i, j, size=-1;
+    const char *val, *pos, *end, *first, *coeff_end;
+    char *data, *dest;
     poque_uint16 pg_sign, dscale, pg_digit;
-    Py_ssize_t npg_digits, ndigits;
+    Py_ssize_t npg_digits, ndigits, len;
     poque_int16 pg_weight;
 
-    /* Check if it is an infinite Decimal. PostgreSQL does not support
-     * infinite.
+    /* The coefficient and exponent are read from the string representation,
+     * which is "[-]digits[.digits][E[+-]digits]", "[-]Infinity" or
+     * "[-][s]NaN". This is a lot cheaper than as_tuple, which creates an int
+     * for every digit.
      */
-    if (decimal_check_infinite(param) == -1) {
+    str = PyObject_Str(param);
+    if (str == NULL) {
         return -1;
     }
+    val = PyUnicode_AsUTF8AndSize(str, &len);
+    if (val == NULL) {
+        Py_DECREF(str);
+        return -1;
+    }
+    pos = val;
+    end = val + len;
+    pg_sign = NUMERIC_POS;
+    if (pos < end && *pos == '-') {
+        pg_sign = NUMERIC_NEG;
+        pos++;
+    }
 
-    /*  Check if it is a NaN */
-    isnan = decimal_check_nan(param);
-    if (isnan == -1) {
+    if (pos < end && *pos == 'I') {
+        /* PostgreSQL does not support infinite */
+        Py_DECREF(str);
+        PyErr_SetString(PyExc_ValueError,
+                        "PostgreSQL does not support decimal infinites");
         return -1;
     }
 
-    if (isnan) {
+    if (pos < end && (*pos == 'N' || *pos == 's')) {
         /* it is a NaN */
         pg_weight = 0;
         pg_sign = NUMERIC_NAN;
         dscale = 0;
         npg_digits = 0;
         ndigits = 0;
+        first = coeff_end = pos;
         j = 0;
     }
     else {
         /* normal decimal */
-        Py_ssize_t exp;
-        int dec_weight, q, r;
-        _Py_IDENTIFIER(as_tuple);
+        Py_ssize_t exp = 0, nfrac = 0;
+        int dec_weight, q, r, exp_neg = 0, point = 0;
 
-        /* get sign, digits and exponent */
-        val = _PyObject_CallMethodIdObjArgs(param, &PyId_as_tuple, NULL);
-        if (val == NULL) {
-            return -1;
+        /* get the digits, skipping leading zeroes */
+        first = NULL;
+        ndigits = 0;
+        for (; pos < end; pos++) {
+            if (*pos == '.') {
+                point = 1;
+                continue;
+            }
+            if (*pos < '0' || *pos > '9') {
+                break;
+            }
+            nfrac += point;
+            if (first == NULL && *pos != '0') {
+                first = pos;
+            }
+            ndigits += (first != NULL);
+        }
+        coeff_end = pos;
+        if (first == NULL) {
+            /* zero has a single digit */
+            first = "0";
+            coeff_end = first + 1;
+            ndigits = 1;
         }
 
-        /* get pg sign */
-        py_obj = PyTuple_GET_ITEM(val, 0);
-        pg_sign = PyLong_AsLong(py_obj) ? NUMERIC_NEG : NUMERIC_POS;
+        /* get the exponent */
+        if (pos < end && (*pos == 'E' || *pos == 'e')) {
+            pos++;
+            if (pos < end && (*pos == '-' || *pos == '+')) {
+                exp_neg = (*pos == '-');
+                pos++;
+            }
+            for (; pos < end && *pos >= '0' && *pos <= '9'; pos++) {
+                if (exp < MAX_DEC_EXP) {
+                    exp = exp * 10 + (*pos - '0');
+                }
+            }
+            if (exp_neg) {
+                exp = -exp;
+            }
+        }
+        if (pos != end) {
+            Py_DECREF(str);
+            PyErr_SetString(PyExc_ValueError, "Invalid decimal value");
+            return -1;
+        }
+        exp -= nfrac;
 
         /* get pg dscale */
-        py_obj = PyTuple_GET_ITEM(val, 2);
-        exp = PyLong_AsSsize_t(py_obj);
-        if ((exp == -1 && PyErr_Occurred()) || exp < -0x3FFF) {
-            /* In case of positive overflow the exponent is too large too
-             * translate to a PG exponent (pg_weight, see later)
-             *
-             * negative exponent is the same as the positive pg dscale
+        if (exp < -0x3FFF) {
+            /* negative exponent is the same as the positive pg dscale
              * Maximum value for dscale is 0x3FFF.
-             *
-             *
              */
-            Py_DECREF(val);
+            Py_DECREF(str);
             PyErr_SetString(PyExc_ValueError,
                             "Exponent out of PostgreSQL range");
             return -1;
         }
         dscale = exp > 0 ? 0 : -exp;
 
-        /* now get the pg digits */
-        py_obj = PyTuple_GET_ITEM(val, 1);
-        ndigits = PyTuple_GET_SIZE(py_obj);
-
         /* calculate pg_weight */
         if (exp - MAX_DEC_WEIGHT > -ndigits) {
             /* overflow safe version of
@@ -673,7 +873,7 @@ decimal_examine(DecimalParamHandler *handler, PyObject *param)
              * ndigits will be equal to or greater than zero
              * exp will not be less than -0x3fff (-16383)
              */
-            Py_DECREF(val);
+            Py_DECREF(str);
             PyErr_SetString(PyExc_ValueError,
                             "Decimal out of PostgreSQL range");
             return -1;
@@ -713,22 +913,22 @@ decimal_examine(DecimalParamHandler *handler, PyObject *param)
     /* we know the number of digits, now we know the memory size */
     data = PyMem_Calloc(1, 8 + npg_digits * 2);
     if (data == NULL) {
-        Py_XDECREF(val);
+        Py_DECREF(str);
         PyErr_NoMemory();
         return -1;
     }
 
     /* write the pg digits */
-    pos = data + 8;     /* position past header */
+    dest = data + 8;     /* position past header */
     pg_digit = 0;
-    for (i = 0; i < ndigits; i++) {
-        int digit;
-
-        digit = PyLong_AsLong(PyTuple_GET_ITEM(py_obj, i));
+    for (pos = first; pos < coeff_end; pos++) {
+        if (*pos == '.') {
+            continue;
+        }
         pg_digit *= 10;
-        pg_digit += digit;
+        pg_digit += *pos - '0';
         if (++j == 4) {
-            write_uint16(&pos, pg_digit);
+            write_uint16(&dest, pg_digit);
             pg_digit = 0;
             j = 0;
         }
@@ -737,16 +937,16 @@ decimal_examine(DecimalParamHandler *handler, PyObject *param)
         for (i = 0; i < (4 - j); i++) {
             pg_digit *= 10;
         }
-        write_uint16(&pos, pg_digit);
+        write_uint16(&dest, pg_digit);
     }
-    Py_XDECREF(val);
+    Py_DECREF(str);
 
     /* write header */
-    pos = data;
-    write_uint16(&pos, (poque_uint16)npg_digits);
-    write_uint16(&pos, pg_weight);
-    write_uint16(&pos, pg_sign);
-    write_uint16(&pos, dscale);
+    dest = data;
+    write_uint16(&dest, (poque_uint16)npg_digits);
+    write_uint16(&dest, pg_weight);
+    write_uint16(&dest, pg_sign);
+    write_uint16(&dest, dscale);
 
     /* set parameter values */
     np = current_examine_param(handler);
@@ -813,9 +1013,9 @@ new_decimal_param_handler(int num_params) {
     }; /* static initialized handler */
     param_handler *handler;
 
-    handler = new_param_handler(
-        (param_handler *)&def_handler,
-        sizeof(DecimalParamHandler) + num_params * sizeof(DecimalParam));
+    handler = new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(DecimalParamHandler),
+        num_params, sizeof(DecimalParam));
     if (handler == NULL) {
         return NULL;
     }
@@ -826,30 +1026,160 @@ new_decimal_param_handler(int num_params) {
 /* reference to decimal.Decimal */
 static PyObject *PyDecimal;
 
+
+static PyObject *
+numeric_from_str(char *data, Py_ssize_t len)
+{
+    PyObject *str, *ret;
+
+    str = PyUnicode_FromStringAndSize(data, len);
+    if (str == NULL) {
+        return NULL;
+    }
+    ret = PyObject_CallFunctionObjArgs(PyDecimal, str, NULL);
+    Py_DECREF(str);
+    return ret;
+}
+
+
+static PyObject *
+numeric_int_from_str(char *data, Py_ssize_t len)
+{
+    /* Creates an int from a string of decimal digits with optional sign.
+     *
+     * Large values are built from chunks of 18 digits instead of using
+     * PyLong_FromString, which is subject to the int string conversion limit.
+     */
+    PyObject *ret = NULL, *tmp, *factor, *chunk;
+    Py_ssize_t i, n;
+    long long val, pow;
+    int neg;
+
+    neg = (data[0] == '-');
+    i = neg;
+    while (i < len) {
+        n = len - i;
+        if (n > 18) {
+            n = 18;
+        }
+        val = 0;
+        pow = 1;
+        for (; n > 0; n--, i++) {
+            val = val * 10 + (data[i] - '0');
+            pow *= 10;
+        }
+        if (ret == NULL && i == len) {
+            /* fits in 64 bits */
+            return PyLong_FromLongLong(neg ? -val : val);
+        }
+        chunk = PyLong_FromLongLong(val);
+        if (chunk == NULL) {
+            Py_XDECREF(ret);
+            return NULL;
+        }
+        if (ret == NULL) {
+            ret = chunk;
+            continue;
+        }
+        factor = PyLong_FromLongLong(pow);
+        if (factor == NULL) {
+            Py_DECREF(chunk);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        tmp = PyNumber_Multiply(ret, factor);
+        Py_DECREF(factor);
+        Py_DECREF(ret);
+        if (tmp == NULL) {
+            Py_DECREF(chunk);
+            return NULL;
+        }
+        ret = PyNumber_Add(tmp, chunk);
+        Py_DECREF(tmp);
+        Py_DECREF(chunk);
+        if (ret == NULL) {
+            return NULL;
+        }
+    }
+    if (neg) {
+        tmp = PyNumber_Negative(ret);
+        Py_DECREF(ret);
+        ret = tmp;
+    }
+    return ret;
+}
+
+
 static PyObject *
 numeric_strval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
-    /* Create a Decimal from a text value */
-     return PyObject_CallFunction(PyDecimal, "s#", data, len);
-}
+    /* Create a Decimal, int or float from a text value */
+    char mode = result->conn->numeric_as;
+    NativeValue value;
+
+    value.kind = NATIVE_NONE;
+    if (mode == NUMERIC_AS_FLOAT) {
+        double val;
+        char *pend;
+
+        float_strnative(data, len, &value);
+        if (value.kind == NATIVE_FLOAT) {
+            return PyFloat_FromDouble(value.val.d);
+        }
 
+        /* out of range values become infinite, like float(Decimal) */
+        val = PyOS_string_to_double(data, &pend, NULL);
+        if (val == -1.0 && PyErr_Occurred()) {
+            return NULL;
+        }
+        if (pend != data + len) {
+            PyErr_SetString(PoqueError, "Invalid numeric value");
+            return NULL;
+        }
+        return PyFloat_FromDouble(val);
+    }
+    if (mode == NUMERIC_AS_INT) {
+        int i;
 
-static int
-numeric_set_digit(PyObject *digit_tuple, int val, Py_ssize_t idx) {
-    PyObject *digit;
+        int_strnative(data, len, &value);
+        if (value.kind == NATIVE_INT) {
+            return PyLong_FromLongLong(value.val.i);
+        }
+        /* only plain integers, no NaN, Infinity or decimal point */
+        for (i = (len > 1 && data[0] == '-'); i < len; i++) {
+            if (data[i] < '0' || data[i] > '9') {
+                break;
+            }
+        }
+        if (i == len && len) {
+            return numeric_int_from_str(data, len);
+        }
+    }
+    return numeric_from_str(data, len);
+}
 
-    /* create the digit */
-    digit = PyLong_FromLong(val);
-    if (digit == NULL)
-        return -1;
 
-    /* Add it to the tuple */
-    PyTuple_SET_ITEM(digit_tuple, idx, digit);
-    return 0;
+static inline char *
+numeric_write_digit(char *pos, poque_uint16 pg_digit, int n)
+{
+    /* writes the first n decimal digits of a pg digit */
+    char digits[4];
+
+    digits[0] = '0' + pg_digit / 1000;
+    digits[1] = '0' + pg_digit / 100 % 10;
+    digits[2] = '0' + pg_digit / 10 % 10;
+    digits[3] = '0' + pg_digit % 10;
+    memcpy(pos, digits, n);
+    return pos + n;
 }
 
 
+/* Size of the stack buffer for the string representation. Larger values use
+ * the heap */
+#define NUMERIC_BUF_SIZE 128
+
+
 static PyObject *
 numeric_binval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
@@ -870,14 +1200,17 @@ numeric_binval(
      * weight, which is like the decimal exponent, but than with a 10000 base
      * instead of 10.
      *
-     * This conversion function will add the zeroes, so the precision of both
-     * the binary as the text conversion deliver the same result
-     *
+     * The base 10000 digits are written to a string in the same format as
+     * the text representation, including the trailing zeroes, so the
+     * precision of both the binary as the text conversion deliver the same
+     * result. The string is then converted in a single call.
      */
     poque_uint16 npg_digits, sign, dscale;
     poque_int16 weight;
-    PyObject *digits, *ret=NULL, *zero=NULL;
-    Py_ssize_t ndigits, j, i;
+    char buf[NUMERIC_BUF_SIZE], *str, *pos, mode;
+    Py_ssize_t size;
+    PyObject *ret;
+    int i;
 
     if (len < 8) {
         PyErr_SetString(PoqueError, "Invalid numeric value");
@@ -892,101 +1225,347 @@ numeric_binval(
     weight = read_int16(data + 2);
     sign = read_uint16(data + 4);
     dscale = read_uint16(data + 6);
-    /* TODO check valid scale like postgres does */
+    data += 8;
+    mode = result->conn->numeric_as;
 
     /* Check sign */
     if (sign == NUMERIC_NAN) {
         /* We're done it's a NaN */
+        if (mode == NUMERIC_AS_FLOAT) {
+            return PyFloat_FromDouble(Py_NAN);
+        }
         return PyObject_CallFunction(PyDecimal, "s", "NaN");
     }
-    if (sign == NUMERIC_NEG) {
-        sign = 1;
+    if (sign == NUMERIC_PINF || sign == NUMERIC_NINF) {
+        if (mode == NUMERIC_AS_FLOAT) {
+            return PyFloat_FromDouble(
+                sign == NUMERIC_PINF ? Py_HUGE_VAL : -Py_HUGE_VAL);
+        }
+        return PyObject_CallFunction(
+            PyDecimal, "s", sign == NUMERIC_PINF ? "Infinity" : "-Infinity");
     }
-    else if (sign != NUMERIC_POS) {
+    if (sign != NUMERIC_NEG && sign != NUMERIC_POS) {
         PyErr_SetString(PoqueError, "Invalid value for numeric sign");
         return NULL;
     }
+    for (i = 0; i < npg_digits; i++) {
+        if (read_uint16(data + i * 2) > 9999) {
+            PyErr_SetString(PoqueError, "Invalid numeric value");
+            return NULL;
+        }
+    }
 
-    /* create a tuple to hold the digits */
-    ndigits = dscale + (weight + 1) * 4;
-    digits = PyTuple_New(ndigits);
-    if (digits == NULL) {
-    	return NULL;
+    /* sign, integral digits, decimal point, scale digits and terminator */
+    size = 1 + (weight < 0 ? 1 : (weight + 1) * 4) + 1 + dscale + 1;
+    if (size <= NUMERIC_BUF_SIZE) {
+        str = buf;
+    }
+    else {
+        str = PyMem_Malloc(size);
+        if (str == NULL) {
+            return PyErr_NoMemory();
+        }
+    }
+    pos = str;
+    if (sign == NUMERIC_NEG) {
+        *pos++ = '-';
     }
 
-    /* fill the digits from pg digits */
-    j = 0;
-    data += 8;
-    for (i = 0; i < npg_digits; i++) {
-        /* fill from postgres digits. A postgres digit contains 4 decimal
-         * digits */
+    /* integral part, the first digit without leading zeroes */
+    if (weight < 0) {
+        *pos++ = '0';
+    }
+    else {
         poque_uint16 pg_digit;
 
-        pg_digit = read_uint16(data + i * 2);
-
-        if (pg_digit > 9999) {
-            PyErr_SetString(PoqueError, "Invalid numeric value");
-            goto end;
+        pg_digit = npg_digits ? read_uint16(data) : 0;
+        for (i = 4; i > 1 && pg_digit < 1000; i--) {
+            pg_digit *= 10;
         }
-        if (numeric_set_digit(digits, pg_digit / 1000, j++) < 0)
-            goto end;
-        if (j == ndigits) {
-            break;
+        pos = numeric_write_digit(pos, pg_digit, i);
+        for (i = 1; i <= weight; i++) {
+            pg_digit = i < npg_digits ? read_uint16(data + i * 2) : 0;
+            pos = numeric_write_digit(pos, pg_digit, 4);
         }
-        pg_digit = pg_digit % 1000;
-        if (numeric_set_digit(digits, pg_digit / 100, j++) < 0)
-            goto end;
-        if (j == ndigits) {
-            break;
+    }
+
+    /* fractional part, up to dscale digits */
+    if (dscale) {
+        int n = dscale;
+
+        *pos++ = '.';
+        for (i = weight + 1; n > 0; i++) {
+            poque_uint16 pg_digit;
+
+            pg_digit = (i >= 0 && i < npg_digits) ?
+                read_uint16(data + i * 2) : 0;
+            pos = numeric_write_digit(pos, pg_digit, n < 4 ? n : 4);
+            n -= 4;
         }
-        pg_digit = pg_digit % 100;
-        if (numeric_set_digit(digits, pg_digit / 10, j++) < 0)
-            goto end;
-        if (j == ndigits) {
-            break;
+    }
+    size = pos - str;
+
+    if (mode == NUMERIC_AS_INT && dscale == 0) {
+        ret = numeric_int_from_str(str, size);
+    }
+    else if (mode == NUMERIC_AS_FLOAT) {
+        double val;
+
+        *pos = '\0';
+        val = PyOS_string_to_double(str, NULL, NULL);
+        ret = (val == -1.0 && PyErr_Occurred()) ?
+            NULL : PyFloat_FromDouble(val);
+    }
+    else {
+        ret = numeric_from_str(str, size);
+    }
+    if (str != buf) {
+        PyMem_Free(str);
+    }
+    return ret;
+}
+
+/* ==== native readers ===================================================== */
+
+/* These run without the GIL. Anything unexpected is left as NATIVE_NONE, the
+ * regular reader will then raise the appropriate error.
+ */
+
+static void
+int16_binnative(char *data, int len, NativeValue *value)
+{
+    if (len == 2) {
+        value->kind = NATIVE_INT;
+        value->val.i = read_int16(data);
+    }
+}
+
+
+static void
+int32_binnative(char *data, int len, NativeValue *value)
+{
+    if (len == 4) {
+        value->kind = NATIVE_INT;
+        value->val.i = read_int32(data);
+    }
+}
+
+
+static void
+int64_binnative(char *data, int len, NativeValue *value)
+{
+    if (len == 8) {
+        value->kind = NATIVE_INT;
+        value->val.i = read_int64(data);
+    }
+}
+
+
+static void
+uint32_binnative(char *data, int len, NativeValue *value)
+{
+    if (len == 4) {
+        value->kind = NATIVE_INT;
+        value->val.i = read_uint32(data);
+    }
+}
+
+
+static void
+int_strnative(char *data, int len, NativeValue *value)
+{
+    PY_INT64_T val = 0;
+    char *end = data + len;
+    int neg = 0;
+
+    if (data < end && *data == '-') {
+        neg = 1;
+        data++;
+    }
+    /* at most 18 digits, so it can not overflow */
+    if (data == end || end - data > 18) {
+        return;
+    }
+    for (; data < end; data++) {
+        if (*data < '0' || *data > '9') {
+            return;
         }
-        if (numeric_set_digit(digits, pg_digit % 10, j++) < 0)
-            goto end;
-        if (j == ndigits) {
-            break;
+        val = val * 10 + (*data - '0');
+    }
+    value->kind = NATIVE_INT;
+    value->val.i = neg ? -val : val;
+}
+
+
+static void
+bool_binnative(char *data, int len, NativeValue *value)
+{
+    if (len == 1) {
+        value->kind = NATIVE_BOOL;
+        value->val.i = *data;
+    }
+}
+
+
+static void
+bool_strnative(char *data, int len, NativeValue *value)
+{
+    if (len == 1) {
+        value->kind = NATIVE_BOOL;
+        value->val.i = (*data == 't');
+    }
+}
+
+
+static void
+float_strnative(char *data, int len, NativeValue *value)
+{
+    /* Converts the common float text values without strtod.
+     *
+     * A mantissa of at most 2^53 and a power of ten of at most 22 are both
+     * exactly representable as double, so one multiplication or division
+     * gives the correctly rounded result. Anything else is left to the
+     * regular reader.
+     */
+#ifndef X87_DOUBLE_ROUNDING
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+        1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    PY_UINT64_T mant = 0;
+    char *end = data + len;
+    int neg = 0, ndigits = 0, exp10 = 0, any = 0;
+    double val;
+
+    if (data < end && *data == '-') {
+        neg = 1;
+        data++;
+    }
+    if (end - data == 8 && memcmp(data, "Infinity", 8) == 0) {
+        value->kind = NATIVE_FLOAT;
+        value->val.d = neg ? -Py_HUGE_VAL : Py_HUGE_VAL;
+        return;
+    }
+    if (!neg && len == 3 && memcmp(data, "NaN", 3) == 0) {
+        value->kind = NATIVE_FLOAT;
+        value->val.d = Py_NAN;
+        return;
+    }
+    for (; data < end && *data >= '0' && *data <= '9'; data++) {
+        mant = mant * 10 + (*data - '0');
+        ndigits += (mant != 0);
+        any = 1;
+    }
+    if (data < end && *data == '.') {
+        for (data++; data < end && *data >= '0' && *data <= '9'; data++) {
+            mant = mant * 10 + (*data - '0');
+            ndigits += (mant != 0);
+            exp10--;
+            any = 1;
         }
     }
+    if (!any || ndigits > 16) {
+        return;
+    }
+    if (data < end && (*data == 'e' || *data == 'E')) {
+        int exp_neg = 0, exp = 0, n = 0;
 
-    if (j < ndigits) {
-        /* add trailing zeroes */
-        zero = PyLong_FromLong(0);
-        if (zero == NULL) {
-            goto end;
+        data++;
+        if (data < end && (*data == '-' || *data == '+')) {
+            exp_neg = (*data == '-');
+            data++;
         }
-        for (; j < ndigits; j++) {
-            Py_INCREF(zero);
-            PyTuple_SET_ITEM(digits, j, zero);
+        for (; data < end && *data >= '0' && *data <= '9' && n < 4; data++) {
+            exp = exp * 10 + (*data - '0');
+            n++;
         }
-        Py_DECREF(zero);
+        if (n == 0) {
+            return;
+        }
+        exp10 += exp_neg ? -exp : exp;
+    }
+    if (data != end || mant > ((PY_UINT64_T)1 << 53)) {
+        return;
+    }
+    val = (double)mant;
+    if (exp10 < 0) {
+        if (exp10 < -22) {
+            return;
+        }
+        val /= pow10[-exp10];
     }
+    else if (exp10 > 0) {
+        if (exp10 > 22) {
+            return;
+        }
+        val *= pow10[exp10];
+    }
+    value->kind = NATIVE_FLOAT;
+    value->val.d = neg ? -val : val;
+#endif
+}
 
-    /* create the Decimal now */
-    ret = PyObject_CallFunction(
-        PyDecimal, "((HOi))", sign, digits, -(int)dscale);
 
-end:
-    Py_DECREF(digits);
-    return ret;
+#if defined(DOUBLE_IS_LITTLE_ENDIAN_IEEE754) || \
+        defined(DOUBLE_IS_BIG_ENDIAN_IEEE754)
+
+static void
+float64_binnative(char *data, int len, NativeValue *value)
+{
+    PY_UINT64_T v;
+
+    if (len == 8) {
+        v = read_uint64(data);
+        memcpy(&value->val.d, &v, 8);
+        value->kind = NATIVE_FLOAT;
+    }
+}
+
+
+static void
+float32_binnative(char *data, int len, NativeValue *value)
+{
+    PY_UINT32_T v;
+    float f;
+
+    if (len == 4) {
+        v = read_uint32(data);
+        memcpy(&f, &v, 4);
+        value->val.d = f;
+        value->kind = NATIVE_FLOAT;
+    }
 }
 
-PoqueValueHandler int2_val_handler = {{long_strval, int16_binval}, ',', NULL};
-PoqueValueHandler int4_val_handler = {{long_strval, int32_binval}, ',', NULL};
+#else
+#define float64_binnative NULL
+#define float32_binnative NULL
+#endif
+
+
+PoqueValueHandler int2_val_handler = {
+        {long_strval, int16_binval}, ',', NULL,
+        {int_strnative, int16_binnative}};
+PoqueValueHandler int4_val_handler = {
+        {long_strval, int32_binval}, ',', NULL,
+        {int_strnative, int32_binnative}};
 PoqueValueHandler int8_val_handler = {
-        {longlong_strval, int64_binval}, ',', NULL};
+        {longlong_strval, int64_binval}, ',', NULL,
+        {int_strnative, int64_binnative}};
 PoqueValueHandler float4_val_handler = {
-        {float_strval, float32_binval}, ',', NULL};
+        {float_strval, float32_binval}, ',', NULL,
+        {float_strnative, float32_binnative}};
 PoqueValueHandler float8_val_handler = {
-        {float_strval, float64_binval}, ',', NULL};
-PoqueValueHandler bool_val_handler = {{bool_strval, bool_binval}, ',', NULL};
+        {float_strval, float64_binval}, ',', NULL,
+        {float_strnative, float64_binnative}};
+PoqueValueHandler bool_val_handler = {
+        {bool_strval, bool_binval}, ',', NULL,
+        {bool_strnative, bool_binnative}};
 PoqueValueHandler numeric_val_handler = {
         {numeric_strval, numeric_binval}, ',', NULL};
-PoqueValueHandler cash_val_handler = {{text_val, int64_binval}, ',', NULL};
-PoqueValueHandler id_val_handler = {{ulong_strval, uint32_binval}, ',', NULL};
+PoqueValueHandler cash_val_handler = {
+        {text_val, int64_binval}, ',', NULL, {NULL, int64_binnative}};
+PoqueValueHandler id_val_handler = {
+        {ulong_strval, uint32_binval}, ',', NULL,
+        {int_strnative, uint32_binnative}};
 PoqueValueHandler regproc_val_handler = {{text_val, uint32_binval}, ',', NULL};
 
 PoqueValueHandler int2array_val_handler = {
@@ -1023,5 +1602,9 @@ init_numeric(void) {
     register_parameter_handler((PyTypeObject *)PyDecimal,
                                new_decimal_param_handler);
 
+    register_list_encoder(&PyLong_Type, int_list_examine, int_list_write);
+    register_list_encoder(&PyFloat_Type, float_list_examine, float_list_write);
+    register_list_encoder(&PyBool_Type, bool_list_examine, bool_list_write);
+
     return 0;
 }
@@ -264,6 +264,83 @@ PyInit__poque(void)
     if (PyType_Ready(&PoqueCursorType) < 0)
         return NULL;
 
+    if (PyType_Ready(&PoqueJsonType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueJsonType);
+    if (PyModule_AddObject(m, "Json", (PyObject *)&PoqueJsonType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueBitStringType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueBitStringType);
+    if (PyModule_AddObject(
+            m, "BitString", (PyObject *)&PoqueBitStringType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueArrayBufferType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueArrayBufferType);
+    if (PyModule_AddObject(
+            m, "ArrayBuffer", (PyObject *)&PoqueArrayBufferType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueMaskedArrayType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueMaskedArrayType);
+    if (PyModule_AddObject(
+            m, "MaskedArray", (PyObject *)&PoqueMaskedArrayType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoquePathType) < 0)
+        return NULL;
+    Py_INCREF(&PoquePathType);
+    if (PyModule_AddObject(m, "Path", (PyObject *)&PoquePathType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoquePolygonType) < 0)
+        return NULL;
+    Py_INCREF(&PoquePolygonType);
+    if (PyModule_AddObject(
+            m, "Polygon", (PyObject *)&PoquePolygonType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueRangeType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueRangeType);
+    if (PyModule_AddObject(m, "Range", (PyObject *)&PoqueRangeType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueVectorType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueVectorType);
+    if (PyModule_AddObject(
+            m, "Vector", (PyObject *)&PoqueVectorType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueEncodedType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueEncodedType);
+    if (PyModule_AddObject(
+            m, "Encoded", (PyObject *)&PoqueEncodedType) == -1) {
+        return NULL;
+    }
+
+    if (PyType_Ready(&PoqueJsonValueType) < 0)
+        return NULL;
+    Py_INCREF(&PoqueJsonValueType);
+    if (PyModule_AddObject(
+            m, "JsonValue", (PyObject *)&PoqueJsonValueType) == -1) {
+        return NULL;
+    }
+
 
     /* Add result type to the module */
 /*    Py_INCREF(&PoqueResultType);
@@ -309,6 +386,8 @@ PyInit__poque(void)
     if (PyModule_AddIntMacro(m, XMLOID) == -1) return NULL;
     if (PyModule_AddIntMacro(m, XMLARRAYOID) == -1) return NULL;
     if (PyModule_AddIntMacro(m, JSONARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, RECORDOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, RECORDARRAYOID) == -1) return NULL;
 
     if (PyModule_AddIntMacro(m, POINTOID) == -1) return NULL;
     if (PyModule_AddIntMacro(m, LSEGOID) == -1) return NULL;
@@ -338,6 +417,30 @@ PyInit__poque(void)
 
     if (PyModule_AddIntMacro(m, CIRCLEOID) == -1) return NULL;
     if (PyModule_AddIntMacro(m, CIRCLEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT4RANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT4RANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, NUMRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, NUMRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSTZRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSTZRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, DATERANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, DATERANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT8RANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT8RANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT4MULTIRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT4MULTIRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, NUMMULTIRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, NUMMULTIRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSMULTIRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSMULTIRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSTZMULTIRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, TSTZMULTIRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, DATEMULTIRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, DATEMULTIRANGEARRAYOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT8MULTIRANGEOID) == -1) return NULL;
+    if (PyModule_AddIntMacro(m, INT8MULTIRANGEARRAYOID) == -1) return NULL;
 
     if (PyModule_AddIntMacro(m, CASHOID) == -1) return NULL;
     if (PyModule_AddIntMacro(m, CASHARRAYOID) == -1) return NULL;
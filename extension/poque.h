@@ -1,6 +1,7 @@
 #ifndef _POQUE_H_
 #define _POQUE_H_
 
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <libpq-fe.h>
 #include <structmember.h>
@@ -19,9 +20,62 @@ typedef struct {
     Py_ssize_t last_oids_len;
     PyObject *wr_list;
     char *warning_msg;
+    PyObject *session_tz;       /* zoneinfo of the TimeZone setting */
+    PyObject *session_tz_name;  /* TimeZone setting of session_tz */
     char autocommit;
+    char session_timezone;      /* return timestamptz values in TimeZone */
+    char uuid_as;               /* type of uuid values, see UUID_AS_* */
+    char numeric_as;            /* type of numeric values, see NUMERIC_AS_* */
+    char json_as;               /* type of json values, see JSON_AS_* */
+    PyObject *json_loads;       /* custom json loads function */
+    char bit_as;                /* type of bit values, see BIT_AS_* */
+    char array_as;              /* type of array values, see ARRAY_AS_* */
+    char geometry_as;           /* type of path and polygon values, see
+                                   GEOMETRY_AS_* */
+    char inet_as;               /* type of inet and cidr values, see
+                                   INET_AS_* */
+    PyObject *type_handlers;    /* value handlers of registered types by oid,
+                                   replaced on registration, never changed */
+    Oid hstore_oid;             /* oid of hstore once registered, dict
+                                   parameters are sent as hstore then */
+    Oid hstore_array_oid;
+    Oid vector_oid;             /* oids of pgvector types once registered */
+    Oid halfvec_oid;
 } PoqueConn;
 
+/* values for PoqueConn.uuid_as */
+#define UUID_AS_UUID        0
+#define UUID_AS_BYTES       1
+#define UUID_AS_INT         2
+#define UUID_AS_STR         3
+
+/* values for PoqueConn.numeric_as */
+#define NUMERIC_AS_DECIMAL  0
+#define NUMERIC_AS_INT      1   /* int when scale is zero, Decimal otherwise */
+#define NUMERIC_AS_FLOAT    2
+
+/* values for PoqueConn.json_as */
+#define JSON_AS_OBJECT      0
+#define JSON_AS_STR         1
+#define JSON_AS_BYTES       2
+#define JSON_AS_LAZY        3   /* JsonValue, parsed on first access */
+
+/* values for PoqueConn.bit_as */
+#define BIT_AS_INT          0
+#define BIT_AS_BITSTRING    1
+
+/* values for PoqueConn.array_as */
+#define ARRAY_AS_LIST       0
+#define ARRAY_AS_BUFFER     1   /* ArrayBuffer for fixed width items */
+
+/* values for PoqueConn.geometry_as */
+#define GEOMETRY_AS_TUPLE   0
+#define GEOMETRY_AS_BUFFER  1   /* Path and Polygon with an ArrayBuffer */
+
+/* values for PoqueConn.inet_as */
+#define INET_AS_IPADDRESS   0
+#define INET_AS_RAW         1   /* (family, int, prefixlen) tuple */
+
 #include "cursor.h"
 
 #if SIZEOF_SHORT != 2
@@ -57,9 +111,37 @@ typedef PyObject *(*pq_read)(
     PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler);
 
 
+/* Native values are the intermediate form of a value when a batch of rows
+ * is converted. Native readers fill them in without touching Python objects,
+ * so they can run without holding the GIL.
+ */
+#define NATIVE_NONE         0   /* not converted, use regular reader */
+#define NATIVE_NULL         1
+#define NATIVE_INT          2
+#define NATIVE_FLOAT        3
+#define NATIVE_BOOL         4
+#define NATIVE_ASCII        5   /* text consisting of ASCII only */
+
+typedef struct _nativeValue {
+    char *data;
+    int len;
+    int kind;
+    union {
+        PY_INT64_T i;
+        double d;
+    } val;
+} NativeValue;
+
+typedef void (*pq_native)(char *data, int len, NativeValue *value);
+
+
+typedef struct _valueMemo ValueMemo;
+
 typedef struct _resultValueReader {
     pq_read read_func;
+    pq_native native_func;
     PoqueValueHandler *el_handler;
+    ValueMemo *memo;
 } ResultValueReader;
 
 
@@ -68,6 +150,7 @@ typedef struct PoqueResult {
     PGresult *result;
     PyObject *wr_list;
     PoqueConn *conn;
+    PyObject *type_handlers;    /* registered types of the connection */
     ResultValueReader readers[];
 } PoqueResult;
 
@@ -84,12 +167,28 @@ extern PyTypeObject PoqueConnType;
 extern PyTypeObject PoqueResultType;
 extern PyTypeObject PoqueValueType;
 extern PyTypeObject PoqueCursorType;
+extern PyTypeObject PoqueJsonValueType;
+extern PyTypeObject PoqueJsonType;
+extern PyTypeObject PoqueBitStringType;
+extern PyTypeObject PoqueArrayBufferType;
+extern PyTypeObject PoqueMaskedArrayType;
+extern PyTypeObject PoqueEncodedType;
+extern PyTypeObject PoquePathType;
+extern PyTypeObject PoquePolygonType;
+extern PyTypeObject PoqueRangeType;
+extern PyTypeObject PoqueVectorType;
 
 PGresult *_Conn_execute(
     PoqueConn *self, PyObject *command, PyObject *parameters, int format);
+PGresult *_Conn_execute_after(
+    PoqueConn *self, const char *before, PyObject *command,
+    PyObject *parameters, int format);
+PyObject *_Conn_execute_multi(
+    PoqueConn *self, const char *before, PyObject *command);
 
 PoqueResult *PoqueResult_New(PGresult *res, PoqueConn *conn);
 PyObject *_Result_value(PoqueResult *self, int row, int column);
+int _Result_rows(PoqueResult *self, int row, int nrows, PyObject *rows);
 
 PyObject *Poque_info_options(PQconninfoOption *options);
 PyObject *Poque_value(PoqueResult *result, Oid oid, int format, char *data,
@@ -157,6 +256,8 @@ PyObject *Poque_value(PoqueResult *result, Oid oid, int format, char *data,
 #define XMLOID              142
 #define JSONARRAYOID        199
 #define XMLARRAYOID         143
+#define RECORDOID           2249
+#define RECORDARRAYOID      2287
 
 /* geometric types */
 #define POINTOID            600
@@ -174,6 +275,32 @@ PyObject *Poque_value(PoqueResult *result, Oid oid, int format, char *data,
 #define CIRCLEOID           718
 #define CIRCLEARRAYOID      719
 
+/* range types */
+#define INT4RANGEOID        3904
+#define NUMRANGEOID         3906
+#define TSRANGEOID          3908
+#define TSTZRANGEOID        3910
+#define DATERANGEOID        3912
+#define INT8RANGEOID        3926
+#define INT4MULTIRANGEOID   4451
+#define NUMMULTIRANGEOID    4532
+#define TSMULTIRANGEOID     4533
+#define TSTZMULTIRANGEOID   4534
+#define DATEMULTIRANGEOID   4535
+#define INT8MULTIRANGEOID   4536
+#define INT4RANGEARRAYOID   3905
+#define NUMRANGEARRAYOID    3907
+#define TSRANGEARRAYOID     3909
+#define TSTZRANGEARRAYOID   3911
+#define DATERANGEARRAYOID   3913
+#define INT8RANGEARRAYOID   3927
+#define INT4MULTIRANGEARRAYOID 6150
+#define NUMMULTIRANGEARRAYOID 6151
+#define TSMULTIRANGEARRAYOID 6152
+#define TSTZMULTIRANGEARRAYOID 6153
+#define DATEMULTIRANGEARRAYOID 6155
+#define INT8MULTIRANGEARRAYOID 6157
+
 /* floating point types */
 #define FLOAT4OID           700
 #define FLOAT8OID           701
@@ -231,6 +358,8 @@ int init_type_map(void);
 #define NUMERIC_NAN         0xC000
 #define NUMERIC_POS         0x0000
 #define NUMERIC_NEG         0x4000
+#define NUMERIC_PINF        0xD000
+#define NUMERIC_NINF        0xF000
 
 PyObject *load_python_object(const char *module_name, const char *obj_name);
 #define load_python_type(m, o) ((PyTypeObject *)load_python_object(m, o))
@@ -5,6 +5,12 @@
 #include "datetime.h"
 #include "network.h"
 #include "geometric.h"
+#include "range.h"
+#include "hstore.h"
+#include "json.h"
+#include "bitstring.h"
+#include "buffer.h"
+#include "encoded.h"
 
 
 /* ======= param handlers ====================================================
@@ -72,6 +78,25 @@ new_param_handler(param_handler *def_handler, size_t handler_size) {
     return handler;
 }
 
+
+param_handler *
+new_cache_param_handler(param_handler *def_handler, size_t def_size,
+                        int num_params, size_t param_size) {
+    /* Allocator for param handlers followed by a cache of num_params values.
+     *
+     * Only the static struct itself is copied, the cache is left
+     * uninitialized.
+     */
+    param_handler *handler; /* handler to create */
+
+    handler = PyMem_Malloc(def_size + num_params * param_size);
+    if (handler == NULL) {
+        return (param_handler *)PyErr_NoMemory();
+    }
+    memcpy(handler, def_handler, def_size);
+    return handler;
+}
+
 /* param handler table record */
 typedef struct _param_handler_constructor {
     PyTypeObject *typ;
@@ -79,15 +104,24 @@ typedef struct _param_handler_constructor {
 } param_handler_constructor;
 
 /* param handler table */
-static param_handler_constructor param_handler_constructors[15];
+#define MAX_PARAM_HANDLERS  32
+static param_handler_constructor param_handler_constructors[
+    MAX_PARAM_HANDLERS];
 static int num_phcons = 0;
 
+/* set when a registration did not fit, init_type_map fails on it */
+static int registration_overflow = 0;
+
 
 void
 register_parameter_handler(PyTypeObject *typ, ph_new constructor) {
     /* registers a parameter handler for a Python type */
     param_handler_constructor *cons;
 
+    if (num_phcons == MAX_PARAM_HANDLERS) {
+        registration_overflow = 1;
+        return;
+    }
     cons = param_handler_constructors + num_phcons++;
     cons->typ = typ;
     cons->constructor = constructor;
@@ -99,7 +133,8 @@ get_param_handler_constructor(PyTypeObject *typ) {
     /* Returns the appropriate param handler for a Python type from the
      * registered handlers.
      *
-     * The text parameter handler is the fallback
+     * Other objects supporting the buffer protocol are sent as arrays, the
+     * text parameter handler is the fallback
      */
     int i;
     param_handler_constructor *cons;
@@ -110,10 +145,55 @@ get_param_handler_constructor(PyTypeObject *typ) {
             return cons->constructor;
         }
     }
+    if (typ && typ->tp_as_buffer && typ->tp_as_buffer->bf_getbuffer) {
+        return new_buffer_param_handler;
+    }
     return new_object_param_handler;
 }
 
 
+/* list encoder table record */
+typedef struct _list_encoder {
+    PyTypeObject *typ;
+    le_examine examine;
+    le_write write;
+} list_encoder;
+
+/* list encoder table */
+#define MAX_LIST_ENCODERS  8
+static list_encoder list_encoders[MAX_LIST_ENCODERS];
+static int num_list_encoders = 0;
+
+
+void
+register_list_encoder(PyTypeObject *typ, le_examine examine, le_write write) {
+    /* registers a fast path for flat lists of a Python type */
+    list_encoder *le;
+
+    if (num_list_encoders == MAX_LIST_ENCODERS) {
+        registration_overflow = 1;
+        return;
+    }
+    le = list_encoders + num_list_encoders++;
+    le->typ = typ;
+    le->examine = examine;
+    le->write = write;
+}
+
+
+static list_encoder *
+get_list_encoder(PyTypeObject *typ) {
+    int i;
+
+    for (i = 0; i < num_list_encoders; i++) {
+        if (typ == list_encoders[i].typ) {
+            return list_encoders + i;
+        }
+    }
+    return NULL;
+}
+
+
 /* compatible param type record */
 typedef struct _compatible_type {
     PyTypeObject *typ1;
@@ -183,6 +263,8 @@ write_uint64(char **p, PY_UINT64_T val) {
  */
 typedef struct _ArrayParamHandler {
     param_handler handler;      /* base handler */
+    list_encoder *encoder;      /* fast path for flat lists */
+    list_encoding encoding;     /* element type used by the fast path */
     param_handler *el_handler;  /* param handler of elements */
     PyTypeObject *el_type;      /* Python type of elements */
     int has_null;               /* Are there None/NULL values */
@@ -190,6 +272,8 @@ typedef struct _ArrayParamHandler {
     int num_items;              /* number of non NULL items */
     unsigned int num_dims;      /* number of dimensions */
     int dims[6];                /* sizes of dimensions */
+    Oid hstore_oid;             /* dict items are hstore values when set */
+    Oid hstore_array_oid;
 } ArrayParamHandler;
 
 
@@ -321,11 +405,58 @@ static int array_examine_items(ArrayParamHandler *handler, PyObject *param) {
 }
 
 
+static int
+array_examine_flat(ArrayParamHandler *handler, PyObject *param) {
+    /* Examines a flat list of a single Python type with a list encoder.
+     * Returns -2 if the generic path must be used.
+     */
+    PyObject **items;
+    Py_ssize_t n, i, size;
+    list_encoder *encoder;
+
+    n = PyList_GET_SIZE(param);
+    items = ((PyListObject *)param)->ob_item;
+
+    /* the first non None item determines the encoder */
+    for (i = 0; i < n && items[i] == Py_None; i++);
+    if (i == n) {
+        return -2;
+    }
+    encoder = get_list_encoder(Py_TYPE(items[i]));
+    if (encoder == NULL) {
+        return -2;
+    }
+    size = encoder->examine(items, n, &handler->encoding);
+    if (size < 0) {
+        return (int)size;
+    }
+
+    /* header, one dimension, the lengths and the items */
+    size += 20 + n * 4;
+    if (size > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "Array too large");
+        return -1;
+    }
+    handler->encoder = encoder;
+    handler->has_null = (handler->encoding.num_null != 0);
+    handler->num_dims = 1;
+    handler->dims[0] = (int)n;
+    handler->handler.oid = handler->encoding.array_oid;
+    return (int)size;
+}
+
+
 static int
 array_examine(ArrayParamHandler *handler, PyObject *param) {
     int size, total_items;
     unsigned int i;
 
+    /* try the fast path first */
+    size = array_examine_flat(handler, param);
+    if (size != -2) {
+        return size;
+    }
+
     /* First examine the list */
     if (array_examine_list(handler, param, 0) < 0) {
         return -1;
@@ -333,8 +464,18 @@ array_examine(ArrayParamHandler *handler, PyObject *param) {
 
     /* Python type and number of items is known. Now we can set the element
      * parameter handler */
-    handler->el_handler = get_param_handler_constructor(handler->el_type)(
-                              handler->num_items);
+    if (handler->hstore_oid != InvalidOid &&
+            PyType_IsSubtype(handler->el_type, &PyDict_Type)) {
+        handler->el_handler = new_hstore_param_handler(
+            handler->hstore_oid, handler->hstore_array_oid);
+    }
+    else {
+        handler->el_handler = get_param_handler_constructor(
+            handler->el_type)(handler->num_items);
+    }
+    if (handler->el_handler == NULL) {
+        return -1;
+    }
 
     /* examine the elements to get total element size */
     size = array_examine_items(handler, param);
@@ -356,6 +497,10 @@ array_examine(ArrayParamHandler *handler, PyObject *param) {
     for (i = 0; i < handler->num_dims; i++) {
         total_items *= handler->dims[i];
     }
+    if (handler->el_handler->array_oid == InvalidOid) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported array element type");
+        return -1;
+    }
     handler->handler.oid = handler->el_handler->array_oid;
     return 12 + handler->num_dims * 8 + total_items * 4 + size;
 }
@@ -418,7 +563,8 @@ array_encode_at(ArrayParamHandler *handler, PyObject *param, char *loc) {
     /* write array header */
     write_uint32(&loc, handler->num_dims);
     write_uint32(&loc, handler->has_null);
-    write_uint32(&loc, handler->el_handler->oid);
+    write_uint32(&loc, handler->encoder ?
+        handler->encoding.oid : handler->el_handler->oid);
 
     /* write dimension headers */
     for(i = 0; i < handler->num_dims; i++) {
@@ -427,6 +573,11 @@ array_encode_at(ArrayParamHandler *handler, PyObject *param, char *loc) {
     }
 
     /* write values */
+    if (handler->encoder) {
+        return handler->encoder->write(
+            ((PyListObject *)param)->ob_item, PyList_GET_SIZE(param),
+            &handler->encoding, loc);
+    }
     i = array_write_values(handler, param, &loc);
     return i;
 }
@@ -460,13 +611,17 @@ new_array_param_handler(int num_param) {
             TEXTARRAYOID,                   /* oid */
             InvalidOid                      /* array oid */
         },
+        NULL,                               /* encoder */
+        {InvalidOid, InvalidOid, 0},        /* encoding */
         NULL,                               /* el_handler */
         NULL,                               /* el_type */
         0,                                  /* has_null */
         -1,                                 /* item_depth */
         0,                                  /* num_items */
         0,                                  /* num_dims */
-        {-1, -1, -1, -1, -1, -1}            /* dims */
+        {-1, -1, -1, -1, -1, -1},           /* dims */
+        InvalidOid,                         /* hstore_oid */
+        InvalidOid                          /* hstore_array_oid */
     }; /* static initialized handler */
 
     return new_param_handler((param_handler *)&def_handler,
@@ -474,6 +629,22 @@ new_array_param_handler(int num_param) {
 }
 
 
+param_handler *
+new_hstore_array_param_handler(Oid hstore_oid, Oid hstore_array_oid) {
+    /* array parameter handler of a connection with a registered hstore
+     * type, dicts in the list are sent as hstore values
+     */
+    ArrayParamHandler *handler;
+
+    handler = (ArrayParamHandler *)new_array_param_handler(1);
+    if (handler != NULL) {
+        handler->hstore_oid = hstore_oid;
+        handler->hstore_array_oid = hstore_array_oid;
+    }
+    return (param_handler *)handler;
+}
+
+
 PyObject *
 load_python_object(const char *module_name, const char *obj_name) {
     PyObject *module, *obj;
@@ -584,7 +755,8 @@ array_binval(
 {
     unsigned int i;
     PY_UINT32_T dims;
-    PY_INT32_T flags, arraydims[7];
+    PY_INT32_T flags, arraydims[ARRAY_MAXDIM + 1];
+    const ArrayItemType *item_type = NULL;
     PyObject *val;
     data_crs crs;
 
@@ -595,7 +767,7 @@ array_binval(
     flags = read_int32(data + 4);
 
     /* check header values */
-    if (dims > 6) {
+    if (dims > ARRAY_MAXDIM) {
         PyErr_SetString(PoqueError, "Number of dimensions exceeded");
         return NULL;
     }
@@ -604,9 +776,17 @@ array_binval(
         return NULL;
     }
 
+    /* fixed width items without NULLs can go into a buffer */
+    if (result->conn->array_as == ARRAY_AS_BUFFER && flags == 0) {
+        item_type = array_item_type(el_handler);
+    }
+
     /* zero dimension array, just return an empty list */
     if (dims == 0) {
         CHECK_LENGTH_EQ(len, 12, "array", NULL);
+        if (item_type != NULL) {
+            return array_buffer_binval(NULL, 0, 0, NULL, item_type);
+        }
         return PyList_New(0);
     }
 
@@ -627,6 +807,10 @@ array_binval(
     }
     arraydims[i] = -1;  /* terminate dimensions array */
 
+    if (item_type != NULL) {
+        return array_buffer_binval(data, len, dims, arraydims, item_type);
+    }
+
     /* actually get the array */
     crs.data = data;
     crs.len = len;
@@ -640,245 +824,529 @@ array_binval(
 }
 
 
-static int
-array_strvalue(
-        PoqueResult *result, PyObject *lst, char *data, char *end, int escaped,
-        PoqueValueHandler *el_handler) {
-
-    // converts an array item value into the proper Python object
+/* Text arrays are parsed in a single pass. The values are collected in a flat
+ * list while the dimensions are verified, the nested lists are built
+ * afterwards from the shape. Escaped values are unescaped in a scratch buffer
+ * that is allocated once for the array.
+ */
 
-    PyObject *val;
+typedef struct {
+    PoqueResult *result;
+    PoqueValueHandler *el_handler;
+    char *scratch;          /* buffer for unescaped values */
+    Py_ssize_t scratch_size;
+    PyObject **items;       /* the values */
+    Py_ssize_t nitems;
+    Py_ssize_t alloc;
+} ArrayStrParser;
 
-    if (escaped) {
-        // unescape value in new buffer
-        char *data_pos = data, *copy_pos;
 
-        // allocate buffer for unescaped value
-        data = PyMem_Malloc(end - data);
-        if (data == NULL) {
-            PyErr_SetNone(PyExc_MemoryError);
-            return -1;
+static PyObject *
+array_str_element(ArrayStrParser *parser, char *data, Py_ssize_t len)
+{
+    /* converts an array item value into the proper Python object
+     *
+     * The GIL free native readers, when available, are cheap to call and
+     * recognize the common cases.
+     */
+    PoqueValueHandler *el_handler = parser->el_handler;
+    pq_native native = el_handler->natives[FORMAT_TEXT];
+
+    if (native != NULL) {
+        NativeValue value;
+        PyObject *ret;
+
+        value.kind = NATIVE_NONE;
+        native(data, (int)len, &value);
+        switch (value.kind) {
+        case NATIVE_INT:
+            return PyLong_FromLongLong(value.val.i);
+        case NATIVE_FLOAT:
+            return PyFloat_FromDouble(value.val.d);
+        case NATIVE_BOOL:
+            return PyBool_FromLong((long)value.val.i);
+        case NATIVE_ASCII:
+            ret = PyUnicode_New(len, 127);
+            if (ret != NULL) {
+                memcpy(PyUnicode_1BYTE_DATA(ret), data, len);
+            }
+            return ret;
         }
+    }
+    return el_handler->readers[FORMAT_TEXT](
+        parser->result, data, (int)len, el_handler->el_handler);
+}
 
-        copy_pos = data;
-        while (data_pos < end) {
-            if (data_pos[0] == '\\') {
-                // skip escape char
-                data_pos++;
-            }
 
-            // copy character into unescaped value
-            copy_pos[0] = data_pos[0];
+static int
+array_str_add(ArrayStrParser *parser, PyObject *val)
+{
+    /* adds a value to the flat list, steals the reference */
+    if (val == NULL) {
+        return -1;
+    }
+    if (parser->nitems == parser->alloc) {
+        Py_ssize_t alloc = parser->alloc ? parser->alloc * 2 : 16;
+        PyObject **items;
 
-            copy_pos++;
-            data_pos++;
+        items = PyMem_Realloc(parser->items, alloc * sizeof(PyObject *));
+        if (items == NULL) {
+            Py_DECREF(val);
+            PyErr_NoMemory();
+            return -1;
         }
-        end = copy_pos;
+        parser->items = items;
+        parser->alloc = alloc;
     }
+    parser->items[parser->nitems++] = val;
+    return 0;
+}
+
 
-    // get the array item value
-    val = el_handler->readers[FORMAT_TEXT](
-            result, data, end - data, el_handler->el_handler);
-    if (escaped)
-        PyMem_Free(data);
-    if (val) {
-        return PyList_Append(lst, val);
+static int
+array_str_escaped(
+        ArrayStrParser *parser, char *data, char *end, PyObject **val) {
+    /* unescapes the value into the scratch buffer and converts it */
+    char *dest;
+
+    if (parser->scratch == NULL) {
+        parser->scratch = PyMem_Malloc(parser->scratch_size);
+        if (parser->scratch == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
+    dest = parser->scratch;
+    while (data < end) {
+        if (data[0] == '\\') {
+            // skip escape char
+            data++;
+        }
+        *dest++ = *data++;
     }
-    return -1;
+    *dest = '\0';
+    *val = array_str_element(
+        parser, parser->scratch, dest - parser->scratch);
+    return *val ? 0 : -1;
 }
 
 
 static char *
-array_quoted_item(
-        PoqueResult *result, PyObject *lst, char *data, char *end,
-        PoqueValueHandler *el_handler)
+array_str_item(ArrayStrParser *parser, char *data, char *end, char delim)
 {
-    int escaped = 0;
+    /* parses a quoted or unquoted item, returns the position after it */
+    PyObject *val;
     char *pos;
+    int escaped = 0;
 
-    data++;
-    pos = data;
-    while (pos < end) {
-        if (pos[0] == '\0') {
+    if (data[0] == '"') {
+        for (pos = ++data; pos < end && pos[0] != '"'; pos++) {
+            if (pos[0] == '\\') {
+                escaped = 1;
+                pos++;
+            }
+            else if (pos[0] == '\0') {
+                break;
+            }
+        }
+        if (pos >= end || pos[0] != '"') {
             PyErr_SetString(PoqueError, "Invalid array format");
             return NULL;
         }
-        else if (pos[0] == '\\') {
-            escaped = 1;
-            pos++;
-            if (pos == end) {
-                PyErr_SetString(PoqueError, "Invalid array format");
-                return NULL;
+        end = pos++;
+    }
+    else {
+        for (pos = data; pos < end && pos[0] != delim && pos[0] != '}';
+                pos++) {
+            if (pos[0] == '\\') {
+                escaped = 1;
+                pos++;
+            }
+            else if (pos[0] == '\0') {
+                break;
             }
         }
-        else if (pos[0] == '"') {
-            if (array_strvalue(
-                    result, lst, data, pos, escaped, el_handler) < 0)
+        if (pos >= end || (pos[0] != delim && pos[0] != '}')) {
+            PyErr_SetString(PoqueError, "Invalid array format");
+            return NULL;
+        }
+        end = pos;
+        if (end - data == 4 && memcmp(data, "NULL", 4) == 0) {
+            Py_INCREF(Py_None);
+            return array_str_add(parser, Py_None) == -1 ? NULL : pos;
+        }
+    }
+
+    if (escaped) {
+        if (array_str_escaped(parser, data, end, &val) == -1) {
+            return NULL;
+        }
+    }
+    else {
+        val = array_str_element(parser, data, end - data);
+    }
+    return array_str_add(parser, val) == -1 ? NULL : pos;
+}
+
+
+static PyObject *
+array_str_build(PyObject ***items, int *dims, int ndim)
+{
+    /* builds the nested lists, moving the values from items */
+    PyObject *lst;
+    int i;
+
+    lst = PyList_New(dims[0]);
+    if (lst == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < dims[0]; i++) {
+        PyObject *val;
+
+        if (ndim == 1) {
+            val = **items;
+            **items = NULL;
+            (*items)++;
+        }
+        else {
+            val = array_str_build(items, dims + 1, ndim - 1);
+            if (val == NULL) {
+                Py_DECREF(lst);
                 return NULL;
-            return pos + 1;
+            }
         }
-        pos++;
+        PyList_SET_ITEM(lst, i, val);
     }
-    PyErr_SetString(PoqueError, "Invalid array format");
-    return NULL;
+    return lst;
 }
 
-static char *
-array_str_item(
-        PoqueResult *result, PyObject *lst, char *data, char *end,
-        PoqueValueHandler *el_handler)
+
+PyObject *
+array_strval(
+        PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
 {
-    char *pos = data,
-         kar;
-    int escaped = 0;
+    ArrayStrParser parser = {result, el_handler, NULL, len + 1, NULL, 0, 0};
+    char *pos, *end = data + len, delim = el_handler->delim;
+    int dims[ARRAY_MAXDIM], counts[ARRAY_MAXDIM];
+    int depth = 0, ndim = 0, i;
+    PyObject *ret = NULL, **items;
 
-    while (pos < end) {
-        kar = pos[0];
-        if (kar == '\0') {
-            PyErr_SetString(PoqueError, "Invalid array format");
-            return NULL;
+    // skip the optional dimension decoration
+    pos = memchr(data, '{', len);
+    if (pos == NULL) {
+        PyErr_SetString(PoqueError, "Invalid array format");
+        return NULL;
+    }
+    for (i = 0; i < ARRAY_MAXDIM; i++) {
+        dims[i] = -1;
+    }
+
+    while (1) {
+        if (pos >= end) {
+            goto invalid;
         }
-        else if (kar == '\\') {
-            escaped = 1;
+        if (pos[0] == '{') {
+            // start of (nested) array
+            if (depth == ARRAY_MAXDIM || (ndim && depth >= ndim)) {
+                goto invalid;
+            }
+            counts[depth++] = 0;
             pos++;
-            if (pos == end) {
-                PyErr_SetString(PoqueError, "Invalid array format");
-                return NULL;
+            if (pos < end && pos[0] != '}') {
+                // first item or nested array
+                continue;
             }
         }
-        if (kar == '}' || kar == el_handler->delim) {
-            if (strncmp("NULL", data, 4) == 0) {
-                if (PyList_Append(lst, Py_None) == -1) {
-                    return NULL;
-                }
+        else {
+            // an item
+            if (pos[0] == delim) {
+                goto invalid;
             }
-            else if (array_strvalue(
-                        result, lst, data, pos, escaped, el_handler) < 0) {
-                return NULL;
+            if (ndim == 0) {
+                ndim = depth;
+            }
+            else if (depth != ndim) {
+                goto invalid;
+            }
+            pos = array_str_item(&parser, pos, end, delim);
+            if (pos == NULL) {
+                goto end;
+            }
+            counts[depth - 1]++;
+        }
+
+        // after an item or nested array, close arrays
+        while (pos < end && pos[0] == '}') {
+            if (ndim == 0) {
+                // empty array
+                ndim = depth;
+            }
+            if (dims[depth - 1] == -1) {
+                dims[depth - 1] = counts[depth - 1];
+            }
+            else if (dims[depth - 1] != counts[depth - 1]) {
+                // not rectangular
+                goto invalid;
+            }
+            pos++;
+            if (--depth == 0) {
+                break;
             }
-            return pos;
+            counts[depth - 1]++;
+        }
+        if (depth == 0) {
+            break;
+        }
+
+        // there should be a delimiter followed by the next item
+        if (pos + 1 >= end || pos[0] != delim || pos[1] == '}' ||
+                pos[1] == delim) {
+            goto invalid;
         }
         pos++;
     }
+    if (pos != end) {
+        goto invalid;
+    }
+
+    items = parser.items;
+    ret = array_str_build(&items, dims, ndim);
+    goto end;
+
+invalid:
     PyErr_SetString(PoqueError, "Invalid array format");
-    return NULL;
+end:
+    for (i = 0; i < parser.nitems; i++) {
+        Py_XDECREF(parser.items[i]);
+    }
+    PyMem_Free(parser.items);
+    PyMem_Free(parser.scratch);
+    return ret;
 }
 
 
-static char *
-array_strcontents(
-        PoqueResult *result, PyObject *lst, char *data, char *end,
-        PoqueValueHandler *el_handler)
-{
-    data++;
 
-    while (data < end) {
 
-        // invalid characters
-        if (data[0] == '\0' || data[0] == el_handler->delim) {
-            PyErr_SetString(PoqueError, "Invalid array format");
-            return NULL;
-        }
+/* ==== records ============================================================= */
 
-        // check first character
-        if (data[0] == '{') {
-            // nested array
-            int ok;
-            PyObject *val;
+/* Registered composite types have their own value handlers. The el_handler of
+ * the composite handler points to itself, so the record reader gets access to
+ * the named tuple type.
+ */
+typedef struct {
+    PoqueValueHandler handler;          /* the composite type */
+    PoqueValueHandler array_handler;    /* arrays of the composite type */
+    PyTypeObject *cls;                  /* named tuple type */
+    Py_ssize_t nfields;
+} CompositeHandler;
 
-            // create new list for nested array and append to existing one
-            val = PyList_New(0);
-            if (val == NULL) {
-                return NULL;
-            }
-            ok = PyList_Append(lst, val);
-            Py_DECREF(val);
-            if (ok == -1) {
-                return NULL;
-            }
 
-            // parse nested array using newly created list
-            data = array_strcontents(result, val, data, end, el_handler);
-        }
-        else if (data[0] == '"') {
-            // parse quoted value
-            data = array_quoted_item(result, lst, data, end, el_handler);
-        }
-        else if (data[0] != '}') {
-            // parse unquoted value
-            data = array_str_item(result, lst, data, end, el_handler);
-        }
+PyObject *
+record_binval(
+        PoqueResult *result, char *data, int len,
+        PoqueValueHandler *el_handler)
+{
+    /* Reads a composite or anonymous record value as a tuple. Each field
+     * carries its own type oid, the field values are read by the value
+     * handler of that type.
+     */
+    CompositeHandler *composite = (CompositeHandler *)el_handler;
+    PoqueValueHandler *handler;
+    PY_INT32_T nfields, item_len, i;
+    PyObject *record, *val;
+    Oid oid;
+
+    CHECK_LENGTH_LT(len, 4, "record", NULL);
+    nfields = read_int32(data);
+    ADVANCE_DATA(data, len, 4);
+    if (nfields < 0) {
+        PyErr_SetString(PoqueError, "Negative number of fields");
+        return NULL;
+    }
 
-        if (data == NULL) {
-            // something went wrong parsing
+    if (composite != NULL) {
+        if (nfields != composite->nfields) {
+            PyErr_SetString(
+                PoqueError, "Number of fields does not match composite type");
             return NULL;
         }
+        /* a named tuple is a tuple subtype without additional members */
+        record = composite->cls->tp_alloc(composite->cls, nfields);
+    }
+    else {
+        record = PyTuple_New(nfields);
+    }
+    if (record == NULL) {
+        return NULL;
+    }
 
-        if (data == end) {
-            PyErr_SetString(PoqueError, "Invalid array format");
-            return NULL;
+    for (i = 0; i < nfields; i++) {
+        if (len < 8) {
+            goto invalid;
         }
+        oid = read_uint32(data);
+        item_len = read_int32(data + 4);
+        ADVANCE_DATA(data, len, 8);
 
-        if (data[0] == '}') {
-            // done
-            return data + 1;
+        /* -1 indicates NULL value */
+        if (item_len == -1) {
+            Py_INCREF(Py_None);
+            PyTuple_SET_ITEM(record, i, Py_None);
+            continue;
         }
-
-        if (data[0] == el_handler->delim) {
-            // delimiter found, position after delimiter
-            data++;
-            if (data == end) {
-                PyErr_SetString(PoqueError, "Invalid array format");
-                return NULL;
-            }
-            if (data[0] == '}') {
-                // should not happen after a delimiter (mostly comma)
-                PyErr_SetString(PoqueError, "Invalid array format");
-                return NULL;
-            }
+        if (item_len < 0 || len < item_len) {
+            goto invalid;
         }
-        else {
-            // character should have been a '}' or delimiter
-            PyErr_SetString(PoqueError, "Invalid array format");
+        handler = find_value_handler(result->type_handlers, oid);
+        val = handler->readers[FORMAT_BINARY](
+                result, data, item_len, handler->el_handler);
+        if (val == NULL) {
+            Py_DECREF(record);
             return NULL;
         }
+        PyTuple_SET_ITEM(record, i, val);
+        ADVANCE_DATA(data, len, item_len);
     }
-    PyErr_SetString(PoqueError, "Invalid array format");
+    if (len != 0) {
+        goto invalid;
+    }
+    return record;
+
+invalid:
+    Py_DECREF(record);
+    PyErr_SetString(PoqueError, "Invalid data for record type.");
     return NULL;
 }
 
 
-PyObject *
-array_strval(
-        PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
+static void
+composite_capsule_free(PyObject *capsule)
 {
-    char *pos;
-    PyObject *lst;
+    CompositeHandler *composite;
 
-    pos = memchr(data, '{', len);
-    if (pos == NULL) {
-        PyErr_SetString(PoqueError, "Invalid array format");
-        return NULL;
+    composite = PyCapsule_GetPointer(capsule, NULL);
+    Py_DECREF(composite->cls);
+    PyMem_Free(composite);
+}
+
+
+static void
+context_capsule_free(PyObject *capsule)
+{
+    /* releases the owner of the handler */
+    Py_XDECREF(PyCapsule_GetContext(capsule));
+}
+
+
+static int
+set_type_handler(
+        PyObject *type_handlers, Oid oid, PoqueValueHandler *handler,
+        PyObject *owner)
+{
+    /* Adds the handler to the registered types. The owner is kept alive as
+     * long as the handler is registered.
+     */
+    PyObject *key, *capsule;
+    int ret;
+
+    capsule = PyCapsule_New(handler, NULL, context_capsule_free);
+    if (capsule == NULL) {
+        return -1;
     }
-    lst = PyList_New(0);
-    if (lst == NULL) {
+    if (PyCapsule_SetContext(capsule, owner) == -1) {
+        Py_DECREF(capsule);
+        return -1;
+    }
+    Py_XINCREF(owner);
+    key = PyLong_FromUnsignedLong(oid);
+    if (key == NULL) {
+        Py_DECREF(capsule);
+        return -1;
+    }
+    ret = PyDict_SetItem(type_handlers, key, capsule);
+    Py_DECREF(key);
+    Py_DECREF(capsule);
+    return ret;
+}
+
+
+static PyObject *
+copy_type_handlers(
+        PyObject *type_handlers, Oid oid, PoqueValueHandler *handler,
+        Oid array_oid, PoqueValueHandler *array_handler, PyObject *owner)
+{
+    /* Returns a copy of the registered types with the handlers added. The
+     * registered types of a connection are replaced instead of changed,
+     * because results keep using the handlers of the moment they were
+     * created.
+     */
+    PyObject *ret;
+
+    ret = type_handlers ? PyDict_Copy(type_handlers) : PyDict_New();
+    if (ret == NULL ||
+            set_type_handler(ret, oid, handler, owner) == -1 ||
+            (array_oid != InvalidOid && set_type_handler(
+                ret, array_oid, array_handler, owner) == -1)) {
+        Py_XDECREF(ret);
         return NULL;
     }
+    return ret;
+}
 
-    pos = array_strcontents(result, lst, pos, data + len, el_handler);
-    if (pos != data + len) {
-        // if pos is NULL an error has been set by the array parser
-        if (pos != NULL) {
-            // not at end of string
-            PyErr_SetString(PoqueError, "Invalid array format");
-        }
-        Py_DECREF(lst);
+
+PyObject *
+add_composite_type(
+        PyObject *type_handlers, Oid oid, Oid array_oid, PyTypeObject *cls,
+        Py_ssize_t nfields)
+{
+    /* Returns a copy of the registered types, with the handlers for the
+     * composite type and its array type added.
+     */
+    CompositeHandler *composite;
+    PyObject *owner, *ret;
+
+    composite = PyMem_Calloc(1, sizeof(CompositeHandler));
+    if (composite == NULL) {
+        return PyErr_NoMemory();
+    }
+    composite->handler.readers[FORMAT_TEXT] = text_val;
+    composite->handler.readers[FORMAT_BINARY] = record_binval;
+    composite->handler.delim = ',';
+    composite->handler.el_handler = &composite->handler;
+    composite->array_handler.readers[FORMAT_TEXT] = array_strval;
+    composite->array_handler.readers[FORMAT_BINARY] = array_binval;
+    composite->array_handler.delim = ',';
+    composite->array_handler.el_handler = &composite->handler;
+    Py_INCREF(cls);
+    composite->cls = cls;
+    composite->nfields = nfields;
+
+    owner = PyCapsule_New(composite, NULL, composite_capsule_free);
+    if (owner == NULL) {
+        Py_DECREF(cls);
+        PyMem_Free(composite);
         return NULL;
     }
-    return lst;
+
+    ret = copy_type_handlers(
+        type_handlers, oid, &composite->handler, array_oid,
+        &composite->array_handler, owner);
+    Py_DECREF(owner);
+    return ret;
 }
 
 
+PyObject *
+add_type_handlers(
+        PyObject *type_handlers, Oid oid, PoqueValueHandler *handler,
+        Oid array_oid, PoqueValueHandler *array_handler)
+{
+    /* Returns a copy of the registered types, with static handlers for a type
+     * with a dynamic oid and its array type added.
+     */
+    return copy_type_handlers(
+        type_handlers, oid, handler, array_oid, array_handler, NULL);
+}
 
 
 static PyObject *
@@ -962,201 +1430,6 @@ end:
 }
 
 
-static PyObject *json_loads;
-
-static PyObject *
-json_val(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
-{
-    return PyObject_CallFunction(json_loads, "s#", data, len);
-}
-
-
-static PyObject *
-jsonb_bin_val(
-        PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
-{
-    if (data[0] != 1)
-        PyErr_SetString(PoqueError, "Invalid jsonb version");
-    return json_val(result, data + 1, len - 1, NULL);
-}
-
-
-
-
-static PyObject *
-inplace_op(PyObject *(*op)(PyObject *, PyObject *),
-           PyObject *val, PyObject *arg)
-{
-    /* Helper function for in place operations. Steals a reference to val.
-     * Returns a new reference
-     */
-    PyObject *new_val;
-
-    new_val = op(val, arg);
-    Py_DECREF(val);
-    return new_val;
-}
-
-
-static PyObject *
-bit_strval(
-        PoqueResult *result, char *data, int len, PoqueValueHandler *unused) {
-    PyObject *val, *one=NULL;
-    char *end;
-
-    /* initialize return value */
-    val = PyLong_FromLong(0);
-    if (val == NULL) {
-        return NULL;
-    }
-
-    /* initialize Python integer with value 1 */
-    one = PyLong_FromLong(1);
-    if (one == NULL) {
-        Py_DECREF(val);
-        return NULL;
-    }
-
-    /* interpret characters as bits */
-    end = data + len;
-    while (data < end) {
-        char byte;
-
-        /* new bit, shift the return value one bit to make space */
-        val = inplace_op(PyNumber_InPlaceLshift, val, one);
-        if (val == NULL) {
-            goto error;
-        }
-
-        byte = *data;
-
-        /* interpret bit */
-        if (byte == '1') {
-            /* add the bit to the return value */
-            val = inplace_op(PyNumber_InPlaceOr, val, one);
-            if (val == NULL) {
-                goto error;
-            }
-        }
-        else if (byte != '0') {
-            PyErr_SetString(PoqueError, "Invalid character in bit string");
-            goto error;
-        }
-        data++;
-    }
-    Py_DECREF(one);
-    return val;
-
-error:
-    Py_DECREF(one);
-    Py_XDECREF(val);
-    return NULL;
-}
-
-
-static PyObject *
-bit_binval(
-        PoqueResult *result, char *data, int len, PoqueValueHandler *unused) {
-    /* Reads a bitstring as a Python integer
-
-    Format:
-       * signed int: number of bits (bit_len)
-       * bytes: All the bits left aligned
-
-    */
-    int bit_len, quot, rest, byte_len;
-    char *end;
-    PyObject *val, *eight;
-
-    /* first get the number of bits in the bit string */
-    if (len < 4) {
-        PyErr_SetString(PoqueError,
-                        "Invalid binary bit string");
-        return NULL;
-    }
-    bit_len = read_int32((unsigned char *)data);
-    if (bit_len < 0) {
-        PyErr_SetString(PoqueError,
-                        "Invalid length value in binary bit string");
-        return NULL;
-    }
-
-    quot = bit_len / 8;  /* number of bytes completely filled */
-    rest = bit_len % 8;  /* number of bits in remaining byte */
-    byte_len = quot + (rest > 0); /* total number of data bytes */
-    if (len != byte_len + 4) {
-        PyErr_SetString(PoqueError,
-                        "Invalid binary bit string");
-        return NULL;
-    }
-
-    /* initialize return value */
-    val = PyLong_FromLong(0);
-    if (val == NULL)
-        return NULL;
-
-    /* initialize Python integer with value 8 */
-    eight = PyLong_FromLong(8);
-    if (eight == NULL) {
-        Py_DECREF(val);
-        return NULL;
-    }
-
-    /* add the value byte by byte, python ints have no upper limit, so this
-     * works even for bitstrings longer than 64 bits */
-    end = data + len;
-    for (data += 4; data < end; data++) {
-        unsigned char byte;
-        PyObject *byte_val;
-
-        /* new byte, first shift the return value one byte to the left, to make
-         * space */
-        val = inplace_op(PyNumber_InPlaceLshift, val, eight);
-        if (val == NULL) {
-            goto error;
-        }
-
-        /* read the new byte */
-        byte = (unsigned char)*data;
-        byte_val = PyLong_FromLong(byte);
-        if (byte_val == NULL) {
-            goto error;
-        }
-
-        /* add the new byte to the return value */
-        val = inplace_op(PyNumber_InPlaceOr, val, byte_val);
-        Py_DECREF(byte_val);
-        if (val == NULL) {
-            goto error;
-        }
-    }
-    if (rest) {
-        /* correct for the fact that the pg bitstring is left aligned */
-        PyObject *shift_val;
-
-        /* get the number of bits to shift the entire value */
-        shift_val = PyLong_FromLong(8 - rest);
-        if (shift_val == NULL) {
-            goto error;
-        }
-
-        /* shift the value */
-        val = inplace_op(PyNumber_InPlaceRshift, val, shift_val);
-        Py_DECREF(shift_val);
-        if (val == NULL) {
-            goto error;
-        }
-    }
-    Py_DECREF(eight);
-    return val;
-
-error:
-    Py_DECREF(eight);
-    Py_XDECREF(val);
-    return NULL;
-}
-
-
 static PyObject *
 vector_strval(
         PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler)
@@ -1199,9 +1472,6 @@ PoqueValueHandler int2vector_val_handler = {
 PoqueValueHandler tid_val_handler = {{tid_strval, tid_binval}, ',', NULL};
 PoqueValueHandler oidvector_val_handler = {
         {vector_strval, array_binval}, ',', &id_val_handler};
-PoqueValueHandler json_val_handler = {{json_val, json_val}, ',', NULL};
-PoqueValueHandler jsonb_val_handler = {{json_val, jsonb_bin_val}, ',', NULL};
-PoqueValueHandler bit_val_handler = {{bit_strval, bit_binval}, ',', NULL};
 
 PoqueValueHandler int2vectorarray_val_handler = {
         {array_strval, array_binval}, ',', &int2vector_val_handler};
@@ -1209,12 +1479,10 @@ PoqueValueHandler tidarray_val_handler = {
         {array_strval, array_binval}, ',', &tid_val_handler};
 PoqueValueHandler oidvectorarray_val_handler = {
         {array_strval, array_binval}, ',', &oidvector_val_handler};
-PoqueValueHandler jsonarray_val_handler = {
-        {array_strval, array_binval}, ',', &json_val_handler};
-PoqueValueHandler jsonbarray_val_handler = {
-        {array_strval, array_binval}, ',', &jsonb_val_handler};
-PoqueValueHandler bitarray_val_handler = {
-        {array_strval, array_binval}, ',', &bit_val_handler};
+PoqueValueHandler record_val_handler = {
+        {text_val, record_binval}, ',', NULL};
+PoqueValueHandler recordarray_val_handler = {
+        {array_strval, array_binval}, ',', &record_val_handler};
 
 
 int
@@ -1235,22 +1503,43 @@ init_type_map(void) {
     if (init_network() < 0) {
         return -1;
     }
+    if (init_json() < 0) {
+        return -1;
+    }
+    if (init_bitstring() < 0) {
+        return -1;
+    }
+    if (init_buffer() < 0) {
+        return -1;
+    }
+    if (init_encoded() < 0) {
+        return -1;
+    }
+    if (init_geometric() < 0) {
+        return -1;
+    }
+    if (init_range() < 0) {
+        return -1;
+    }
 
     register_parameter_handler(&PyList_Type, new_array_param_handler);
 
-    json_loads = load_python_object("json", "loads");
-    if (json_loads == NULL)
+    if (registration_overflow) {
+        PyErr_SetString(PyExc_RuntimeError,
+                        "Too many parameter handlers registered");
         return -1;
-
+    }
     return 0;
 }
 
 
-PoqueValueHandler *
-get_value_handler(Oid oid)
-{
-    static PoqueValueHandler fallback = {{text_val, bytea_binval}, ',', NULL};
+static PoqueValueHandler fallback_val_handler = {
+        {text_val, bytea_binval}, ',', NULL};
+
 
+static PoqueValueHandler *
+builtin_value_handler(Oid oid)
+{
     switch(oid) {
 
     // numeric
@@ -1335,6 +1624,8 @@ get_value_handler(Oid oid)
         return &json_val_handler;
     case JSONBOID:
         return &jsonb_val_handler;
+    case RECORDOID:
+        return &record_val_handler;
     case BITOID:
     case VARBITOID:
         return &bit_val_handler;
@@ -1437,6 +1728,8 @@ get_value_handler(Oid oid)
         return &jsonarray_val_handler;
     case JSONBARRAYOID:
         return &jsonbarray_val_handler;
+    case RECORDARRAYOID:
+        return &recordarray_val_handler;
     case BITARRAYOID:
     case VARBITARRAYOID:
         return &bitarray_val_handler;
@@ -1457,7 +1750,104 @@ get_value_handler(Oid oid)
     case CIRCLEARRAYOID:
         return &circlearray_val_handler;
 
+    // range
+    case INT4RANGEOID:
+        return &int4range_val_handler;
+    case INT8RANGEOID:
+        return &int8range_val_handler;
+    case NUMRANGEOID:
+        return &numrange_val_handler;
+    case TSRANGEOID:
+        return &tsrange_val_handler;
+    case TSTZRANGEOID:
+        return &tstzrange_val_handler;
+    case DATERANGEOID:
+        return &daterange_val_handler;
+
+    // multirange
+    case INT4MULTIRANGEOID:
+        return &int4multirange_val_handler;
+    case INT8MULTIRANGEOID:
+        return &int8multirange_val_handler;
+    case NUMMULTIRANGEOID:
+        return &nummultirange_val_handler;
+    case TSMULTIRANGEOID:
+        return &tsmultirange_val_handler;
+    case TSTZMULTIRANGEOID:
+        return &tstzmultirange_val_handler;
+    case DATEMULTIRANGEOID:
+        return &datemultirange_val_handler;
+
+    // range array
+    case INT4RANGEARRAYOID:
+        return &int4rangearray_val_handler;
+    case INT8RANGEARRAYOID:
+        return &int8rangearray_val_handler;
+    case NUMRANGEARRAYOID:
+        return &numrangearray_val_handler;
+    case TSRANGEARRAYOID:
+        return &tsrangearray_val_handler;
+    case TSTZRANGEARRAYOID:
+        return &tstzrangearray_val_handler;
+    case DATERANGEARRAYOID:
+        return &daterangearray_val_handler;
+
+    // multirange array
+    case INT4MULTIRANGEARRAYOID:
+        return &int4multirangearray_val_handler;
+    case INT8MULTIRANGEARRAYOID:
+        return &int8multirangearray_val_handler;
+    case NUMMULTIRANGEARRAYOID:
+        return &nummultirangearray_val_handler;
+    case TSMULTIRANGEARRAYOID:
+        return &tsmultirangearray_val_handler;
+    case TSTZMULTIRANGEARRAYOID:
+        return &tstzmultirangearray_val_handler;
+    case DATEMULTIRANGEARRAYOID:
+        return &datemultirangearray_val_handler;
+
     default:
-        return &fallback;
+        return NULL;
+    }
+}
+
+
+PoqueValueHandler *
+get_value_handler(Oid oid)
+{
+    PoqueValueHandler *handler;
+
+    handler = builtin_value_handler(oid);
+    return handler ? handler : &fallback_val_handler;
+}
+
+
+PoqueValueHandler *
+find_value_handler(PyObject *type_handlers, Oid oid)
+{
+    /* Gets the value handler of a built-in type or else of a type registered
+     * on the connection. The registered types map oids to capsules of
+     * handlers.
+     */
+    PoqueValueHandler *handler;
+    PyObject *key, *capsule;
+
+    handler = builtin_value_handler(oid);
+    if (handler != NULL) {
+        return handler;
+    }
+    if (type_handlers != NULL) {
+        key = PyLong_FromUnsignedLong(oid);
+        if (key == NULL) {
+            /* no way to report, unknown types are fine */
+            PyErr_Clear();
+            return &fallback_val_handler;
+        }
+        capsule = PyDict_GetItem(type_handlers, key);
+        Py_DECREF(key);
+        if (capsule != NULL) {
+            return PyCapsule_GetPointer(capsule, NULL);
+        }
     }
+    return &fallback_val_handler;
 }
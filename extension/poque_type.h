@@ -9,15 +9,30 @@ typedef struct _poqueValueHandler {
     pq_read readers[2];
     char delim;        /* delimeter for arrays of this type */
     struct _poqueValueHandler *el_handler;
+    pq_native natives[2];   /* optional GIL free readers */
+    char memoize;           /* binary values are immutable and fixed width,
+                               results can be cached per column */
 } PoqueValueHandler;
 
 PoqueValueHandler *get_value_handler(Oid oid);
+PoqueValueHandler *find_value_handler(PyObject *type_handlers, Oid oid);
+
+/* maximum number of array dimensions, same as PostgreSQL */
+#define ARRAY_MAXDIM 6
 
 PyObject *array_binval(
     PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler);
 PyObject *array_strval(
     PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler);
+PyObject *record_binval(
+    PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler);
 PyObject *Result_getview(PoqueResult *self, char *data, int len);
+PyObject *add_composite_type(
+    PyObject *type_handlers, Oid oid, Oid array_oid, PyTypeObject *cls,
+    Py_ssize_t nfields);
+PyObject *add_type_handlers(
+    PyObject *type_handlers, Oid oid, PoqueValueHandler *handler,
+    Oid array_oid, PoqueValueHandler *array_handler);
 
 
 typedef struct _param_handler param_handler;
@@ -55,14 +70,76 @@ typedef struct _param_handler {
 #define current_encode_param(h) current_param((h), (&(h)->encode_pos))
 
 ph_new get_param_handler_constructor(PyTypeObject *typ);
+param_handler *_Conn_param_handler(PoqueConn *self, PyObject *param);
 param_handler *new_param_handler(param_handler *def_handler, size_t handler_size);
+param_handler *new_cache_param_handler(param_handler *def_handler,
+                                       size_t def_size, int num_params,
+                                       size_t param_size);
 param_handler *new_object_param_handler(int num_params);
+param_handler *new_hstore_array_param_handler(
+    Oid hstore_oid, Oid hstore_array_oid);
+
+/* Unlike write_uint32 and friends these inline into loops, where the
+ * compiler turns them into a single byte swapping store.
+ */
+static inline void
+put_uint16(char *p, poque_uint16 val)
+{
+    unsigned char *q = (unsigned char *)p;
+
+    q[0] = (unsigned char)(val >> 8);
+    q[1] = (unsigned char)val;
+}
+
+
+static inline void
+put_uint32(char *p, PY_UINT32_T val)
+{
+    unsigned char *q = (unsigned char *)p;
+
+    q[0] = (unsigned char)(val >> 24);
+    q[1] = (unsigned char)(val >> 16);
+    q[2] = (unsigned char)(val >> 8);
+    q[3] = (unsigned char)val;
+}
+
+
+static inline void
+put_uint64(char *p, PY_UINT64_T val)
+{
+    put_uint32(p, (PY_UINT32_T)(val >> 32));
+    put_uint32(p + 4, (PY_UINT32_T)val);
+}
 
 void write_uint16(char **p, poque_uint16 val);
 void write_uint32(char **p, PY_UINT32_T val);
 void write_uint64(char **p, PY_UINT64_T val);
 
 void register_parameter_handler(PyTypeObject *typ, ph_new constructor);
+
+
+/* List encoders are a fast path for the array parameter handler. They encode
+ * a flat list of items of a single exact Python type, and None values, in a
+ * tight loop instead of calling a parameter handler for every item.
+ *
+ * * examine: checks the items and sets the element type. Returns the total
+ *            size of the non None items, -1 on error or -2 if an item is of
+ *            another type and the generic path should be used.
+ * * write:   writes the items, each preceded by its length, -1 on error.
+ */
+typedef struct {
+    Oid oid;                /* element type */
+    Oid array_oid;          /* array type */
+    Py_ssize_t num_null;    /* number of None values */
+} list_encoding;
+
+typedef Py_ssize_t (*le_examine)(
+    PyObject **items, Py_ssize_t n, list_encoding *enc);
+typedef int (*le_write)(
+    PyObject **items, Py_ssize_t n, list_encoding *enc, char *loc);
+
+void register_list_encoder(
+    PyTypeObject *typ, le_examine examine, le_write write);
 void register_compatible_param(PyTypeObject *typ1, PyTypeObject *typ2);
 
 #endif
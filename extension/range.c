@@ -0,0 +1,752 @@
+#include "range.h"
+#include "numeric.h"
+#include "datetime.h"
+
+
+/* ==== Range =============================================================== */
+
+/* flags of the binary format */
+#define RANGE_EMPTY     0x01
+#define RANGE_LB_INC    0x02
+#define RANGE_UB_INC    0x04
+#define RANGE_LB_INF    0x08
+#define RANGE_UB_INF    0x10
+#define RANGE_FLAGS     0x1F
+
+typedef struct {
+    PyObject_HEAD
+    PyObject *lower;    /* None when unbounded */
+    PyObject *upper;    /* None when unbounded */
+    char flags;         /* RANGE_* flags */
+} PoqueRange;
+
+
+static PyObject *
+Range_create(PyTypeObject *type, PyObject *lower, PyObject *upper, int flags)
+{
+    /* Creates a range. Steals the references to the bounds, which are None
+     * when NULL. Infinite bounds are never inclusive, like in PostgreSQL.
+     */
+    PoqueRange *self;
+
+    self = (PoqueRange *)type->tp_alloc(type, 0);
+    if (self == NULL) {
+        Py_XDECREF(lower);
+        Py_XDECREF(upper);
+        return NULL;
+    }
+    if (lower == NULL || lower == Py_None) {
+        flags = (flags | RANGE_LB_INF) & ~RANGE_LB_INC;
+    }
+    if (upper == NULL || upper == Py_None) {
+        flags = (flags | RANGE_UB_INF) & ~RANGE_UB_INC;
+    }
+    if (flags & RANGE_EMPTY) {
+        flags = RANGE_EMPTY;
+    }
+    if (lower == NULL) {
+        Py_INCREF(Py_None);
+        lower = Py_None;
+    }
+    if (upper == NULL) {
+        Py_INCREF(Py_None);
+        upper = Py_None;
+    }
+    self->lower = lower;
+    self->upper = upper;
+    self->flags = (char)flags;
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+Range_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"lower", "upper", "bounds", "empty", NULL};
+    PyObject *lower = Py_None, *upper = Py_None;
+    const char *bounds = "[)";
+    int empty = 0, flags = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "|OOsp", kwlist, &lower, &upper, &bounds, &empty)) {
+        return NULL;
+    }
+    if (empty) {
+        return Range_create(type, NULL, NULL, RANGE_EMPTY);
+    }
+    if (strlen(bounds) != 2 || (bounds[0] != '[' && bounds[0] != '(') ||
+            (bounds[1] != ']' && bounds[1] != ')')) {
+        PyErr_SetString(PyExc_ValueError, "Invalid bounds");
+        return NULL;
+    }
+    if (bounds[0] == '[') {
+        flags |= RANGE_LB_INC;
+    }
+    if (bounds[1] == ']') {
+        flags |= RANGE_UB_INC;
+    }
+    Py_INCREF(lower);
+    Py_INCREF(upper);
+    return Range_create(type, lower, upper, flags);
+}
+
+
+static PyObject *
+Range_repr(PoqueRange *self)
+{
+    if (self->flags & RANGE_EMPTY) {
+        return PyUnicode_FromString("Range(empty=True)");
+    }
+    return PyUnicode_FromFormat(
+        "Range(%R, %R, '%c%c')", self->lower, self->upper,
+        (self->flags & RANGE_LB_INC) ? '[' : '(',
+        (self->flags & RANGE_UB_INC) ? ']' : ')');
+}
+
+
+static PyObject *
+Range_richcompare(PoqueRange *self, PyObject *other, int op)
+{
+    PoqueRange *o;
+    int eq;
+
+    if (!PyObject_TypeCheck(other, &PoqueRangeType) ||
+            (op != Py_EQ && op != Py_NE)) {
+        Py_RETURN_NOTIMPLEMENTED;
+    }
+    o = (PoqueRange *)other;
+    eq = self->flags == o->flags;
+    if (eq) {
+        eq = PyObject_RichCompareBool(self->lower, o->lower, Py_EQ);
+    }
+    if (eq == 1) {
+        eq = PyObject_RichCompareBool(self->upper, o->upper, Py_EQ);
+    }
+    if (eq == -1) {
+        return NULL;
+    }
+    return PyBool_FromLong(op == Py_EQ ? eq : !eq);
+}
+
+
+static Py_hash_t
+Range_hash(PoqueRange *self)
+{
+    PyObject *key;
+    Py_hash_t ret;
+
+    key = Py_BuildValue("(OOi)", self->lower, self->upper, self->flags);
+    if (key == NULL) {
+        return -1;
+    }
+    ret = PyObject_Hash(key);
+    Py_DECREF(key);
+    return ret;
+}
+
+
+static int
+Range_bool(PoqueRange *self)
+{
+    return !(self->flags & RANGE_EMPTY);
+}
+
+
+static PyObject *
+Range_get_flag(PoqueRange *self, void *flag)
+{
+    return PyBool_FromLong(self->flags & (int)(Py_intptr_t)flag);
+}
+
+
+static int
+Range_traverse(PoqueRange *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->lower);
+    Py_VISIT(self->upper);
+    return 0;
+}
+
+
+static int
+Range_clear(PoqueRange *self)
+{
+    Py_CLEAR(self->lower);
+    Py_CLEAR(self->upper);
+    return 0;
+}
+
+
+static void
+Range_dealloc(PoqueRange *self)
+{
+    PyObject_GC_UnTrack(self);
+    Range_clear(self);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+
+static PyNumberMethods Range_as_number = {
+    .nb_bool = (inquiry)Range_bool,
+};
+
+
+static PyMemberDef Range_members[] = {
+    {"lower", T_OBJECT, offsetof(PoqueRange, lower), READONLY,
+     "lower bound, None if unbounded"},
+    {"upper", T_OBJECT, offsetof(PoqueRange, upper), READONLY,
+     "upper bound, None if unbounded"},
+    {NULL}
+};
+
+
+static PyGetSetDef Range_getset[] = {{
+        "lower_inc", (getter)Range_get_flag, NULL,
+        "whether the lower bound is included", (void *)RANGE_LB_INC
+    }, {
+        "upper_inc", (getter)Range_get_flag, NULL,
+        "whether the upper bound is included", (void *)RANGE_UB_INC
+    }, {
+        "lower_inf", (getter)Range_get_flag, NULL,
+        "whether the range is unbounded below", (void *)RANGE_LB_INF
+    }, {
+        "upper_inf", (getter)Range_get_flag, NULL,
+        "whether the range is unbounded above", (void *)RANGE_UB_INF
+    }, {
+        "isempty", (getter)Range_get_flag, NULL,
+        "whether the range is empty", (void *)RANGE_EMPTY
+    }, {
+        NULL
+    }
+};
+
+
+PyTypeObject PoqueRangeType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.Range",                              /* tp_name */
+    sizeof(PoqueRange),                         /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)Range_dealloc,                  /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)Range_repr,                       /* tp_repr */
+    &Range_as_number,                           /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    (hashfunc)Range_hash,                       /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "Range with its bounds and their inclusivity", /* tp_doc */
+    (traverseproc)Range_traverse,               /* tp_traverse */
+    (inquiry)Range_clear,                       /* tp_clear */
+    (richcmpfunc)Range_richcompare,             /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    Range_members,                              /* tp_members */
+    Range_getset,                               /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    Range_new,                                  /* tp_new */
+};
+
+
+/* ==== range values ======================================================== */
+
+static PyObject *
+range_bound_binval(
+        PoqueResult *result, char **data, int *len,
+        PoqueValueHandler *el_handler)
+{
+    /* reads a length prefixed bound with the reader of the element type */
+    PY_INT32_T bound_len;
+    PyObject *val;
+
+    CHECK_LENGTH_LT(*len, 4, "range", NULL);
+    bound_len = read_int32(*data);
+    ADVANCE_DATA(*data, *len, 4);
+    if (bound_len < 0 || bound_len > *len) {
+        PyErr_SetString(PoqueError, "Invalid data for range type.");
+        return NULL;
+    }
+    val = el_handler->readers[FORMAT_BINARY](
+        result, *data, bound_len, el_handler->el_handler);
+    ADVANCE_DATA(*data, *len, bound_len);
+    return val;
+}
+
+
+static PyObject *
+range_binval(PoqueResult *result, char *data, int len,
+             PoqueValueHandler *el_handler)
+{
+    /* Reads the flags byte followed by the finite bounds */
+    PyObject *lower = NULL, *upper = NULL;
+    int flags;
+
+    CHECK_LENGTH_LT(len, 1, "range", NULL);
+    flags = (unsigned char)data[0];
+    ADVANCE_DATA(data, len, 1);
+    if (flags & ~RANGE_FLAGS) {
+        PyErr_SetString(PoqueError, "Invalid range flags");
+        return NULL;
+    }
+    if (!(flags & RANGE_EMPTY)) {
+        if (!(flags & RANGE_LB_INF)) {
+            lower = range_bound_binval(result, &data, &len, el_handler);
+            if (lower == NULL) {
+                return NULL;
+            }
+        }
+        if (!(flags & RANGE_UB_INF)) {
+            upper = range_bound_binval(result, &data, &len, el_handler);
+            if (upper == NULL) {
+                Py_XDECREF(lower);
+                return NULL;
+            }
+        }
+    }
+    if (len != 0) {
+        Py_XDECREF(lower);
+        Py_XDECREF(upper);
+        PyErr_SetString(PoqueError, "Invalid data for range type.");
+        return NULL;
+    }
+    return Range_create(&PoqueRangeType, lower, upper, flags);
+}
+
+
+static char *
+range_str_bound(char *p, char *end, char *buf, int *size)
+{
+    /* Unquotes a bound into buf, up to an unquoted comma or the end. The size
+     * is -1 for a missing bound. Returns the position after the bound or NULL
+     * for an unterminated quote.
+     */
+    int n = 0, quoted = 0, found = 0;
+
+    while (p < end) {
+        if (*p == '"') {
+            found = 1;
+            if (quoted && p + 1 < end && p[1] == '"') {
+                buf[n++] = '"';
+                p += 2;
+                continue;
+            }
+            quoted = !quoted;
+            p++;
+            continue;
+        }
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+        }
+        else if (*p == ',' && !quoted) {
+            break;
+        }
+        buf[n++] = *p++;
+        found = 1;
+    }
+    buf[n] = '\0';
+    *size = found ? n : -1;
+    return quoted ? NULL : p;
+}
+
+
+static PyObject *
+range_strval(PoqueResult *result, char *data, int len,
+             PoqueValueHandler *el_handler)
+{
+    /* Parses "empty" or the bounds between brackets or parentheses */
+    PyObject *bounds[2] = {NULL, NULL};
+    char *p, *end, *buf;
+    int flags = 0, size, i;
+
+    if (len == 5 && memcmp(data, "empty", 5) == 0) {
+        return Range_create(&PoqueRangeType, NULL, NULL, RANGE_EMPTY);
+    }
+    if (len < 3 || (data[0] != '[' && data[0] != '(') ||
+            (data[len - 1] != ']' && data[len - 1] != ')')) {
+        PyErr_SetString(PoqueError, "Invalid range value");
+        return NULL;
+    }
+    if (data[0] == '[') {
+        flags |= RANGE_LB_INC;
+    }
+    if (data[len - 1] == ']') {
+        flags |= RANGE_UB_INC;
+    }
+
+    buf = PyMem_Malloc(len);
+    if (buf == NULL) {
+        return PyErr_NoMemory();
+    }
+    p = data + 1;
+    end = data + len - 1;
+    for (i = 0; i < 2; i++) {
+        p = range_str_bound(p, end, buf, &size);
+        if (p == NULL || (i == 0 ? p == end : p != end)) {
+            PyErr_SetString(PoqueError, "Invalid range value");
+            goto error;
+        }
+        p++;    /* skip the comma */
+        if (size != -1) {
+            bounds[i] = el_handler->readers[FORMAT_TEXT](
+                result, buf, size, el_handler->el_handler);
+            if (bounds[i] == NULL) {
+                goto error;
+            }
+        }
+    }
+    PyMem_Free(buf);
+    return Range_create(&PoqueRangeType, bounds[0], bounds[1], flags);
+
+error:
+    PyMem_Free(buf);
+    Py_XDECREF(bounds[0]);
+    return NULL;
+}
+
+
+static PyObject *
+multirange_binval(PoqueResult *result, char *data, int len,
+                  PoqueValueHandler *el_handler)
+{
+    /* Reads the number of ranges and the length prefixed ranges as a list */
+    PY_INT32_T num_ranges, range_len, i;
+    PyObject *ranges, *range;
+
+    CHECK_LENGTH_LT(len, 4, "multirange", NULL);
+    num_ranges = read_int32(data);
+    ADVANCE_DATA(data, len, 4);
+    if (num_ranges < 0 || num_ranges > len / 5) {
+        PyErr_SetString(PoqueError, "Invalid data for multirange type.");
+        return NULL;
+    }
+    ranges = PyList_New(num_ranges);
+    if (ranges == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < num_ranges; i++) {
+        if (len < 4 || (range_len = read_int32(data)) < 0 ||
+                range_len > len - 4) {
+            Py_DECREF(ranges);
+            PyErr_SetString(PoqueError, "Invalid data for multirange type.");
+            return NULL;
+        }
+        ADVANCE_DATA(data, len, 4);
+        range = el_handler->readers[FORMAT_BINARY](
+            result, data, range_len, el_handler->el_handler);
+        if (range == NULL) {
+            Py_DECREF(ranges);
+            return NULL;
+        }
+        PyList_SET_ITEM(ranges, i, range);
+        ADVANCE_DATA(data, len, range_len);
+    }
+    if (len != 0) {
+        Py_DECREF(ranges);
+        PyErr_SetString(PoqueError, "Invalid data for multirange type.");
+        return NULL;
+    }
+    return ranges;
+}
+
+
+static PyObject *
+multirange_strval(PoqueResult *result, char *data, int len,
+                  PoqueValueHandler *el_handler)
+{
+    /* Splits the ranges between the braces and parses them one by one */
+    PyObject *ranges, *range;
+    char *p, *start, *end;
+    int quoted;
+
+    if (len < 2 || data[0] != '{' || data[len - 1] != '}') {
+        PyErr_SetString(PoqueError, "Invalid multirange value");
+        return NULL;
+    }
+    ranges = PyList_New(0);
+    if (ranges == NULL) {
+        return NULL;
+    }
+    p = data + 1;
+    end = data + len - 1;
+    while (p < end) {
+        /* find the closing bracket outside of quotes */
+        start = p;
+        for (quoted = 0, p++; p < end; p++) {
+            if (*p == '\\') {
+                p++;
+            }
+            else if (*p == '"') {
+                quoted = !quoted;
+            }
+            else if (!quoted && (*p == ']' || *p == ')')) {
+                break;
+            }
+        }
+        if (p >= end) {
+            Py_DECREF(ranges);
+            PyErr_SetString(PoqueError, "Invalid multirange value");
+            return NULL;
+        }
+        p++;
+        range = el_handler->readers[FORMAT_TEXT](
+            result, start, (int)(p - start), el_handler->el_handler);
+        if (range == NULL || PyList_Append(ranges, range) == -1) {
+            Py_XDECREF(range);
+            Py_DECREF(ranges);
+            return NULL;
+        }
+        Py_DECREF(range);
+        if (p < end && *p++ != ',') {
+            Py_DECREF(ranges);
+            PyErr_SetString(PoqueError, "Invalid multirange value");
+            return NULL;
+        }
+    }
+    return ranges;
+}
+
+
+/* ==== range parameter handler ============================================= */
+
+typedef struct _RangeParamHandler {
+    param_handler handler;      /* base handler */
+    param_handler *el_handler;  /* param handler of the bounds */
+    PyTypeObject *el_type;      /* Python type of the bounds */
+    int num_bounds;             /* maximum number of bounds */
+    int bounds_size;            /* size of the bounds examined so far */
+} RangeParamHandler;
+
+
+static int
+range_oids(Oid el_oid, Oid *oid, Oid *array_oid)
+{
+    /* gets the range type of the type of the bounds */
+    switch (el_oid) {
+    case INT4OID:
+        *oid = INT4RANGEOID;
+        *array_oid = INT4RANGEARRAYOID;
+        return 0;
+    case INT8OID:
+        *oid = INT8RANGEOID;
+        *array_oid = INT8RANGEARRAYOID;
+        return 0;
+    case NUMERICOID:
+        *oid = NUMRANGEOID;
+        *array_oid = NUMRANGEARRAYOID;
+        return 0;
+    case TIMESTAMPOID:
+        *oid = TSRANGEOID;
+        *array_oid = TSRANGEARRAYOID;
+        return 0;
+    case TIMESTAMPTZOID:
+        *oid = TSTZRANGEOID;
+        *array_oid = TSTZRANGEARRAYOID;
+        return 0;
+    case DATEOID:
+        *oid = DATERANGEOID;
+        *array_oid = DATERANGEARRAYOID;
+        return 0;
+    }
+    PyErr_SetString(PyExc_ValueError, "Unsupported type of range bounds");
+    return -1;
+}
+
+
+static int
+range_examine(RangeParamHandler *handler, PyObject *param) {
+    /* Examines the bounds with the parameter handler of their type.
+     *
+     * The size of earlier bounds can change while examining, for example when
+     * int4 values become int8 values. Therefore the size returned is the
+     * difference between the total size of the bounds before and after.
+     */
+    PoqueRange *range = (PoqueRange *)param;
+    PyObject *bound;
+    int prev_size, size = 1, bound_size, i;
+
+    if (range->flags & RANGE_EMPTY) {
+        return 1;
+    }
+    prev_size = handler->bounds_size;
+    for (i = 0; i < 2; i++) {
+        if (range->flags & (i ? RANGE_UB_INF : RANGE_LB_INF)) {
+            continue;
+        }
+        bound = i ? range->upper : range->lower;
+        if (handler->el_handler == NULL) {
+            handler->el_type = Py_TYPE(bound);
+            handler->el_handler = get_param_handler_constructor(
+                handler->el_type)(handler->num_bounds);
+            if (handler->el_handler == NULL) {
+                return -1;
+            }
+        }
+        else if (Py_TYPE(bound) != handler->el_type) {
+            PyErr_SetString(PyExc_ValueError, "Can not mix types");
+            return -1;
+        }
+        bound_size = PH_Examine(handler->el_handler, bound);
+        if (bound_size < 0) {
+            return -1;
+        }
+        handler->bounds_size += bound_size;
+        size += 4;
+    }
+    if (handler->el_handler == NULL) {
+        /* The binary value of a range without bounds is the same for all
+         * range types, the server infers the type.
+         */
+        return size;
+    }
+    if (PH_HasTotalSize(handler->el_handler)) {
+        handler->bounds_size = PH_TotalSize(handler->el_handler);
+    }
+    if (range_oids(PH_Oid(handler->el_handler), &handler->handler.oid,
+                   &handler->handler.array_oid) == -1) {
+        return -1;
+    }
+    return size + handler->bounds_size - prev_size;
+}
+
+
+static int
+range_encode_at(RangeParamHandler *handler, PyObject *param, char *loc) {
+    PoqueRange *range = (PoqueRange *)param;
+    char *p = loc + 1;
+    int i, size;
+
+    loc[0] = range->flags;
+    if (range->flags & RANGE_EMPTY) {
+        return 1;
+    }
+    for (i = 0; i < 2; i++) {
+        if (range->flags & (i ? RANGE_UB_INF : RANGE_LB_INF)) {
+            continue;
+        }
+        size = PH_EncodeValueAt(
+            handler->el_handler, i ? range->upper : range->lower, p + 4);
+        if (size < 0) {
+            return -1;
+        }
+        put_uint32(p, size);
+        p += 4 + size;
+    }
+    return (int)(p - loc);
+}
+
+
+static void
+range_free(RangeParamHandler *handler) {
+    param_handler *el_handler;
+
+    el_handler = handler->el_handler;
+    if (el_handler && PH_HasFree(el_handler)) {
+        PH_Free(el_handler);
+    }
+    PyMem_Free(handler);
+}
+
+
+static param_handler *
+new_range_param_handler(int num_param) {
+    static RangeParamHandler def_handler = {{
+            (ph_examine)range_examine,      /* examine */
+            NULL,                           /* total_size */
+            NULL,                           /* encode */
+            (ph_encode_at)range_encode_at,  /* encode_at */
+            (ph_free)range_free,            /* free */
+            InvalidOid,                     /* oid */
+            InvalidOid                      /* array_oid */
+        },
+        NULL,                               /* el_handler */
+        NULL,                               /* el_type */
+        0,                                  /* num_bounds */
+        0                                   /* bounds_size */
+    }; /* static initialized handler */
+    RangeParamHandler *handler;
+
+    handler = (RangeParamHandler *)new_param_handler(
+        (param_handler *)&def_handler, sizeof(RangeParamHandler));
+    if (handler != NULL) {
+        handler->num_bounds = num_param * 2;
+    }
+    return (param_handler *)handler;
+}
+
+
+/* ======== initialization ================================================== */
+
+PoqueValueHandler int4range_val_handler = {
+        {range_strval, range_binval}, ',', &int4_val_handler};
+PoqueValueHandler int8range_val_handler = {
+        {range_strval, range_binval}, ',', &int8_val_handler};
+PoqueValueHandler numrange_val_handler = {
+        {range_strval, range_binval}, ',', &numeric_val_handler};
+PoqueValueHandler tsrange_val_handler = {
+        {range_strval, range_binval}, ',', &timestamp_val_handler};
+PoqueValueHandler tstzrange_val_handler = {
+        {range_strval, range_binval}, ',', &timestamptz_val_handler};
+PoqueValueHandler daterange_val_handler = {
+        {range_strval, range_binval}, ',', &date_val_handler};
+
+PoqueValueHandler int4rangearray_val_handler = {
+        {array_strval, array_binval}, ',', &int4range_val_handler};
+PoqueValueHandler int8rangearray_val_handler = {
+        {array_strval, array_binval}, ',', &int8range_val_handler};
+PoqueValueHandler numrangearray_val_handler = {
+        {array_strval, array_binval}, ',', &numrange_val_handler};
+PoqueValueHandler tsrangearray_val_handler = {
+        {array_strval, array_binval}, ',', &tsrange_val_handler};
+PoqueValueHandler tstzrangearray_val_handler = {
+        {array_strval, array_binval}, ',', &tstzrange_val_handler};
+PoqueValueHandler daterangearray_val_handler = {
+        {array_strval, array_binval}, ',', &daterange_val_handler};
+
+PoqueValueHandler int4multirange_val_handler = {
+        {multirange_strval, multirange_binval}, ',', &int4range_val_handler};
+PoqueValueHandler int8multirange_val_handler = {
+        {multirange_strval, multirange_binval}, ',', &int8range_val_handler};
+PoqueValueHandler nummultirange_val_handler = {
+        {multirange_strval, multirange_binval}, ',', &numrange_val_handler};
+PoqueValueHandler tsmultirange_val_handler = {
+        {multirange_strval, multirange_binval}, ',', &tsrange_val_handler};
+PoqueValueHandler tstzmultirange_val_handler = {
+        {multirange_strval, multirange_binval}, ',', &tstzrange_val_handler};
+PoqueValueHandler datemultirange_val_handler = {
+        {multirange_strval, multirange_binval}, ',', &daterange_val_handler};
+
+PoqueValueHandler int4multirangearray_val_handler = {
+        {array_strval, array_binval}, ',', &int4multirange_val_handler};
+PoqueValueHandler int8multirangearray_val_handler = {
+        {array_strval, array_binval}, ',', &int8multirange_val_handler};
+PoqueValueHandler nummultirangearray_val_handler = {
+        {array_strval, array_binval}, ',', &nummultirange_val_handler};
+PoqueValueHandler tsmultirangearray_val_handler = {
+        {array_strval, array_binval}, ',', &tsmultirange_val_handler};
+PoqueValueHandler tstzmultirangearray_val_handler = {
+        {array_strval, array_binval}, ',', &tstzmultirange_val_handler};
+PoqueValueHandler datemultirangearray_val_handler = {
+        {array_strval, array_binval}, ',', &datemultirange_val_handler};
+
+
+int
+init_range(void)
+{
+    register_parameter_handler(&PoqueRangeType, new_range_param_handler);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef _POQUE_RANGE_H_
+#define _POQUE_RANGE_H_
+
+#include "poque_type.h"
+
+extern PoqueValueHandler int4range_val_handler;
+extern PoqueValueHandler int8range_val_handler;
+extern PoqueValueHandler numrange_val_handler;
+extern PoqueValueHandler tsrange_val_handler;
+extern PoqueValueHandler tstzrange_val_handler;
+extern PoqueValueHandler daterange_val_handler;
+
+extern PoqueValueHandler int4rangearray_val_handler;
+extern PoqueValueHandler int8rangearray_val_handler;
+extern PoqueValueHandler numrangearray_val_handler;
+extern PoqueValueHandler tsrangearray_val_handler;
+extern PoqueValueHandler tstzrangearray_val_handler;
+extern PoqueValueHandler daterangearray_val_handler;
+
+extern PoqueValueHandler int4multirange_val_handler;
+extern PoqueValueHandler int8multirange_val_handler;
+extern PoqueValueHandler nummultirange_val_handler;
+extern PoqueValueHandler tsmultirange_val_handler;
+extern PoqueValueHandler tstzmultirange_val_handler;
+extern PoqueValueHandler datemultirange_val_handler;
+
+extern PoqueValueHandler int4multirangearray_val_handler;
+extern PoqueValueHandler int8multirangearray_val_handler;
+extern PoqueValueHandler nummultirangearray_val_handler;
+extern PoqueValueHandler tsmultirangearray_val_handler;
+extern PoqueValueHandler tstzmultirangearray_val_handler;
+extern PoqueValueHandler datemultirangearray_val_handler;
+
+int init_range(void);
+
+#endif
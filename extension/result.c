@@ -105,6 +105,99 @@ PoqueValue_New(PoqueResult *result, char *data, int len)
 }
 
 
+/* ===== ValueMemo ========================================================== */
+
+/* A ValueMemo caches the Python objects of a column by their raw binary
+ * value. It is meant for types like date and timestamp, where columns often
+ * contain only a few distinct values and creating the objects is relatively
+ * expensive.
+ *
+ * It is a small direct mapped table, so its size is bounded. The first
+ * MEMO_PROBE lookups determine if the column repeats enough values to be
+ * worth it. Otherwise the memo is dropped.
+ */
+
+#define MEMO_BITS           6
+#define MEMO_SIZE           (1 << MEMO_BITS)
+#define MEMO_PROBE          256
+
+typedef struct _memoSlot {
+    PY_UINT64_T key;
+    PyObject *value;
+} MemoSlot;
+
+typedef struct _valueMemo {
+    int lookups;
+    int hits;
+    MemoSlot slots[MEMO_SIZE];
+} ValueMemo;
+
+
+static void
+ValueMemo_Free(ValueMemo *memo)
+{
+    int i;
+
+    for (i = 0; i < MEMO_SIZE; i++) {
+        Py_XDECREF(memo->slots[i].value);
+    }
+    PyMem_Free(memo);
+}
+
+
+static PyObject *
+Result_memo_read(PoqueResult *self, ResultValueReader *reader, char *data,
+                 int len)
+{
+    ValueMemo *memo = reader->memo;
+    PY_UINT64_T key = 0;
+    MemoSlot *slot;
+    PyObject *value;
+
+    if (len != 4 && len != 8) {
+        /* not expected, let the reader handle it */
+        return reader->read_func(self, data, len, reader->el_handler);
+    }
+    memcpy(&key, data, len);
+    slot = &memo->slots[(key * 0x9E3779B97F4A7C15ULL) >> (64 - MEMO_BITS)];
+
+    memo->lookups++;
+    if (slot->value != NULL && slot->key == key) {
+        memo->hits++;
+        Py_INCREF(slot->value);
+        return slot->value;
+    }
+
+    value = reader->read_func(self, data, len, reader->el_handler);
+    if (value == NULL) {
+        return NULL;
+    }
+    if (memo->lookups >= MEMO_PROBE && memo->hits < memo->lookups / 2) {
+        /* too many distinct values */
+        reader->memo = NULL;
+        ValueMemo_Free(memo);
+        return value;
+    }
+    Py_XDECREF(slot->value);
+    Py_INCREF(value);
+    slot->key = key;
+    slot->value = value;
+    return value;
+}
+
+
+static inline PyObject *
+Result_read(PoqueResult *self, int column, char *data, int len)
+{
+    ResultValueReader *reader = &self->readers[column];
+
+    if (reader->memo != NULL) {
+        return Result_memo_read(self, reader, data, len);
+    }
+    return reader->read_func(self, data, len, reader->el_handler);
+}
+
+
 /* ===== PoqueResult ======================================================== */
 
 PoqueResult *
@@ -121,11 +214,24 @@ PoqueResult_New(PGresult *res, PoqueConn *conn) {
     result->wr_list = NULL;
     Py_INCREF(conn);
     result->conn = conn;
+    Py_XINCREF(conn->type_handlers);
+    result->type_handlers = conn->type_handlers;
 
     for (i = 0; i < nfields; i++) {
-        PoqueValueHandler *handler = get_value_handler(PQftype(res, i));
-        result->readers[i].read_func = handler->readers[PQfformat(res, i)];
-        result->readers[i].el_handler = handler->el_handler;
+        PoqueValueHandler *handler = find_value_handler(
+            result->type_handlers, PQftype(res, i));
+        int format = PQfformat(res, i);
+        ResultValueReader *reader = &result->readers[i];
+
+        reader->read_func = handler->readers[format];
+        reader->native_func = handler->natives[format];
+        reader->el_handler = handler->el_handler;
+        reader->memo = NULL;
+        if (handler->memoize && format == FORMAT_BINARY &&
+                PQntuples(res) > 1) {
+            /* no problem if it fails, values will be created every time */
+            reader->memo = PyMem_Calloc(1, sizeof(ValueMemo));
+        }
     }
     return result;
 }
@@ -133,8 +239,16 @@ PoqueResult_New(PGresult *res, PoqueConn *conn) {
 
 static void
 Result_dealloc(PoqueResult *self) {
+    Py_ssize_t i;
+
+    for (i = 0; i < Py_SIZE(self); i++) {
+        if (self->readers[i].memo != NULL) {
+            ValueMemo_Free(self->readers[i].memo);
+        }
+    }
     PQclear(self->result);
     Py_DECREF(self->conn);
+    Py_XDECREF(self->type_handlers);
     if (self->wr_list != NULL)
         PyObject_ClearWeakRefs((PyObject *) self);
     Py_TYPE(self)->tp_free((PyObject*)self);
@@ -353,18 +467,139 @@ PyObject *
 _Result_value(PoqueResult *self, int row, int column)
 {
     PGresult *res = self->result;
-    ResultValueReader *reader;
 
     if (PQgetisnull(res, row, column)) {
         Py_RETURN_NONE;
     }
-    reader = &self->readers[column];
-
-    return reader->read_func(
-        self,
+    return Result_read(
+        self, column,
         PQgetvalue(res, row, column),
-        PQgetlength(res, row, column),
-        reader->el_handler);
+        PQgetlength(res, row, column));
+}
+
+
+/* ==== batch conversion ==================================================== */
+
+/* When multiple rows are requested at once, the values are converted in two
+ * stages. First the raw data is converted to native values column by column,
+ * without holding the GIL. Then the Python objects are created from those.
+ * Only the second stage blocks other Python threads.
+ */
+
+/* number of rows converted to native values in one go */
+#define NATIVE_CHUNK_ROWS   1024
+
+/* below this number of values, releasing the GIL is not worth it */
+#define NATIVE_MIN_VALUES   256
+
+
+static void
+Result_native_values(PoqueResult *self, int row, int nrows, NativeValue *values)
+{
+    PGresult *res = self->result;
+    int nfields = (int)Py_SIZE(self), i, j;
+
+    /* values are stored column major */
+    for (j = 0; j < nfields; j++) {
+        pq_native native_func = self->readers[j].native_func;
+        NativeValue *value = values + j * nrows;
+
+        for (i = row; i < row + nrows; i++, value++) {
+            if (PQgetisnull(res, i, j)) {
+                value->kind = NATIVE_NULL;
+                continue;
+            }
+            value->kind = NATIVE_NONE;
+            value->data = PQgetvalue(res, i, j);
+            value->len = PQgetlength(res, i, j);
+            if (native_func != NULL) {
+                native_func(value->data, value->len, value);
+            }
+        }
+    }
+}
+
+
+static PyObject *
+Result_native_object(PoqueResult *self, int column, NativeValue *value)
+{
+    PyObject *ret;
+
+    switch (value->kind) {
+    case NATIVE_NULL:
+        Py_RETURN_NONE;
+    case NATIVE_INT:
+        return PyLong_FromLongLong(value->val.i);
+    case NATIVE_FLOAT:
+        return PyFloat_FromDouble(value->val.d);
+    case NATIVE_BOOL:
+        return PyBool_FromLong((long)value->val.i);
+    case NATIVE_ASCII:
+        ret = PyUnicode_New(value->len, 127);
+        if (ret != NULL) {
+            memcpy(PyUnicode_1BYTE_DATA(ret), value->data, value->len);
+        }
+        return ret;
+    }
+    return Result_read(self, column, value->data, value->len);
+}
+
+
+int
+_Result_rows(PoqueResult *self, int row, int nrows, PyObject *rows)
+{
+    /* Fills the list 'rows' with 'nrows' row tuples, starting at 'row' */
+    int nfields = (int)Py_SIZE(self), chunk, n, i, j, ret = -1;
+    NativeValue *values;
+
+    if (nrows == 0) {
+        return 0;
+    }
+    chunk = nrows < NATIVE_CHUNK_ROWS ? nrows : NATIVE_CHUNK_ROWS;
+    values = PyMem_Malloc(sizeof(NativeValue) * chunk * (nfields ? nfields : 1));
+    if (values == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    /* keep the PGresult alive while the GIL is released */
+    Py_INCREF(self);
+
+    for (n = 0; n < nrows; n += chunk) {
+        if (chunk > nrows - n) {
+            chunk = nrows - n;
+        }
+        if (chunk * nfields < NATIVE_MIN_VALUES) {
+            Result_native_values(self, row + n, chunk, values);
+        }
+        else {
+            Py_BEGIN_ALLOW_THREADS
+            Result_native_values(self, row + n, chunk, values);
+            Py_END_ALLOW_THREADS
+        }
+
+        for (i = 0; i < chunk; i++) {
+            PyObject *tup = PyTuple_New(nfields);
+            if (tup == NULL) {
+                goto end;
+            }
+            PyList_SET_ITEM(rows, n + i, tup);
+            for (j = 0; j < nfields; j++) {
+                PyObject *val = Result_native_object(
+                    self, j, values + j * chunk + i);
+                if (val == NULL) {
+                    goto end;
+                }
+                PyTuple_SET_ITEM(tup, j, val);
+            }
+        }
+    }
+    ret = 0;
+
+end:
+    Py_DECREF(self);
+    PyMem_Free(values);
+    return ret;
 }
 
 
@@ -3,52 +3,224 @@
 
 /* ======== pg bytea type =================================================== */
 
-static char
-hex_to_char(char hex) {
-    char c = -1;
-    static const char hex_vals[] = {
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
-        -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, 10, 11, 12, 13, 14, 15
-    };
-
-    if (hex >= 0x30 && hex <= 0x66)
-        c = hex_vals[(size_t)hex];
-    if (c == -1)
-        PyErr_SetString(PoqueError, "Invalid hexadecimal character");
-    return c;
+/* Hexadecimal bytea values are decoded by a kernel that is chosen at
+ * initialization. On x86-64 the SSE2 kernel is always available, the AVX2
+ * kernel is used when the processor supports it. A kernel decodes as many
+ * character pairs as it can in bulk and returns the number of decoded bytes.
+ * It stops early at an invalid character, the scalar code then takes over
+ * to decode the rest and report the error.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define POQUE_HEX_SIMD
+#include <immintrin.h>
+#endif
+
+
+/* value of hexadecimal characters, -1 for invalid characters */
+static const signed char hex_vals[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+
+typedef Py_ssize_t (*hex_kernel)(
+    const unsigned char *src, Py_ssize_t npairs, unsigned char *dest);
+
+
+static Py_ssize_t
+hex_decode_scalar(
+        const unsigned char *src, Py_ssize_t npairs, unsigned char *dest)
+{
+    /* Decodes four pairs at a time, checking for invalid characters once per
+     * group */
+    Py_ssize_t i = 0;
+
+    for (; i + 4 <= npairs; i += 4, src += 8) {
+        int v0 = hex_vals[src[0]], v1 = hex_vals[src[1]],
+            v2 = hex_vals[src[2]], v3 = hex_vals[src[3]],
+            v4 = hex_vals[src[4]], v5 = hex_vals[src[5]],
+            v6 = hex_vals[src[6]], v7 = hex_vals[src[7]];
+
+        if ((v0 | v1 | v2 | v3 | v4 | v5 | v6 | v7) < 0) {
+            break;
+        }
+        dest[i] = (unsigned char)(v0 << 4 | v1);
+        dest[i + 1] = (unsigned char)(v2 << 4 | v3);
+        dest[i + 2] = (unsigned char)(v4 << 4 | v5);
+        dest[i + 3] = (unsigned char)(v6 << 4 | v7);
+    }
+    return i;
+}
+
+
+#ifdef POQUE_HEX_SIMD
+
+static inline __m128i
+hex_values_sse2(__m128i chars, int *invalid)
+{
+    /* converts 16 hexadecimal characters to their values */
+    __m128i lower, digits, letters, is_digit, is_letter;
+
+    digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    is_digit = _mm_and_si128(
+        _mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+    lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    letters = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+    is_letter = _mm_and_si128(
+        _mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+        _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+    *invalid = _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xFFFF;
+    return _mm_or_si128(_mm_and_si128(is_digit, digits),
+                        _mm_and_si128(is_letter, letters));
+}
+
+
+static inline __m128i
+hex_combine_sse2(__m128i values)
+{
+    /* combines pairs of values into 16 bit words holding a byte each */
+    __m128i high, low;
+
+    high = _mm_slli_epi16(
+        _mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4);
+    low = _mm_srli_epi16(values, 8);
+    return _mm_or_si128(high, low);
+}
+
+
+static Py_ssize_t
+hex_decode_sse2(
+        const unsigned char *src, Py_ssize_t npairs, unsigned char *dest)
+{
+    Py_ssize_t i = 0;
+
+    /* 32 characters into 16 bytes per iteration */
+    for (; i + 16 <= npairs; i += 16, src += 32) {
+        __m128i a, b;
+        int invalid_a, invalid_b;
+
+        a = hex_values_sse2(
+            _mm_loadu_si128((const __m128i *)src), &invalid_a);
+        b = hex_values_sse2(
+            _mm_loadu_si128((const __m128i *)(src + 16)), &invalid_b);
+        if (invalid_a | invalid_b) {
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_packus_epi16(
+            hex_combine_sse2(a), hex_combine_sse2(b)));
+    }
+    return i + hex_decode_scalar(src, npairs - i, dest + i);
 }
 
 
+__attribute__((target("avx2")))
+static Py_ssize_t
+hex_decode_avx2(
+        const unsigned char *src, Py_ssize_t npairs, unsigned char *dest)
+{
+    Py_ssize_t i = 0;
+
+    /* 64 characters into 32 bytes per iteration */
+    for (; i + 32 <= npairs; i += 32, src += 64) {
+        __m256i chars[2], words[2];
+        int j, valid = -1;
+
+        for (j = 0; j < 2; j++) {
+            __m256i lower, is_digit, is_letter, values;
+
+            chars[j] = _mm256_loadu_si256((const __m256i *)(src + j * 32));
+            is_digit = _mm256_and_si256(
+                _mm256_cmpgt_epi8(chars[j], _mm256_set1_epi8('0' - 1)),
+                _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), chars[j]));
+            lower = _mm256_or_si256(chars[j], _mm256_set1_epi8(0x20));
+            is_letter = _mm256_and_si256(
+                _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                _mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+            valid &= _mm256_movemask_epi8(
+                _mm256_or_si256(is_digit, is_letter));
+            values = _mm256_or_si256(
+                _mm256_and_si256(is_digit, _mm256_sub_epi8(
+                    chars[j], _mm256_set1_epi8('0'))),
+                _mm256_and_si256(is_letter, _mm256_sub_epi8(
+                    lower, _mm256_set1_epi8('a' - 10))));
+
+            /* combine pairs into 16 bit words holding a byte each */
+            words[j] = _mm256_or_si256(
+                _mm256_slli_epi16(_mm256_and_si256(
+                    values, _mm256_set1_epi16(0x00FF)), 4),
+                _mm256_srli_epi16(values, 8));
+        }
+        if (valid != -1) {
+            break;
+        }
+        /* packing works per 128 bit lane, put the lanes back in order */
+        _mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute4x64_epi64(
+            _mm256_packus_epi16(words[0], words[1]), 0xD8));
+    }
+    return i + hex_decode_sse2(src, npairs - i, dest + i);
+}
+
+static hex_kernel hex_decode = hex_decode_sse2;
+
+#else
+
+static hex_kernel hex_decode = hex_decode_scalar;
+
+#endif
+
+
 static int
 bytea_fill_fromhex(char *data, char *end, char *dest) {
     /* Converts a hexadecimal bytea value to a binary value */
 
-    char *src;
+    unsigned char *src;
+    Py_ssize_t npairs, done;
+
+    src = (unsigned char *)data + 2;  /* skip hex prefix ('\x') */
+    npairs = ((unsigned char *)end - src) / 2;
+
+    /* bulk decoding */
+    done = hex_decode(src, npairs, (unsigned char *)dest);
+    src += done * 2;
+    dest += done;
 
-    src = data + 2;  /* skip hex prefix ('\x') */
-    while (src < end) {
-        char v1, v2;
+    /* the rest, one pair at a time with error reporting */
+    while (src < (unsigned char *)end) {
+        int v1, v2;
 
-        v1 = hex_to_char(*src++);
+        v1 = hex_vals[*src++];
         if (v1 == -1) {
+            PyErr_SetString(PoqueError, "Invalid hexadecimal character");
             return -1;
         }
-        if (src == end) {
+        if (src == (unsigned char *)end) {
             PyErr_SetString(
                 PoqueError,
                 "Odd number of hexadecimal characters in bytea value");
             return -1;
         }
-        v2 = hex_to_char(*src++);
+        v2 = hex_vals[*src++];
         if (v2 == -1) {
+            PyErr_SetString(PoqueError, "Invalid hexadecimal character");
             return -1;
         }
-        *dest++ = (v1 << 4) | v2;
+        *dest++ = (char)(v1 << 4 | v2);
     }
     return 0;
 }
@@ -56,29 +228,36 @@ bytea_fill_fromhex(char *data, char *end, char *dest) {
 
 static int
 bytea_fill_fromescape(char *data, char *end, char *dest) {
-    /* Converts a classically escaped bytea value to a binary value */
+    /* Converts a classically escaped bytea value to a binary value
+     *
+     * The value has been validated while calculating the length. Runs of
+     * regular bytes are copied in one go.
+     */
 
     while (data < end) {
-        /* fill destination buffer */
-        if (data[0] != '\\')
-            /* regular byte */
-            *dest = *data++;
-        else if ((data[1] >= '0' && data[1] <= '3') &&
-                 (data[2] >= '0' && data[2] <= '7') &&
-                 (data[3] >= '0' && data[3] <= '7')) {
-            /* escaped octal value */
-            *dest = (data[1] - '0') << 6 | (data[2] - '0') << 3 | (data[3] - '0');
-            data += 4;
+        char *esc;
+
+        /* copy up to the next backslash */
+        esc = memchr(data, '\\', end - data);
+        if (esc == NULL) {
+            esc = end;
         }
-        else if (data[1] == '\\') {
+        memcpy(dest, data, esc - data);
+        dest += esc - data;
+        data = esc;
+        if (data == end) {
+            break;
+        }
+
+        if (data[1] == '\\') {
             /* escaped backslash */
             *dest = '\\';
             data += 2;
         }
         else {
-            /* Should be impossible, but compiler complains */
-            PyErr_SetString(PoqueError, "Invalid escaped bytea value");
-            return -1;
+            /* escaped octal value */
+            *dest = (data[1] - '0') << 6 | (data[2] - '0') << 3 | (data[3] - '0');
+            data += 4;
         }
         dest++;
     }
@@ -106,29 +285,29 @@ bytea_strval(
         bytea_len = (len - 2) / 2;
         fill_func = bytea_fill_fromhex;
     } else {
-        /* escape format */
+        /* escape format, jump from backslash to backslash */
         char *src = data;
-        bytea_len = 0;
-        while (src < end) {
-            /* get length of value in bytes */
-            if (src[0] != '\\')
-                /* just a byte */
-                src++;
-            else if (end - src >= 4 &&
-                     (src[1] >= '0' && src[1] <= '3') &&
-                     (src[2] >= '0' && src[2] <= '7') &&
-                     (src[3] >= '0' && src[3] <= '7'))
+        bytea_len = len;
+        while ((src = memchr(src, '\\', end - src)) != NULL) {
+            /* subtract the escape characters from the length */
+            if (end - src >= 4 &&
+                    (src[1] >= '0' && src[1] <= '3') &&
+                    (src[2] >= '0' && src[2] <= '7') &&
+                    (src[3] >= '0' && src[3] <= '7')) {
                 /* octal value */
                 src += 4;
-            else if (end - src >= 2 && src[1] == '\\')
+                bytea_len -= 3;
+            }
+            else if (end - src >= 2 && src[1] == '\\') {
                 /* escaped backslash */
                 src += 2;
+                bytea_len -= 1;
+            }
             else {
                 /* erronous value */
                 PyErr_SetString(PoqueError, "Invalid escaped bytea value");
                 return NULL;
             }
-            bytea_len++;
         }
         fill_func = bytea_fill_fromescape;
     }
@@ -217,8 +396,180 @@ text_val(PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler
 }
 
 
+static void
+text_native(char *data, int len, NativeValue *value)
+{
+    /* Checks if the text is pure ASCII. In that case, the str can be created
+     * by a plain copy instead of UTF-8 decoding.
+     */
+    char *end = data + len;
+    PY_UINT64_T word;
+
+    for (; end - data >= 8; data += 8) {
+        memcpy(&word, data, 8);
+        if (word & 0x8080808080808080ULL) {
+            return;
+        }
+    }
+    for (; data < end; data++) {
+        if (*data & 0x80) {
+            return;
+        }
+    }
+    value->kind = NATIVE_ASCII;
+}
+
+
+/* ======== str parameters ================================================== */
+
+/* PyUnicode_AsUTF8AndSize attaches a UTF-8 copy to the str object for the
+ * rest of its lifetime. Instead, ASCII strings are sent straight from their
+ * own data, and other strings are encoded into memory of the parameter.
+ */
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define POQUE_UTF8_SSE2
+#include <emmintrin.h>
+#endif
+
+
+static Py_ssize_t
+latin1_count_high(const unsigned char *s, Py_ssize_t n)
+{
+    /* number of characters that take two bytes in UTF-8 */
+    Py_ssize_t i = 0, count = 0;
+
+#ifdef POQUE_UTF8_SSE2
+    for (; i + 16 <= n; i += 16) {
+        count += __builtin_popcount(_mm_movemask_epi8(
+            _mm_loadu_si128((const __m128i *)(s + i))));
+    }
+#endif
+    for (; i < n; i++) {
+        count += s[i] >> 7;
+    }
+    return count;
+}
+
+
+Py_ssize_t
+text_utf8_size(PyObject *str, const char **direct)
+{
+    /* Returns the size of the UTF-8 encoding of a str, or -1 on error.
+     *
+     * For an ASCII str, direct is set to its data, which is valid UTF-8.
+     * Otherwise it is set to NULL and text_utf8_write must be used.
+     */
+    const void *data;
+    Py_ssize_t len, size, i;
+    Py_UCS4 ch;
+    int kind;
+
+    if (PyUnicode_READY(str) < 0) {
+        return -1;
+    }
+    len = PyUnicode_GET_LENGTH(str);
+    data = PyUnicode_DATA(str);
+    if (PyUnicode_IS_ASCII(str)) {
+        *direct = data;
+        return len;
+    }
+    *direct = NULL;
+    kind = PyUnicode_KIND(str);
+    if (kind == PyUnicode_1BYTE_KIND) {
+        return len + latin1_count_high(data, len);
+    }
+    size = len;
+    for (i = 0; i < len; i++) {
+        ch = PyUnicode_READ(kind, data, i);
+        if (ch >= 0x80) {
+            size += 1 + (ch >= 0x800) + (ch >= 0x10000);
+            if (Py_UNICODE_IS_SURROGATE(ch)) {
+                /* let Python raise the encoding error */
+                PyObject *encoded = PyUnicode_AsUTF8String(str);
+                if (encoded != NULL) {
+                    Py_DECREF(encoded);
+                    PyErr_SetString(PyExc_ValueError, "Invalid string");
+                }
+                return -1;
+            }
+        }
+    }
+    return size;
+}
+
+
+Py_ssize_t
+text_utf8_write(PyObject *str, char *loc)
+{
+    /* Writes the UTF-8 encoding of a str that is not ASCII. Its size must
+     * have been checked with text_utf8_size. Returns the size.
+     */
+    const void *data = PyUnicode_DATA(str);
+    unsigned char *p = (unsigned char *)loc;
+    Py_ssize_t len = PyUnicode_GET_LENGTH(str), i = 0;
+    int kind = PyUnicode_KIND(str);
+    Py_UCS4 ch;
+
+    if (kind == PyUnicode_1BYTE_KIND) {
+        const unsigned char *s = data;
+        Py_ssize_t end;
+
+        while (i < len) {
+            end = len;
+#ifdef POQUE_UTF8_SSE2
+            if (i + 16 <= len) {
+                __m128i chunk = _mm_loadu_si128((const __m128i *)(s + i));
+                if (_mm_movemask_epi8(chunk) == 0) {
+                    /* sixteen ASCII characters */
+                    _mm_storeu_si128((__m128i *)p, chunk);
+                    p += 16;
+                    i += 16;
+                    continue;
+                }
+                end = i + 16;
+            }
+#endif
+            for (; i < end; i++) {
+                ch = s[i];
+                if (ch < 0x80) {
+                    *p++ = (unsigned char)ch;
+                }
+                else {
+                    *p++ = (unsigned char)(0xc0 | (ch >> 6));
+                    *p++ = (unsigned char)(0x80 | (ch & 0x3f));
+                }
+            }
+        }
+        return (char *)p - loc;
+    }
+    for (; i < len; i++) {
+        ch = PyUnicode_READ(kind, data, i);
+        if (ch < 0x80) {
+            *p++ = (unsigned char)ch;
+        }
+        else if (ch < 0x800) {
+            *p++ = (unsigned char)(0xc0 | (ch >> 6));
+            *p++ = (unsigned char)(0x80 | (ch & 0x3f));
+        }
+        else if (ch < 0x10000) {
+            *p++ = (unsigned char)(0xe0 | (ch >> 12));
+            *p++ = (unsigned char)(0x80 | ((ch >> 6) & 0x3f));
+            *p++ = (unsigned char)(0x80 | (ch & 0x3f));
+        }
+        else {
+            *p++ = (unsigned char)(0xf0 | (ch >> 18));
+            *p++ = (unsigned char)(0x80 | ((ch >> 12) & 0x3f));
+            *p++ = (unsigned char)(0x80 | ((ch >> 6) & 0x3f));
+            *p++ = (unsigned char)(0x80 | (ch & 0x3f));
+        }
+    }
+    return (char *)p - loc;
+}
+
+
 typedef struct _TextParam {
-    char *string;
+    const char *string;     /* data of an ASCII str, NULL otherwise */
     int size;
 } TextParam;
 
@@ -228,18 +579,19 @@ typedef struct _TextParamHandler {
     int num_params;
     int examine_pos;
     int encode_pos;
+    char *data;             /* encoded value for the encode method */
     TextParam params[];
 } TextParamHandler;
 
 
 static int
 text_examine(TextParamHandler *handler, PyObject *param) {
-    char *string;
+    const char *string;
     Py_ssize_t size;
     TextParam *tp;
 
-    string = PyUnicode_AsUTF8AndSize(param, &size);
-    if (string == NULL) {
+    size = text_utf8_size(param, &string);
+    if (size < 0) {
         return -1;
     }
 #if SIZEOF_SIZE_T > SIZEOF_INT
@@ -261,7 +613,17 @@ text_encode(TextParamHandler *handler, PyObject *param, char **loc) {
     TextParam *tp;
 
     tp = current_encode_param(handler);
-    *loc = tp->string;
+    if (tp->string) {
+        *loc = (char *)tp->string;
+        return 0;
+    }
+    handler->data = PyMem_Malloc(tp->size);
+    if (handler->data == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    text_utf8_write(param, handler->data);
+    *loc = handler->data;
     return 0;
 }
 
@@ -273,11 +635,23 @@ text_encode_at(TextParamHandler *handler, PyObject *param, char *loc) {
 
     tp = current_encode_param(handler);
     size = (int)tp->size;
-    memcpy(loc, tp->string, size);
+    if (tp->string) {
+        memcpy(loc, tp->string, size);
+    }
+    else {
+        text_utf8_write(param, loc);
+    }
     return size;
 }
 
 
+static void
+text_handler_free(TextParamHandler *handler) {
+    PyMem_Free(handler->data);
+    PyMem_Free(handler);
+}
+
+
 param_handler *
 new_text_param_handler(int num_params) {
     static TextParamHandler def_handler = {
@@ -286,17 +660,20 @@ new_text_param_handler(int num_params) {
             NULL,                           /* total_size */
             (ph_encode)text_encode,            /* encode */
             (ph_encode_at)text_encode_at,   /* encode_at */
-            (ph_free)PyMem_Free,            /* free */
+            (ph_free)text_handler_free,     /* free */
             TEXTOID,                        /* oid */
             TEXTARRAYOID,                    /* array_oid */
         },
-        0
+        0,
+        0,
+        0,
+        NULL
     }; /* static initialized handler */
     param_handler *handler;
 
-    handler = new_param_handler(
-        (param_handler *)&def_handler,
-        sizeof(TextParamHandler) + num_params * sizeof(TextParam));
+    handler = new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(TextParamHandler),
+        num_params, sizeof(TextParam));
     if (handler == NULL) {
         return NULL;
     }
@@ -304,6 +681,65 @@ new_text_param_handler(int num_params) {
 }
 
 
+static Py_ssize_t
+text_list_examine(PyObject **items, Py_ssize_t n, list_encoding *enc) {
+    /* Sums the UTF-8 sizes */
+    Py_ssize_t i, num_null = 0, size, total = 0;
+    const char *direct;
+    PyObject *item;
+
+    for (i = 0; i < n; i++) {
+        item = items[i];
+        if (item == Py_None) {
+            num_null++;
+            continue;
+        }
+        if (Py_TYPE(item) != &PyUnicode_Type) {
+            return -2;
+        }
+        size = text_utf8_size(item, &direct);
+        if (size < 0) {
+            return -1;
+        }
+        total += size;
+        if (total > INT32_MAX) {
+            PyErr_SetString(PyExc_ValueError,
+                            "String too long for postgresql");
+            return -1;
+        }
+    }
+    enc->num_null = num_null;
+    enc->oid = TEXTOID;
+    enc->array_oid = TEXTARRAYOID;
+    return total;
+}
+
+
+static int
+text_list_write(PyObject **items, Py_ssize_t n, list_encoding *enc, char *loc)
+{
+    Py_ssize_t i, size;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            put_uint32(loc, -1);
+            loc += 4;
+            continue;
+        }
+        if (PyUnicode_IS_ASCII(items[i])) {
+            size = PyUnicode_GET_LENGTH(items[i]);
+            memcpy(loc + 4, PyUnicode_DATA(items[i]), size);
+        }
+        else {
+            size = text_utf8_write(items[i], loc + 4);
+        }
+        put_uint32(loc, (PY_UINT32_T)size);
+        loc += 4 + size;
+    }
+    return 0;
+}
+
+
 typedef struct _ObjectParam {
     char *string;
     int size;
@@ -405,9 +841,9 @@ new_object_param_handler(int num_params) {
     }; /* static initialized handler */
     param_handler *handler;
 
-    handler = new_param_handler(
-        (param_handler *)&def_handler,
-        sizeof(ObjectParamHandler) + num_params * sizeof(ObjectParam));
+    handler = new_cache_param_handler(
+        (param_handler *)&def_handler, sizeof(ObjectParamHandler),
+        num_params, sizeof(ObjectParam));
     if (handler == NULL) {
         return NULL;
     }
@@ -431,7 +867,8 @@ char_binval(
 
 /* ======== initialization ================================================== */
 
-PoqueValueHandler text_val_handler = {{text_val, text_val}, ',', NULL};
+PoqueValueHandler text_val_handler = {
+        {text_val, text_val}, ',', NULL, {text_native, text_native}};
 PoqueValueHandler char_val_handler = {{char_binval, char_binval}, ',', NULL};
 PoqueValueHandler bytea_val_handler = {{bytea_strval, bytea_binval}, ',', NULL};
 
@@ -446,7 +883,14 @@ PoqueValueHandler byteaarray_val_handler = {
 int
 init_text(void)
 {
+#ifdef POQUE_HEX_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        hex_decode = hex_decode_avx2;
+    }
+#endif
     register_parameter_handler(&PyUnicode_Type, new_text_param_handler);
     register_parameter_handler(&PyBytes_Type, new_bytes_param_handler);
+    register_list_encoder(&PyUnicode_Type, text_list_examine, text_list_write);
     return 0;
 };
@@ -9,6 +9,8 @@ PyObject *text_val(
 PyObject *bytea_binval(
     PoqueResult *result, char *data, int len, PoqueValueHandler *el_handler);
 param_handler *new_text_param_handler(int num_param);
+Py_ssize_t text_utf8_size(PyObject *str, const char **direct);
+Py_ssize_t text_utf8_write(PyObject *str, char *loc);
 
 
 extern PoqueValueHandler text_val_handler;
@@ -5,21 +5,146 @@
 
 
 static PyTypeObject *PyUUID_Type;
+static PyObject *uuid_safe_unknown;
+
+/* offsets of the UUID slots, -1 if not available */
+static Py_ssize_t uuid_int_offset = -1;
+static Py_ssize_t uuid_is_safe_offset = -1;
+
+
+static PyObject *
+uuid_new(PyObject *int_value)
+{
+    /* Creates a UUID from its integer value. Steals the reference.
+     *
+     * The UUID constructor is pure Python and relatively slow. When the slots
+     * are available, the instance is created directly and its slots are set,
+     * like UUID.__init__ does with object.__setattr__.
+     */
+    PyObject *uuid, *args, *kwargs;
+
+    if (int_value == NULL) {
+        return NULL;
+    }
+    if (uuid_int_offset == -1 || uuid_is_safe_offset == -1) {
+        kwargs = Py_BuildValue("{sN}", "int", int_value);
+        if (kwargs == NULL) {
+            return NULL;
+        }
+        args = PyTuple_New(0);
+        if (args == NULL) {
+            Py_DECREF(kwargs);
+            return NULL;
+        }
+        uuid = PyObject_Call((PyObject *)PyUUID_Type, args, kwargs);
+        Py_DECREF(args);
+        Py_DECREF(kwargs);
+        return uuid;
+    }
+    uuid = PyUUID_Type->tp_alloc(PyUUID_Type, 0);
+    if (uuid == NULL) {
+        Py_DECREF(int_value);
+        return NULL;
+    }
+    *(PyObject **)((char *)uuid + uuid_int_offset) = int_value;
+    Py_INCREF(uuid_safe_unknown);
+    *(PyObject **)((char *)uuid + uuid_is_safe_offset) = uuid_safe_unknown;
+    return uuid;
+}
+
+
+static PyObject *
+uuid_str(char *data)
+{
+    /* canonical text representation of the 16 bytes */
+    static const char hex_chars[] = "0123456789abcdef";
+    PyObject *ret;
+    Py_UCS1 *p;
+    int i;
+
+    ret = PyUnicode_New(36, 127);
+    if (ret == NULL) {
+        return NULL;
+    }
+    p = PyUnicode_1BYTE_DATA(ret);
+    for (i = 0; i < UUID_LEN; i++) {
+        unsigned char c = data[i];
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            *p++ = '-';
+        }
+        *p++ = hex_chars[c >> 4];
+        *p++ = hex_chars[c & 0xf];
+    }
+    return ret;
+}
 
 
 PyObject *
 uuid_binval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 {
-    return PyObject_CallFunction(
-        (PyObject *)PyUUID_Type, "sy#", NULL, data, len);
+    if (len != UUID_LEN) {
+        PyErr_SetString(PoqueError, "Invalid uuid value");
+        return NULL;
+    }
+    switch (result->conn->uuid_as) {
+    case UUID_AS_BYTES:
+        return PyBytes_FromStringAndSize(data, UUID_LEN);
+    case UUID_AS_INT:
+        return _PyLong_FromByteArray((unsigned char *)data, UUID_LEN, 0, 0);
+    case UUID_AS_STR:
+        return uuid_str(data);
+    }
+    return uuid_new(
+        _PyLong_FromByteArray((unsigned char *)data, UUID_LEN, 0, 0));
+}
+
+
+static int
+hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
 }
 
 
 PyObject *
 uuid_strval(PoqueResult *result, char *data, int len, PoqueValueHandler *unused)
 {
-    return PyObject_CallFunction(
-        (PyObject *)PyUUID_Type, "s#", data, len);
+    char uuid[UUID_LEN], *end = data + len;
+    int i;
+
+    if (result->conn->uuid_as == UUID_AS_STR) {
+        return PyUnicode_FromStringAndSize(data, len);
+    }
+
+    /* parse the 32 hex digits, ignoring the dashes */
+    for (i = 0; i < UUID_LEN; i++) {
+        int high, low;
+
+        while (data < end && *data == '-') {
+            data++;
+        }
+        if (end - data < 2) {
+            break;
+        }
+        high = hex_value(data[0]);
+        low = hex_value(data[1]);
+        if (high == -1 || low == -1) {
+            break;
+        }
+        uuid[i] = (char)(high << 4 | low);
+        data += 2;
+    }
+    if (i != UUID_LEN || data != end) {
+        PyErr_SetString(PoqueError, "Invalid uuid value");
+        return NULL;
+    }
+    return uuid_binval(result, uuid, UUID_LEN, NULL);
 }
 
 
@@ -29,9 +154,21 @@ uuid_examine(param_handler *handler, PyObject *param) {
 }
 
 static int
-uuid_encode_at(
-        param_handler *handler, PyObject *param, char *loc) {
-    PyObject *bytes;
+uuid_write(PyObject *param, char *loc) {
+    PyObject *bytes, *int_value;
+
+    if (uuid_int_offset != -1) {
+        /* write the int slot directly */
+        int_value = *(PyObject **)((char *)param + uuid_int_offset);
+        if (int_value != NULL && PyLong_Check(int_value)) {
+            if (_PyLong_AsByteArray((PyLongObject *)int_value,
+                                    (unsigned char *)loc, UUID_LEN,
+                                    0, 0) == -1) {
+                return -1;
+            }
+            return UUID_LEN;
+        }
+    }
 
     bytes = PyObject_GetAttrString(param, "bytes");
     if (bytes == NULL) {
@@ -43,6 +180,53 @@ uuid_encode_at(
 }
 
 
+static int
+uuid_encode_at(
+        param_handler *handler, PyObject *param, char *loc) {
+    return uuid_write(param, loc);
+}
+
+
+static Py_ssize_t
+uuid_list_examine(PyObject **items, Py_ssize_t n, list_encoding *enc) {
+    Py_ssize_t i, num_null = 0;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            num_null++;
+        }
+        else if (Py_TYPE(items[i]) != PyUUID_Type) {
+            return -2;
+        }
+    }
+    enc->num_null = num_null;
+    enc->oid = UUIDOID;
+    enc->array_oid = UUIDARRAYOID;
+    return (n - num_null) * UUID_LEN;
+}
+
+
+static int
+uuid_list_write(PyObject **items, Py_ssize_t n, list_encoding *enc, char *loc)
+{
+    Py_ssize_t i;
+
+    for (i = 0; i < n; i++) {
+        if (items[i] == Py_None) {
+            put_uint32(loc, -1);
+            loc += 4;
+            continue;
+        }
+        put_uint32(loc, UUID_LEN);
+        if (uuid_write(items[i], loc + 4) < 0) {
+            return -1;
+        }
+        loc += 4 + UUID_LEN;
+    }
+    return 0;
+}
+
+
 static param_handler uuid_param_handler = {
     uuid_examine,       /* examine */
     NULL,               /* total_size */
@@ -64,12 +248,46 @@ PoqueValueHandler uuidarray_val_handler = {
         {array_strval, array_binval}, ',', &uuid_val_handler};
 
 
+static Py_ssize_t
+uuid_slot_offset(const char *name)
+{
+    /* Gets the offset of an object slot of the UUID type */
+    PyObject *descr;
+    PyMemberDef *member;
+
+    descr = PyDict_GetItemString(PyUUID_Type->tp_dict, name);
+    if (descr == NULL || Py_TYPE(descr) != &PyMemberDescr_Type) {
+        return -1;
+    }
+    member = ((PyMemberDescrObject *)descr)->d_member;
+    if (member->type != T_OBJECT_EX) {
+        return -1;
+    }
+    return member->offset;
+}
+
+
 int
 init_uuid(void) {
+    PyObject *safe_uuid;
+
     PyUUID_Type = (PyTypeObject *)load_python_object("uuid", "UUID");
     if (PyUUID_Type == NULL) {
         return -1;
     }
+    safe_uuid = load_python_object("uuid", "SafeUUID");
+    if (safe_uuid == NULL) {
+        return -1;
+    }
+    uuid_safe_unknown = PyObject_GetAttrString(safe_uuid, "unknown");
+    Py_DECREF(safe_uuid);
+    if (uuid_safe_unknown == NULL) {
+        return -1;
+    }
+    uuid_int_offset = uuid_slot_offset("int");
+    uuid_is_safe_offset = uuid_slot_offset("is_safe");
+
     register_parameter_handler(PyUUID_Type, new_uuid_param_handler);
+    register_list_encoder(PyUUID_Type, uuid_list_examine, uuid_list_write);
     return 0;
 }
@@ -0,0 +1,516 @@
+#include "vector.h"
+#include "buffer.h"
+
+#if PY_VERSION_HEX < 0x030B0000
+#define PyFloat_Pack2(x, p, le) _PyFloat_Pack2((x), (unsigned char *)(p), (le))
+#endif
+
+
+/* ==== Vector ============================================================= */
+
+/* pgvector values, which keep their items in a buffer of float32 values.
+ * The buffer protocol is forwarded to the values. A half vector is sent as
+ * a halfvec value, its items are float32 values in Python all the same.
+ */
+typedef struct {
+    PyObject_HEAD
+    PyObject *values;   /* buffer of float32 values */
+    char half;          /* whether it is a halfvec */
+} PoqueVector;
+
+/* maximum dimensions of the binary format */
+#define VECTOR_MAX_DIM  0xFFFF
+
+
+static Py_ssize_t
+vector_get_values(PyObject *values, Py_buffer *view)
+{
+    /* Gets the values buffer and returns the number of values */
+    const char *format;
+
+    if (PyObject_GetBuffer(
+            values, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1) {
+        return -1;
+    }
+    format = view->format;
+    if (format[0] == '@' || format[0] == '=') {
+        format++;
+    }
+    if (view->itemsize != 4 || strcmp(format, "f") != 0) {
+        PyErr_SetString(
+            PyExc_ValueError, "Values must be a buffer of float32 values");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (view->len / 4 > VECTOR_MAX_DIM) {
+        PyErr_SetString(PyExc_ValueError, "Too many dimensions");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return view->len / 4;
+}
+
+
+static PyObject *
+Vector_create(PyObject *values, int half)
+{
+    /* Creates a vector, steals the reference to the values */
+    PoqueVector *self;
+
+    self = (PoqueVector *)PoqueVectorType.tp_alloc(&PoqueVectorType, 0);
+    if (self == NULL) {
+        Py_DECREF(values);
+        return NULL;
+    }
+    self->values = values;
+    self->half = (char)half;
+    return (PyObject *)self;
+}
+
+
+static PyObject *
+vector_from_sequence(PyObject *seq)
+{
+    /* Converts a sequence of numbers into a float32 buffer */
+    PoqueArrayBuffer *buf;
+    PyObject **items;
+    Py_ssize_t n, i;
+    float *dest;
+    double val;
+
+    seq = PySequence_Fast(seq, "Values must be a float32 buffer or numbers");
+    if (seq == NULL) {
+        return NULL;
+    }
+    n = PySequence_Fast_GET_SIZE(seq);
+    if (n > VECTOR_MAX_DIM) {
+        Py_DECREF(seq);
+        PyErr_SetString(PyExc_ValueError, "Too many dimensions");
+        return NULL;
+    }
+    buf = ArrayBuffer_New("f", 4, 1, &n);
+    if (buf == NULL) {
+        Py_DECREF(seq);
+        return NULL;
+    }
+    items = PySequence_Fast_ITEMS(seq);
+    dest = (float *)ArrayBuffer_DATA(buf);
+    for (i = 0; i < n; i++) {
+        val = PyFloat_AsDouble(items[i]);
+        if (val == -1.0 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            Py_DECREF(buf);
+            return NULL;
+        }
+        dest[i] = (float)val;
+    }
+    Py_DECREF(seq);
+    return (PyObject *)buf;
+}
+
+
+static PyObject *
+Vector_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    static char *kwlist[] = {"values", "half", NULL};
+    PyObject *values;
+    Py_buffer view;
+    int half = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwds, "O|p", kwlist, &values, &half)) {
+        return NULL;
+    }
+    /* float32 buffers are used as is, other sequences are converted */
+    if (PyObject_CheckBuffer(values)) {
+        if (vector_get_values(values, &view) == -1) {
+            return NULL;
+        }
+        PyBuffer_Release(&view);
+        Py_INCREF(values);
+        return Vector_create(values, half);
+    }
+    values = vector_from_sequence(values);
+    if (values == NULL) {
+        return NULL;
+    }
+    return Vector_create(values, half);
+}
+
+
+static PyObject *
+Vector_repr(PoqueVector *self)
+{
+    if (self->half) {
+        return PyUnicode_FromFormat("Vector(%R, half=True)", self->values);
+    }
+    return PyUnicode_FromFormat("Vector(%R)", self->values);
+}
+
+
+static Py_ssize_t
+Vector_length(PoqueVector *self)
+{
+    Py_buffer view;
+    Py_ssize_t dim;
+
+    dim = vector_get_values(self->values, &view);
+    if (dim != -1) {
+        PyBuffer_Release(&view);
+    }
+    return dim;
+}
+
+
+static int
+Vector_GetBuffer(PoqueVector *self, Py_buffer *view, int flags)
+{
+    return PyObject_GetBuffer(self->values, view, flags);
+}
+
+
+static int
+Vector_traverse(PoqueVector *self, visitproc visit, void *arg)
+{
+    Py_VISIT(self->values);
+    return 0;
+}
+
+
+static int
+Vector_clear(PoqueVector *self)
+{
+    Py_CLEAR(self->values);
+    return 0;
+}
+
+
+static void
+Vector_dealloc(PoqueVector *self)
+{
+    PyObject_GC_UnTrack(self);
+    Vector_clear(self);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+
+static PyBufferProcs Vector_BufProcs = {
+    (getbufferproc)Vector_GetBuffer,
+    NULL
+};
+
+
+static PySequenceMethods Vector_as_sequence = {
+    (lenfunc)Vector_length,                     /* sq_length */
+};
+
+
+static PyMemberDef Vector_members[] = {
+    {"values", T_OBJECT, offsetof(PoqueVector, values), READONLY,
+     "buffer with float32 values"},
+    {"half", T_BOOL, offsetof(PoqueVector, half), READONLY,
+     "whether the vector is a halfvec"},
+    {NULL}  /* Sentinel */
+};
+
+
+PyTypeObject PoqueVectorType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "poque.Vector",                             /* tp_name */
+    sizeof(PoqueVector),                        /* tp_basicsize */
+    0,                                          /* tp_itemsize */
+    (destructor)Vector_dealloc,                 /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    (reprfunc)Vector_repr,                      /* tp_repr */
+    0,                                          /* tp_as_number */
+    &Vector_as_sequence,                        /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash  */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    &Vector_BufProcs,                           /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_GC,    /* tp_flags */
+    "pgvector value with its values in a float32 buffer",   /* tp_doc */
+    (traverseproc)Vector_traverse,              /* tp_traverse */
+    (inquiry)Vector_clear,                      /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    0,                                          /* tp_methods */
+    Vector_members,                             /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    Vector_new,                                 /* tp_new */
+};
+
+
+/* ==== vector values ====================================================== */
+
+static float
+half_to_float(poque_uint16 half)
+{
+    /* converts an IEEE 754 half precision value */
+    PY_UINT32_T sign, exp, mant, bits;
+    float ret;
+
+    sign = (PY_UINT32_T)(half & 0x8000) << 16;
+    exp = (half >> 10) & 0x1F;
+    mant = half & 0x3FF;
+    if (exp == 0x1F) {
+        /* infinity or NaN */
+        bits = sign | 0x7F800000 | (mant << 13);
+    }
+    else if (exp) {
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    else if (mant == 0) {
+        bits = sign;
+    }
+    else {
+        /* subnormal, normalize it */
+        exp = 113;
+        while (!(mant & 0x400)) {
+            mant <<= 1;
+            exp--;
+        }
+        bits = sign | (exp << 23) | ((mant & 0x3FF) << 13);
+    }
+    memcpy(&ret, &bits, 4);
+    return ret;
+}
+
+
+static PyObject *
+vector_values_binval(char *data, int len, int half)
+{
+    /* Reads the dimensions, an unused word and the packed items */
+    PoqueArrayBuffer *buf;
+    Py_ssize_t dim, i;
+    int itemsize = half ? 2 : 4;
+    float *dest;
+
+    CHECK_LENGTH_LT(len, 4, "vector", NULL);
+    dim = read_uint16(data);
+    ADVANCE_DATA(data, len, 4);
+    if (len != dim * itemsize) {
+        PyErr_SetString(PoqueError, "Invalid data for vector type.");
+        return NULL;
+    }
+    buf = ArrayBuffer_New("f", 4, 1, &dim);
+    if (buf == NULL) {
+        return NULL;
+    }
+    if (half) {
+        dest = (float *)ArrayBuffer_DATA(buf);
+        for (i = 0; i < dim; i++) {
+            dest[i] = half_to_float(read_uint16(data + 2 * i));
+        }
+    }
+    else {
+        swap_packed4(data, dim, ArrayBuffer_DATA(buf));
+    }
+    return Vector_create((PyObject *)buf, half);
+}
+
+
+static PyObject *
+vector_binval(PoqueResult *result, char *data, int len,
+              PoqueValueHandler *unused)
+{
+    return vector_values_binval(data, len, 0);
+}
+
+
+static PyObject *
+halfvec_binval(PoqueResult *result, char *data, int len,
+               PoqueValueHandler *unused)
+{
+    return vector_values_binval(data, len, 1);
+}
+
+
+static PyObject *
+vector_values_strval(char *data, int len, int half)
+{
+    /* Parses the comma separated values between brackets */
+    PoqueArrayBuffer *buf = NULL;
+    Py_ssize_t dim = 0, i;
+    char *str, *p, *end;
+    float *dest;
+
+    if (len < 2 || data[0] != '[' || data[len - 1] != ']') {
+        PyErr_SetString(PoqueError, "Invalid vector value");
+        return NULL;
+    }
+
+    /* copy the values for a terminating NUL character */
+    str = PyMem_Malloc(len);
+    if (str == NULL) {
+        return PyErr_NoMemory();
+    }
+    memcpy(str, data + 1, len - 2);
+    str[len - 2] = '\0';
+    if (len > 2) {
+        dim = 1;
+        for (p = str; *p; p++) {
+            dim += (*p == ',');
+        }
+    }
+    buf = ArrayBuffer_New("f", 4, 1, &dim);
+    if (buf == NULL) {
+        goto error;
+    }
+    dest = (float *)ArrayBuffer_DATA(buf);
+    p = str;
+    for (i = 0; i < dim; i++) {
+        dest[i] = (float)PyOS_string_to_double(p, &end, NULL);
+        if (dest[i] == -1.0 && PyErr_Occurred()) {
+            goto error;
+        }
+        if (*end != (i == dim - 1 ? '\0' : ',')) {
+            PyErr_SetString(PoqueError, "Invalid vector value");
+            goto error;
+        }
+        p = end + 1;
+    }
+    PyMem_Free(str);
+    return Vector_create((PyObject *)buf, half);
+
+error:
+    PyMem_Free(str);
+    Py_XDECREF(buf);
+    return NULL;
+}
+
+
+static PyObject *
+vector_strval(PoqueResult *result, char *data, int len,
+              PoqueValueHandler *unused)
+{
+    return vector_values_strval(data, len, 0);
+}
+
+
+static PyObject *
+halfvec_strval(PoqueResult *result, char *data, int len,
+               PoqueValueHandler *unused)
+{
+    return vector_values_strval(data, len, 1);
+}
+
+
+PoqueValueHandler vector_val_handler = {
+    {vector_strval, vector_binval}, ',', NULL};
+PoqueValueHandler halfvec_val_handler = {
+    {halfvec_strval, halfvec_binval}, ',', NULL};
+
+PoqueValueHandler vectorarray_val_handler = {
+    {array_strval, array_binval}, ',', &vector_val_handler};
+PoqueValueHandler halfvecarray_val_handler = {
+    {array_strval, array_binval}, ',', &halfvec_val_handler};
+
+
+/* ==== vector parameters ================================================== */
+
+typedef struct _VectorParamHandler {
+    param_handler handler;      /* base handler */
+    Py_buffer values;           /* held until the handler is freed */
+    Py_ssize_t dim;
+    Oid vector_oid;             /* registered oids, or InvalidOid to let the */
+    Oid halfvec_oid;            /* server infer the type */
+} VectorParamHandler;
+
+
+static int
+vector_examine(VectorParamHandler *handler, PyObject *param)
+{
+    PoqueVector *vec = (PoqueVector *)param;
+
+    if (vec->half && handler->halfvec_oid == InvalidOid &&
+            handler->vector_oid != InvalidOid) {
+        /* registered, but pgvector is too old for half vectors */
+        PyErr_SetString(PoqueError, "The halfvec type is not available");
+        return -1;
+    }
+    handler->dim = vector_get_values(vec->values, &handler->values);
+    if (handler->dim == -1) {
+        return -1;
+    }
+    handler->handler.oid = vec->half ?
+        handler->halfvec_oid : handler->vector_oid;
+    return 4 + (int)handler->dim * (vec->half ? 2 : 4);
+}
+
+
+static int
+vector_encode_at(VectorParamHandler *handler, PyObject *param, char *loc)
+{
+    PoqueVector *vec = (PoqueVector *)param;
+    const float *src = handler->values.buf;
+    Py_ssize_t i;
+
+    put_uint16(loc, (poque_uint16)handler->dim);
+    put_uint16(loc + 2, 0);
+    loc += 4;
+    if (!vec->half) {
+        swap_packed4(handler->values.buf, handler->dim, loc);
+        return 4 + (int)handler->dim * 4;
+    }
+    for (i = 0; i < handler->dim; i++) {
+        if (PyFloat_Pack2(src[i], loc + 2 * i, 0) == -1) {
+            return -1;
+        }
+    }
+    return 4 + (int)handler->dim * 2;
+}
+
+
+static void
+vector_free(VectorParamHandler *handler)
+{
+    if (handler->values.obj) {
+        PyBuffer_Release(&handler->values);
+    }
+    PyMem_Free(handler);
+}
+
+
+param_handler *
+new_vector_param_handler(Oid vector_oid, Oid halfvec_oid)
+{
+    static VectorParamHandler def_handler = {{
+            (ph_examine)vector_examine,         /* examine */
+            NULL,                               /* total_size */
+            NULL,                               /* encode */
+            (ph_encode_at)vector_encode_at,     /* encode_at */
+            (ph_free)vector_free,               /* free */
+            InvalidOid,                         /* oid */
+            InvalidOid                          /* array_oid */
+        },
+        {NULL},                                 /* values */
+        0,                                      /* dim */
+        InvalidOid,                             /* vector_oid */
+        InvalidOid                              /* halfvec_oid */
+    }; /* static initialized handler */
+    VectorParamHandler *handler;
+
+    handler = (VectorParamHandler *)new_param_handler(
+        (param_handler *)&def_handler, sizeof(VectorParamHandler));
+    if (handler != NULL) {
+        handler->vector_oid = vector_oid;
+        handler->halfvec_oid = halfvec_oid;
+    }
+    return (param_handler *)handler;
+}
@@ -0,0 +1,14 @@
+#ifndef _POQUE_VECTOR_H_
+#define _POQUE_VECTOR_H_
+
+#include "poque_type.h"
+
+param_handler *new_vector_param_handler(Oid vector_oid, Oid halfvec_oid);
+
+extern PoqueValueHandler vector_val_handler;
+extern PoqueValueHandler halfvec_val_handler;
+
+extern PoqueValueHandler vectorarray_val_handler;
+extern PoqueValueHandler halfvecarray_val_handler;
+
+#endif
@@ -268,13 +268,17 @@ class Conn(c_void_p):
     def cursor(self):
         return Cursor(self)
 
-    def commit(self):
+    def _end_transaction(self, end, command, *args, **kwargs):
         if self.transaction_status != TRANS_IDLE:
-            self.execute("COMMIT")
+            self.execute(end)
+        if command is not None:
+            return self.execute(command, *args, **kwargs)
 
-    def rollback(self):
-        if self.transaction_status != TRANS_IDLE:
-            self.execute("ROLLBACK")
+    def commit(self, command=None, *args, **kwargs):
+        return self._end_transaction("COMMIT", command, *args, **kwargs)
+
+    def rollback(self, command=None, *args, **kwargs):
+        return self._end_transaction("ROLLBACK", command, *args, **kwargs)
 
     def execute(self, command, parameters=None, result_format=FORMAT_BINARY):
         command = command.encode()
@@ -316,6 +320,30 @@ class Conn(c_void_p):
         res.conn = self
         return res
 
+    def execute_multi(self, command):
+        pq.PQsendQuery(self, command.encode())
+        results = []
+        error = None
+        # retrieve all results, even after a failure, to make the connection
+        # available for the next statement
+        while True:
+            res = pq.PQgetResult(self)
+            if not res:
+                break
+            res._conn = self
+            if res.status in [BAD_RESPONSE, FATAL_ERROR]:
+                if error is None:
+                    error = res.error_message
+            else:
+                results.append(res)
+            if res.status in [COPY_IN, COPY_OUT, COPY_BOTH]:
+                break
+        if error is not None:
+            raise Error(error)
+        if not results:
+            self._raise_error()
+        return results
+
 
 def check_connect(conn, func, args):
     if conn is None:
@@ -461,6 +489,20 @@ pq.PQexec.argtypes = [Conn, c_char_p]
 pq.PQexec.errcheck = check_exec
 
 
+def check_send(ok, func, args):
+    if not ok:
+        args[0]._raise_error()
+    return ok
+
+
+pq.PQsendQuery.restype = c_int
+pq.PQsendQuery.argtypes = [Conn, c_char_p]
+pq.PQsendQuery.errcheck = check_send
+
+pq.PQgetResult.restype = Result
+pq.PQgetResult.argtypes = [Conn]
+
+
 def check_string_and_free(res, func, args):
     if res is None:
         conn = args[0]
@@ -113,6 +113,8 @@ JSONBOID = 3802
 JSONARRAYOID = 199
 JSONBARRAYOID = 3807
 XMLARRAYOID = 143
+RECORDOID = 2249
+RECORDARRAYOID = 2287
 
 # geometric types
 POINTOID = 600
@@ -127,6 +129,30 @@ BOXARRAYOID = 1020
 POLYGONARRAYOID = 1027
 CIRCLEOID = 718
 CIRCLEARRAYOID = 719
+INT4RANGEOID = 3904
+INT4RANGEARRAYOID = 3905
+NUMRANGEOID = 3906
+NUMRANGEARRAYOID = 3907
+TSRANGEOID = 3908
+TSRANGEARRAYOID = 3909
+TSTZRANGEOID = 3910
+TSTZRANGEARRAYOID = 3911
+DATERANGEOID = 3912
+DATERANGEARRAYOID = 3913
+INT8RANGEOID = 3926
+INT8RANGEARRAYOID = 3927
+INT4MULTIRANGEOID = 4451
+INT4MULTIRANGEARRAYOID = 6150
+NUMMULTIRANGEOID = 4532
+NUMMULTIRANGEARRAYOID = 6151
+TSMULTIRANGEOID = 4533
+TSMULTIRANGEARRAYOID = 6152
+TSTZMULTIRANGEOID = 4534
+TSTZMULTIRANGEARRAYOID = 6153
+DATEMULTIRANGEOID = 4535
+DATEMULTIRANGEARRAYOID = 6155
+INT8MULTIRANGEOID = 4536
+INT8MULTIRANGEARRAYOID = 6157
 LINEOID = 628
 LINEARRAYOID = 629
 
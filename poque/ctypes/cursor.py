@@ -10,6 +10,8 @@ class Cursor():
     def __init__(self, cn):
         self._cn = cn
         self._res = None
+        self._results = None
+        self._res_idx = 0
         self.arraysize = 1
         self._pos = 0
 
@@ -45,7 +47,7 @@ class Cursor():
     def description(self):
         self._check_closed()
         res = self._res
-        if res is None:
+        if res is None or res.nfields == 0:
             return None
 
         def get_field_desc(i):
@@ -69,18 +71,48 @@ class Cursor():
 
         return [get_field_desc(j) for j in range(self._res.nfields)]
 
-    def execute(self, operation, *args, **kwargs):
+    def execute(self, operation, parameters=None,
+                result_format=FORMAT_BINARY):
         self._check_closed()
         cn = self._cn
+        self._res = self._results = None
         if not cn.autocommit and cn.transaction_status == TRANS_IDLE:
             cn.execute("BEGIN")
-        self._res = cn.execute(operation, *args, **kwargs)
+        if not parameters and result_format == FORMAT_TEXT:
+            # plain statements can contain multiple commands, keep all of
+            # their results for nextset
+            self._results = cn.execute_multi(operation)
+        else:
+            self._results = [
+                cn.execute(operation, parameters, result_format)]
+        idx = self._next_set_idx(0)
+        self._set_result(len(self._results) - 1 if idx is None else idx)
+
+    def _next_set_idx(self, idx):
+        for i in range(idx, len(self._results)):
+            if self._results[i].nfields:
+                return i
+        return None
+
+    def _set_result(self, idx):
+        self._res = self._results[idx]
+        self._res_idx = idx
         self._pos = 0
 
+    def nextset(self):
+        self._check_closed()
+        if self._results is None:
+            raise InterfaceError("No result set")
+        idx = self._next_set_idx(self._res_idx + 1)
+        if idx is None:
+            return None
+        self._set_result(idx)
+        return True
+
     def executemany(self, operation, seq_of_parameters, *args, **kwargs):
         for parameters in seq_of_parameters:
             self.execute(operation, parameters, *args, **kwargs)
-        self._res = None
+        self._res = self._results = None
 
     def _check_fetch(self):
         res = self._res
@@ -151,7 +183,7 @@ class Cursor():
     def close(self):
         # not actually closing anything, just removing references
         self._cn = None
-        self._res = None
+        self._res = self._results = None
 
     def setinputsizes(self, *args, **kwargs):
         pass
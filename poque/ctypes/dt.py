@@ -240,7 +240,8 @@ class DateTimeParameterHandler(BaseParameterHandler):
     has_tz = None
 
     def examine(self, val):
-        has_tz = val.tzinfo is not None
+        # like in Python, no UTC offset means naive
+        has_tz = val.utcoffset() is not None
         if self.has_tz is None:
             self.has_tz = has_tz
             if has_tz:
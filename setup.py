@@ -26,6 +26,13 @@ poque_ext = Extension('poque._poque',
                                'extension/datetime.c',
                                'extension/network.c',
                                'extension/geometric.c',
+                               'extension/range.c',
+                               'extension/hstore.c',
+                               'extension/vector.c',
+                               'extension/json.c',
+                               'extension/bitstring.c',
+                               'extension/buffer.c',
+                               'extension/encoded.c',
                                'extension/cursor.c'],
                       depends=['extension/poque.h',
                                'extension/val_crs.h',
@@ -36,6 +43,13 @@ poque_ext = Extension('poque._poque',
                                'extension/datetime.h',
                                'extension/network.h',
                                'extension/geometric.h',
+                               'extension/range.h',
+                               'extension/hstore.h',
+                               'extension/vector.h',
+                               'extension/json.h',
+                               'extension/bitstring.h',
+                               'extension/buffer.h',
+                               'extension/encoded.h',
                                'extension/cursor.h'],
                       include_dirs=[pq_incdir],
                       library_dirs=[pq_libdir],
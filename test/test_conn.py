@@ -89,6 +89,41 @@ class TestConnectionBasic():
         self.cn.execute("BEGIN")
         self.assertEqual(self.cn.transaction_status, self.poque.TRANS_INTRANS)
 
+    def test_commit(self):
+        self.assertIsNone(self.cn.commit())
+        self.cn.execute("BEGIN")
+        self.cn.commit()
+        self.assertEqual(self.cn.transaction_status, self.poque.TRANS_IDLE)
+        self.cn.execute("BEGIN")
+        res = self.cn.commit("SELECT 3")
+        self.assertEqual(res.getvalue(0, 0), 3)
+        self.assertEqual(self.cn.transaction_status, self.poque.TRANS_IDLE)
+        res = self.cn.commit("SELECT $1", [4])
+        self.assertEqual(res.getvalue(0, 0), 4)
+
+        # a failing statement after it does not undo the commit
+        for args in [("SELEC 1",), ("SELEC $1", [4])]:
+            self.cn.execute("BEGIN")
+            self.cn.execute("CREATE TEMPORARY TABLE poque_commit (a int)")
+            with self.assertRaises(self.poque.Error):
+                self.cn.commit(*args)
+            self.assertEqual(
+                self.cn.transaction_status, self.poque.TRANS_IDLE)
+            self.cn.execute("DROP TABLE poque_commit")
+
+    def test_rollback(self):
+        self.assertIsNone(self.cn.rollback())
+        self.cn.execute("BEGIN")
+        with self.assertRaises(self.poque.Error):
+            self.cn.execute("SELECT 1/0")
+        self.assertEqual(self.cn.transaction_status, self.poque.TRANS_INERROR)
+        self.cn.rollback()
+        self.assertEqual(self.cn.transaction_status, self.poque.TRANS_IDLE)
+        self.cn.execute("BEGIN")
+        res = self.cn.rollback("SELECT $1", [5])
+        self.assertEqual(res.getvalue(0, 0), 5)
+        self.assertEqual(self.cn.transaction_status, self.poque.TRANS_IDLE)
+
     def test_server_version(self):
         self.assertIsInstance(self.cn.server_version, int)
 
@@ -143,6 +178,19 @@ class TestConnectionBasic():
         with self.assertRaises(TypeError):
             self.cn.escape_identifier(lit="h'oi")
 
+    def test_execute_multi(self):
+        results = self.cn.execute_multi(
+            "SELECT 1; SET bytea_output=hex; SELECT 'hi'::text, 2")
+        self.assertEqual(len(results), 3)
+        self.assertEqual(results[0].getvalue(0, 0), 1)
+        self.assertEqual(results[1].nfields, 0)
+        self.assertEqual(results[2].getvalue(0, 0), 'hi')
+        self.assertEqual(results[2].getvalue(0, 1), 2)
+        with self.assertRaises(self.poque.Error):
+            self.cn.execute_multi("SELECT 1; SELECT 1/0; SELECT 2")
+        self.assertEqual(
+            self.cn.execute_multi("SELECT 3")[0].getvalue(0, 0), 3)
+
     def test_finish(self):
         self.cn.finish()
         self.assertEqual(self.cn.status, self.poque.CONNECTION_BAD)
@@ -239,6 +287,18 @@ class TestConnectionClosed():
         with self.assertRaises(self.InterfaceError):
             self.cn.execute("SELECT $1", (1,))
 
+    def test_execute_multi(self):
+        with self.assertRaises(self.InterfaceError):
+            self.cn.execute_multi("SELECT 1; SELECT 2")
+
+    def test_commit(self):
+        with self.assertRaises(self.InterfaceError):
+            self.cn.commit()
+
+    def test_rollback(self):
+        with self.assertRaises(self.InterfaceError):
+            self.cn.rollback()
+
     def test_finish(self):
         self.assertEqual(self.cn.status, self.poque.CONNECTION_BAD)
         self.cn.finish()
@@ -122,6 +122,22 @@ class CursorTest():
         with self.assertRaises(self.poque.InterfaceError):
             cr.fetchall()
 
+    def test_fetchall_many_rows(self):
+        cr = self.cn.cursor()
+        query = """
+            SELECT i, i::int8 * 1000000000000, i::float8 / 4, i % 2 = 0,
+                repeat('a', i % 7), 'é' || i, NULLIF(i % 3, 0)
+            FROM generate_series(1, 3000) AS i"""
+        expected = [
+            (i, i * 1000000000000, i / 4, i % 2 == 0, 'a' * (i % 7),
+             'é' + str(i), i % 3 or None)
+            for i in range(1, 3001)]
+        for result_format in (0, 1):
+            cr.execute(query, result_format=result_format)
+            self.assertEqual(cr.fetchmany(5), expected[:5])
+            self.assertEqual(cr.fetchall(), expected[5:])
+            self.assertEqual(cr.rownumber, 3000)
+
     def test_execute_many(self):
         cr = self.cn.cursor()
         cr.execute("CREATE TEMPORARY TABLE ya (val1 int, val2 int)")
@@ -235,6 +251,79 @@ class CursorTest():
         with self.assertRaises(self.poque.InterfaceError):
             cr.scroll(0, "absolute")
 
+    def test_implicit_transaction(self):
+        cn = self.poque.Conn(conninfo())
+        cr = cn.cursor()
+        cr.execute("SELECT 1")
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_INTRANS)
+        cn.rollback()
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_IDLE)
+        cr.execute("SELECT $1", (2,))
+        self.assertEqual(cr.fetchall(), [(2,)])
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_INTRANS)
+        cn.commit()
+        with self.assertRaises(self.poque.Error):
+            cr.execute("SELECT 1/0")
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_INERROR)
+        cn.rollback()
+        with self.assertRaises(self.poque.Error):
+            cr.execute("SELECT 1/0, $1", (2,))
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_INERROR)
+        cn.rollback()
+        cn.autocommit = True
+        cr.execute("SELECT 1")
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_IDLE)
+        cn.finish()
+
+    def test_nextset(self):
+        cr = self.cn.cursor()
+        with self.assertRaises(self.poque.InterfaceError):
+            cr.nextset()
+        cr.execute("""
+            UPDATE pg_database SET datname = datname WHERE false;
+            SELECT 1 UNION SELECT 2;
+            SET bytea_output=hex;
+            SELECT 'hello'::text WHERE false;
+            SELECT 3""", result_format=self.poque.FORMAT_TEXT)
+        self.assertEqual(cr.fetchall(), [(1,), (2,)])
+        self.assertEqual(cr.rowcount, 2)
+        self.assertTrue(cr.nextset())
+        self.assertEqual(cr.fetchall(), [])
+        self.assertTrue(cr.nextset())
+        self.assertEqual(cr.fetchone(), (3,))
+        self.assertIsNone(cr.nextset())
+        cr.execute("SELECT 1", result_format=self.poque.FORMAT_TEXT)
+        self.assertIsNone(cr.nextset())
+        cr.execute("SELECT 1; SELECT 2", [],
+                   result_format=self.poque.FORMAT_TEXT)
+        self.assertEqual(cr.fetchone(), (1,))
+        self.assertTrue(cr.nextset())
+        self.assertEqual(cr.fetchone(), (2,))
+        cr.execute("SET bytea_output=hex; SET bytea_output=escape",
+                   result_format=self.poque.FORMAT_TEXT)
+        self.assertIsNone(cr.description)
+        self.assertIsNone(cr.nextset())
+        cr.close()
+        with self.assertRaises(self.poque.InterfaceError):
+            cr.nextset()
+
+    def test_nextset_implicit_begin(self):
+        # the BEGIN is sent along, its result is not a result set
+        cn = self.poque.Conn(conninfo())
+        cr = cn.cursor()
+        cr.execute("SELECT 1; SELECT 2", result_format=self.poque.FORMAT_TEXT)
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_INTRANS)
+        self.assertEqual(cr.fetchall(), [(1,)])
+        self.assertTrue(cr.nextset())
+        self.assertEqual(cr.fetchall(), [(2,)])
+        self.assertIsNone(cr.nextset())
+        cn.commit()
+        with self.assertRaises(self.poque.Error):
+            cr.execute("SELEC 1; SELECT 2",
+                       result_format=self.poque.FORMAT_TEXT)
+        self.assertEqual(cn.transaction_status, self.poque.TRANS_IDLE)
+        cn.finish()
+
 
 class CursorTestExtension(
         BaseExtensionTest, CursorTest, unittest.TestCase):
@@ -1,6 +1,11 @@
+from array import array
 import datetime
+import json
 from decimal import Decimal
 from ipaddress import IPv4Interface, IPv6Interface, IPv4Network, IPv6Network
+import mmap
+import sys
+import tempfile
 import unittest
 import uuid
 
@@ -83,11 +88,16 @@ class ResultTestParameters():
     def test_str_param(self):
         self._test_param_val('hi')
         self._test_param_val('')
+        self._test_param_val('h\xe9 \u20ac \U0001f600')
+        # Latin-1 only, and non ASCII after the first 16 characters
+        self._test_param_val('\xe9' * 40 + 'x')
+        self._test_param_val('x' * 20 + '\xe9' + 'y' * 3)
 
     def test_str_array_param(self):
         self._test_param_val(['hi', None, 'hello'])
         self._test_param_val(['hi', 'hello'])
         self._test_param_val(['', 'hello'])
+        self._test_param_val(['\xe9' * 40 + 'x', 'x' * 20 + '\xe9'])
 
     def test_float_param(self):
         self._test_param_val(3.24)
@@ -150,6 +160,17 @@ class ResultTestParameters():
         self._test_param_val(datetime.datetime.now(
             datetime.timezone(datetime.timedelta(hours=2))))
 
+    def test_datetime_no_offset_param(self):
+
+        class NoOffset(datetime.tzinfo):
+            def utcoffset(self, dt):
+                return None
+
+        val = datetime.datetime(2020, 1, 1, 12, tzinfo=NoOffset())
+        res = self.cn.execute("SELECT $1", [val])
+        self.assertEqual(res.ftype(0), self.poque.TIMESTAMPOID)
+        self.assertEqual(res.getvalue(0, 0), val.replace(tzinfo=None))
+
     def test_datetime_mixed_array_param(self):
         with self.assertRaises(ValueError):
             self.cn.execute("SELECT $1", ([
@@ -279,7 +300,293 @@ class ResultTestParameters():
 
 class ResultTestParametersExtension(
         BaseExtensionTest, ResultTestParameters, unittest.TestCase):
-    pass
+
+    def test_dict_param(self):
+        val = {'hi': [1, 2.5, None, True], 'ü': {'"': '\n'}}
+        res = self.cn.execute("SELECT $1", [val])
+        self.assertEqual(res.ftype(0), self.poque.JSONBOID)
+        self.assertEqual(res.getvalue(0, 0), val)
+
+    def test_dict_array_param(self):
+        self._test_param_val([{'hi': 1}, None, {}])
+
+    def test_json_param(self):
+        res = self.cn.execute("SELECT $1", [self.poque.Json([1, 'hi'])])
+        self.assertEqual(res.ftype(0), self.poque.JSONBOID)
+        self.assertEqual(res.getvalue(0, 0), [1, 'hi'])
+
+        res = self.cn.execute(
+            "SELECT $1", [self.poque.Json([1], dumps=json.dumps)])
+        self.assertEqual(res.getvalue(0, 0), [1])
+
+        with self.assertRaises(TypeError):
+            self.cn.execute("SELECT $1", [{'hi': object()}])
+        with self.assertRaises(ValueError):
+            self.cn.execute("SELECT $1", [{'hi': float('nan')}])
+
+    def test_bitstring_param(self):
+        val = self.poque.BitString('1011001110')
+        res = self.cn.execute("SELECT $1, $1 & B'1111100000'", [val])
+        self.assertEqual(res.ftype(0), self.poque.VARBITOID)
+        self.assertEqual(res.getvalue(0, 0), 0b1011001110)
+        self.assertEqual(res.getvalue(0, 1), 0b1011000000)
+        self.assertEqual(
+            val & self.poque.BitString('1111100000'),
+            self.poque.BitString('1011000000'))
+
+    def test_range_param(self):
+        Range = self.poque.Range
+        res = self.cn.execute(
+            "SELECT $1, $1 @> 3, $2, $3, $4",
+            [Range(1, 5), Range(None, 2 ** 40, '(]'), Range(empty=True),
+             [Range(Decimal('1.5'), Decimal(2)), None]])
+        self.assertEqual(res.ftype(0), self.poque.INT4RANGEOID)
+        self.assertEqual(res.getvalue(0, 0), Range(1, 5))
+        self.assertTrue(res.getvalue(0, 1))
+        self.assertEqual(res.ftype(2), self.poque.INT8RANGEOID)
+        self.assertEqual(res.getvalue(0, 2), Range(None, 2 ** 40 + 1))
+        self.assertTrue(res.getvalue(0, 3).isempty)
+        self.assertEqual(res.ftype(4), self.poque.NUMRANGEARRAYOID)
+        self.assertEqual(
+            res.getvalue(0, 4), [Range(Decimal('1.5'), Decimal(2)), None])
+
+        with self.assertRaises(ValueError):
+            self.cn.execute("SELECT $1", [Range(1, Decimal(2))])
+        with self.assertRaises(ValueError):
+            Range(1, 2, '[[')
+
+    def test_hstore_param(self):
+        try:
+            self.cn.execute("CREATE EXTENSION IF NOT EXISTS hstore")
+        except self.poque.Error:
+            self.skipTest("hstore extension not available")
+        self.cn.register_hstore()
+        val = {'a': '1', 'b c': None, 'ü': 'x"y', '': ''}
+        res = self.cn.execute("SELECT $1, $1 -> 'a'", [val])
+        self.assertEqual(res.getvalue(0, 0), val)
+        self.assertEqual(res.getvalue(0, 1), '1')
+        encoded = self.cn.encode(val)
+        self.assertEqual(encoded.oid, res.ftype(0))
+        res = self.cn.execute("SELECT $1", [encoded])
+        self.assertEqual(res.getvalue(0, 0), val)
+        self.assertEqual(self.poque.Encoded(val).oid, self.poque.JSONBOID)
+
+        # dicts in lists too
+        res = self.cn.execute("SELECT $1, $1[1] -> 'a'", [[val, None]])
+        self.assertEqual(res.getvalue(0, 0), [val, None])
+        self.assertEqual(res.getvalue(0, 1), '1')
+
+        # json values need a wrapper now
+        res = self.cn.execute("SELECT $1", [self.poque.Json({'a': 1})])
+        self.assertEqual(res.getvalue(0, 0), {'a': 1})
+        with self.assertRaises(TypeError):
+            self.cn.execute("SELECT $1", [{'a': 1}])
+
+    def test_vector_param(self):
+        try:
+            self.cn.execute("CREATE EXTENSION IF NOT EXISTS vector")
+        except self.poque.Error:
+            self.skipTest("vector extension not available")
+        Vector = self.poque.Vector
+        val = Vector(array('f', [1, 2.5, -3]))
+
+        # the type is inferred by the server before registration
+        res = self.cn.execute("SELECT $1 <-> '[1,2.5,-2]'::vector", [val])
+        self.assertEqual(res.getvalue(0, 0), 1)
+
+        self.cn.register_vector()
+        res = self.cn.execute("SELECT $1, $2", [val, Vector([0.5, 1])])
+        self.assertEqual(memoryview(res.getvalue(0, 0)).tolist(), [1, 2.5, -3])
+        self.assertEqual(memoryview(res.getvalue(0, 1)).tolist(), [0.5, 1])
+        if self.cn.execute(
+                "SELECT to_regtype('halfvec') IS NOT NULL").getvalue(0, 0):
+            res = self.cn.execute("SELECT $1", [Vector([0.5, 1], half=True)])
+            val = res.getvalue(0, 0)
+            self.assertTrue(val.half)
+            self.assertEqual(memoryview(val).tolist(), [0.5, 1])
+        else:
+            with self.assertRaises(self.poque.Error):
+                self.cn.execute("SELECT $1", [Vector([0.5, 1], half=True)])
+
+        # only the connection knows the vector oid
+        res = self.cn.execute("SELECT $1", [self.cn.encode(val)])
+        self.assertEqual(memoryview(res.getvalue(0, 0)).tolist(), [1, 2.5, -3])
+        with self.assertRaises(TypeError):
+            self.poque.Encoded(val)
+
+        with self.assertRaises(TypeError):
+            Vector(['a'])
+        with self.assertRaises(ValueError):
+            Vector(b'abcd')
+        with self.assertRaises(ValueError):
+            Vector(array('d', [1, 2]))
+
+    def test_long_list_param(self):
+        val = list(range(300000))
+        val[7] = None
+        res = self.cn.execute(
+            "SELECT cardinality($1), $1[8], $1[300000]", [val])
+        self.assertEqual(res.getvalue(0, 0), 300000)
+        self.assertIsNone(res.getvalue(0, 1))
+        self.assertEqual(res.getvalue(0, 2), 299999)
+
+        val = [str(i) for i in range(300000)]
+        res = self.cn.execute("SELECT $1[300000]", [val])
+        self.assertEqual(res.getvalue(0, 0), '299999')
+
+    def test_flat_list_param(self):
+        # every list encoder, with and without NULLs
+        vals = [
+            [1.5, None, -2.25, float('inf')],
+            [True, None, False],
+            ['a', None, '', 'h\xe9 \u20ac'],
+            [uuid.uuid4(), None, uuid.uuid4()],
+        ]
+        for val in vals:
+            res = self.cn.execute("SELECT $1, $2", [val, val[:1] + val[2:]])
+            self.assertEqual(res.getvalue(0, 0), val)
+            self.assertEqual(res.getvalue(0, 1), val[:1] + val[2:])
+        res = self.cn.execute("SELECT $1", [[None, True]])
+        self.assertEqual(res.ftype(0), self.poque.BOOLARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [None, True])
+
+    def test_str_param_not_cached(self):
+        # non ASCII str values do not get a cached UTF-8 copy
+        val = 'caf\xe9 \u20ac' * 20
+        size = sys.getsizeof(val)
+        res = self.cn.execute("SELECT $1, $2", [val, [val, None]])
+        self.assertEqual(res.getvalue(0, 0), val)
+        self.assertEqual(res.getvalue(0, 1), [val, None])
+        self.assertEqual(sys.getsizeof(val), size)
+        res = self.cn.execute("SELECT $1", [self.poque.Json({val: [val]})])
+        self.assertEqual(res.getvalue(0, 0), {val: [val]})
+        self.assertEqual(sys.getsizeof(val), size)
+
+        with self.assertRaises(UnicodeEncodeError):
+            self.cn.execute("SELECT $1", ['\ud800'])
+
+    def test_encoded_param(self):
+        val = self.poque.Encoded(list(range(1000)))
+        self.assertEqual(val.oid, self.poque.INT4ARRAYOID)
+        self.assertEqual(val.format, 1)
+        self.assertIs(self.poque.Encoded(val), val)
+        for i in range(3):
+            res = self.cn.execute("SELECT $1[1000], $2", [val, i])
+            self.assertEqual(res.ftype(0), self.poque.INT4OID)
+            self.assertEqual(res.getvalue(0, 0), 999)
+
+        val = self.cn.encode({'filter': ['a', 'b']})
+        self.assertIsInstance(val, self.poque.Encoded)
+        res = self.cn.execute("SELECT $1", [val])
+        self.assertEqual(res.ftype(0), self.poque.JSONBOID)
+        self.assertEqual(res.getvalue(0, 0), {'filter': ['a', 'b']})
+
+        res = self.cn.execute(
+            "SELECT $1", [[self.cn.encode('a'), None, self.cn.encode('b')]])
+        self.assertEqual(res.getvalue(0, 0), ['a', None, 'b'])
+
+        with self.assertRaises(TypeError):
+            self.poque.Encoded(None)
+        with self.assertRaises(ValueError):
+            self.poque.Encoded([self.cn.encode(1), self.cn.encode('a')])
+
+    def test_buffer_array_param(self):
+        res = self.cn.execute("SELECT $1", [array('i', [1, -2, 3])])
+        self.assertEqual(res.ftype(0), self.poque.INT4ARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [1, -2, 3])
+
+        res = self.cn.execute("SELECT $1", [array('q', [2 ** 40])])
+        self.assertEqual(res.ftype(0), self.poque.INT8ARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [2 ** 40])
+
+        res = self.cn.execute("SELECT $1", [array('d', [1.5, -2.25])])
+        self.assertEqual(res.ftype(0), self.poque.FLOAT8ARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [1.5, -2.25])
+
+        val = memoryview(array('h', range(6))).cast('B').cast('h', (2, 3))
+        res = self.cn.execute("SELECT $1", [val])
+        self.assertEqual(res.ftype(0), self.poque.INT2ARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [[0, 1, 2], [3, 4, 5]])
+
+        res = self.cn.execute("SELECT $1", [array('f')])
+        self.assertEqual(res.ftype(0), self.poque.FLOAT4ARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [])
+
+        val = self.poque.MaskedArray(array('i', [1, 2, 3]), bytes([0, 1, 0]))
+        res = self.cn.execute("SELECT $1", [val])
+        self.assertEqual(res.getvalue(0, 0), [1, None, 3])
+
+        with self.assertRaises(ValueError):
+            self.cn.execute("SELECT $1", [array('H', [1])])
+        with self.assertRaises(ValueError):
+            self.cn.execute(
+                "SELECT $1", [self.poque.MaskedArray(array('i', [1]), b'')])
+        with self.assertRaises(BufferError):
+            self.cn.execute("SELECT $1", [memoryview(array('i', [1, 2]))[::2]])
+
+    def test_buffer_bytea_param(self):
+        self._test_param_val(bytearray(b'hoi'), memoryview)
+        self._test_param_val(memoryview(b'hoi'))
+        self._test_param_val(memoryview(b''))
+
+        with tempfile.TemporaryFile() as f:
+            f.write(b'\x00mapped\xff')
+            f.flush()
+            with mmap.mmap(f.fileno(), 0) as val:
+                res = self.cn.execute("SELECT $1", [val])
+                self.assertEqual(res.ftype(0), self.poque.BYTEAOID)
+                self.assertEqual(res.getvalue(0, 0), b'\x00mapped\xff')
+
+        res = self.cn.execute(
+            "SELECT $1", [[bytearray(b'a'), None, bytearray(b'bc')]])
+        self.assertEqual(res.ftype(0), self.poque.BYTEAARRAYOID)
+        self.assertEqual(res.getvalue(0, 0), [b'a', None, b'bc'])
+
+    def test_array_buffer_param(self):
+        self.cn.array_as = 'buffer'
+        try:
+            res = self.cn.execute(
+                "SELECT '{{1.5,2},{3,4}}'::float8[]", result_format=1)
+            val = res.getvalue(0, 0)
+            res = self.cn.execute("SELECT $1", [val], result_format=1)
+            self.assertEqual(res.getvalue(0, 0).tolist(), val.tolist())
+        finally:
+            self.cn.array_as = 'list'
+
+    def test_geometry_param(self):
+        points = array('d', [1.5, 2, 3, 4.5, -1, 0])
+        res = self.cn.execute(
+            "SELECT $1::text, $2::text, $3::text",
+            [self.poque.Polygon(points), self.poque.Path(points),
+             self.poque.Path(points, closed=True)])
+        self.assertEqual(res.ftype(0), self.poque.TEXTOID)
+        self.assertEqual(res.getvalue(0, 0), '((1.5,2),(3,4.5),(-1,0))')
+        self.assertEqual(res.getvalue(0, 1), '[(1.5,2),(3,4.5),(-1,0)]')
+        self.assertEqual(res.getvalue(0, 2), '((1.5,2),(3,4.5),(-1,0))')
+        res = self.cn.execute("SELECT $1", [[self.poque.Polygon(points)]])
+        self.assertEqual(res.ftype(0), self.poque.POLYGONARRAYOID)
+
+        with self.assertRaises(ValueError):
+            self.poque.Polygon(array('f', [1, 2]))
+        with self.assertRaises(ValueError):
+            self.poque.Path(array('d', [1, 2, 3]))
+
+        # round trip without objects per point
+        self.cn.geometry_as = 'buffer'
+        try:
+            res = self.cn.execute(
+                "SELECT $1, $2", [self.poque.Polygon(points),
+                                  self.poque.Path(points, closed=True)])
+            val = res.getvalue(0, 0)
+            self.assertIsInstance(val, self.poque.Polygon)
+            self.assertEqual(
+                memoryview(val).tolist(), [[1.5, 2], [3, 4.5], [-1, 0]])
+            val = res.getvalue(0, 1)
+            self.assertTrue(val.closed)
+            self.assertEqual(
+                val.points.tolist(), [[1.5, 2], [3, 4.5], [-1, 0]])
+        finally:
+            self.cn.geometry_as = 'tuple'
 
 
 class ResultTestParametersCtypes(
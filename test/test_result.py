@@ -1,6 +1,8 @@
+from array import array
 import datetime
 from decimal import Decimal
 from ipaddress import IPv4Interface, IPv6Interface, IPv4Network, IPv6Network
+import math
 import sys
 import unittest
 import weakref
@@ -380,6 +382,14 @@ class ResultTestValues():
         res = self.cn.execute(r"SELECT 'hoi \001'::bytea", result_format=0)
         self.assertEqual(res.getvalue(0, 0), b'hoi \x01')
 
+    def test_long_bytea_value_str(self):
+        # long enough for the bulk decoding paths
+        val = bytes(range(256)) * 40 + b'\\x'
+        for output in ('hex', 'escape'):
+            self.cn.execute("SET bytea_output TO {}".format(output))
+            res = self.cn.execute("SELECT $1", [val], result_format=0)
+            self.assertEqual(res.getvalue(0, 0), val)
+
     def test_bytea_value_bin(self):
         self._test_value_and_type_bin("SELECT 'hi'::bytea", b'hi',
                                       self.poque.BYTEAOID)
@@ -1242,12 +1252,445 @@ class ResultTestValues():
 class ResultTestValuesExtension(
         BaseExtensionTest, ResultTestValues, unittest.TestCase):
 
+    @unittest.skipIf(sys.version_info < (3, 9), "zoneinfo not available")
+    def test_timestamptz_session_timezone(self):
+        from zoneinfo import ZoneInfo
+        self.cn.execute("SET TimeZone TO 'Europe/Amsterdam'")
+        self.cn.session_timezone = True
+        try:
+            res = self.cn.execute(
+                "SELECT '2014-07-01 12:00+00'::timestamptz", result_format=1)
+            val = res.getvalue(0, 0)
+        finally:
+            self.cn.session_timezone = False
+        self.assertEqual(val, datetime.datetime(
+            2014, 7, 1, 14, tzinfo=ZoneInfo('Europe/Amsterdam')))
+        self.assertEqual(val.utcoffset(), datetime.timedelta(hours=2))
+
+    def test_timestamp_value_str(self):
+        self._test_value_and_type_str(
+            "SELECT '2013-04-02 13:09:25.123'::timestamp",
+            datetime.datetime(2013, 4, 2, 13, 9, 25, 123000),
+            self.poque.TIMESTAMPOID)
+        self._test_value_and_type_str(
+            "SELECT '500-04-02 13:09:25.123 BC'::timestamp",
+            "0500-04-02 13:09:25.123 BC", self.poque.TIMESTAMPOID)
+        self._test_value_and_type_str(
+            "SELECT '20130-04-02 13:09:25.123'::timestamp",
+            "20130-04-02 13:09:25.123", self.poque.TIMESTAMPOID)
+        self._test_value_and_type_str(
+            "SELECT '-infinity'::timestamp", "-infinity",
+            self.poque.TIMESTAMPOID)
+
+    def test_timestamp_array_value_str(self):
+        self._test_value_and_type_str(
+            "SELECT ARRAY['2013-04-02 13:09:25.123'::timestamp, NULL]",
+            [datetime.datetime(2013, 4, 2, 13, 9, 25, 123000), None],
+            self.poque.TIMESTAMPARRAYOID)
+
+    def test_timestamptz_value_str(self):
+        self.cn.execute("SET TimeZone TO 'Asia/Kolkata'")
+        self._test_value_and_type_str(
+            "SELECT '2013-04-02 13:09:25.5 +3'::timestamptz",
+            datetime.datetime(
+                2013, 4, 2, 10, 9, 25, 500000, tzinfo=datetime.timezone.utc),
+            self.poque.TIMESTAMPTZOID)
+        self._test_value_and_type_str(
+            "SELECT '-infinity'::timestamptz", '-infinity',
+            self.poque.TIMESTAMPTZOID)
+
+    def test_timetz_value_str(self):
+        self._test_value_and_type_str(
+            "SELECT '14:12+00:30'::timetz",
+            datetime.time(14, 12, tzinfo=datetime.timezone(
+                datetime.timedelta(seconds=1800))),
+            self.poque.TIMETZOID)
+        self._test_value_and_type_str(
+            "SELECT '14:12-04:00'::timetz",
+            datetime.time(14, 12, tzinfo=datetime.timezone(
+                datetime.timedelta(hours=-4))),
+            self.poque.TIMETZOID)
+        self._test_value_and_type_str(
+            "SELECT '14:02:10.12-00:30:30'::timetz",
+            '14:02:10.12-00:30:30', self.poque.TIMETZOID)
+
+    def test_interval_value_str(self):
+        self._test_value_and_type_str(
+            "SELECT '1 century 4 month 2 days 3 hour'::interval;",
+            (1204, datetime.timedelta(days=2, hours=3)),
+            self.poque.INTERVALOID)
+        self._test_value_and_type_str(
+            "SELECT '1 century 4 month 2 days 3 hour ago'::interval;",
+            (-1204, datetime.timedelta(days=-2, hours=-3)),
+            self.poque.INTERVALOID)
+        self._test_value_and_type_str(
+            "SELECT '1 day -90 minutes 0.25 seconds'::interval;",
+            (0, datetime.timedelta(days=1, minutes=-90, seconds=0.25)),
+            self.poque.INTERVALOID)
+
+    def test_interval_value_str_other_style(self):
+        self.cn.execute("SET IntervalStyle TO iso_8601")
+        self._test_value_and_type_str(
+            "SELECT '1 year 2 days'::interval;", 'P1Y2D',
+            self.poque.INTERVALOID)
+
+    def test_date_memo_value_bin(self):
+        res = self.cn.execute(
+            """SELECT '2014-03-01'::date + i % 2,
+                      '2014-03-01 12:00'::timestamp + i * interval '1 s'
+               FROM generate_series(0, 999) AS i""", result_format=1)
+        dates = [res.getvalue(i, 0) for i in range(1000)]
+        self.assertEqual(dates, [datetime.date(2014, 3, 1 + i % 2)
+                                 for i in range(1000)])
+        # few distinct values, the same objects are returned
+        self.assertIs(dates[0], dates[2])
+        self.assertEqual(
+            [res.getvalue(i, 1) for i in range(1000)],
+            [datetime.datetime(2014, 3, 1, 12) + datetime.timedelta(seconds=i)
+             for i in range(1000)])
+
+    def test_uuid_as(self):
+        val = uuid4()
+        self.assertEqual(self.cn.uuid_as, 'uuid')
+        for uuid_as, exp in [
+                ('bytes', val.bytes), ('int', val.int), ('str', str(val))]:
+            self.cn.uuid_as = uuid_as
+            try:
+                for fmt in (0, 1):
+                    res = self.cn.execute(
+                        "SELECT '{0}'::uuid".format(val), result_format=fmt)
+                    self.assertEqual(res.getvalue(0, 0), exp)
+            finally:
+                self.cn.uuid_as = 'uuid'
+        with self.assertRaises(ValueError):
+            self.cn.uuid_as = 'hex'
+
+    def test_numeric_as(self):
+        command = ("SELECT '123.450'::numeric, '-123456789012345678901234'"
+                   "::numeric, '9990E+2'::numeric, 'NaN'::numeric")
+        self.assertEqual(self.cn.numeric_as, 'decimal')
+        for fmt in (0, 1):
+            try:
+                self.cn.numeric_as = 'int'
+                res = self.cn.execute(command, result_format=fmt)
+                self.assertEqual(res.getvalue(0, 0), Decimal('123.450'))
+                val = res.getvalue(0, 1)
+                self.assertEqual(val, -123456789012345678901234)
+                self.assertIsInstance(val, int)
+                self.assertEqual(res.getvalue(0, 2), 999000)
+                self.assertTrue(res.getvalue(0, 3).is_nan())
+
+                self.cn.numeric_as = 'float'
+                res = self.cn.execute(command, result_format=fmt)
+                self.assertEqual(res.getvalue(0, 0), 123.45)
+                self.assertEqual(res.getvalue(0, 1), -1.2345678901234568e+23)
+                self.assertEqual(res.getvalue(0, 2), 999000.0)
+                self.assertTrue(math.isnan(res.getvalue(0, 3)))
+            finally:
+                self.cn.numeric_as = 'decimal'
+        with self.assertRaises(ValueError):
+            self.cn.numeric_as = 'str'
+
+    def test_json_as(self):
+        command = "SELECT '{\"hi\": 23}'::jsonb"
+        self.assertEqual(self.cn.json_as, 'object')
+        try:
+            self.cn.json_as = 'str'
+            res = self.cn.execute(command, result_format=1)
+            self.assertEqual(res.getvalue(0, 0), '{"hi": 23}')
+            self.cn.json_as = 'bytes'
+            res = self.cn.execute(command, result_format=0)
+            self.assertEqual(res.getvalue(0, 0), b'{"hi": 23}')
+            self.cn.json_as = 'lazy'
+            res = self.cn.execute(command, result_format=1)
+            val = res.getvalue(0, 0)
+            self.assertIsInstance(val, self.poque.JsonValue)
+            self.assertEqual(val.raw, b'{"hi": 23}')
+            self.assertEqual(val['hi'], 23)
+            self.assertEqual(val.value, {'hi': 23})
+        finally:
+            self.cn.json_as = 'object'
+
+    def test_json_loads(self):
+        loaded = []
+
+        def loads(val):
+            loaded.append(val)
+            return {}
+
+        self.assertIsNone(self.cn.json_loads)
+        self.cn.json_loads = loads
+        try:
+            res = self.cn.execute("SELECT '{\"hi\": 23}'::jsonb")
+            self.assertEqual(res.getvalue(0, 0), {})
+        finally:
+            self.cn.json_loads = None
+        self.assertEqual(loaded, [b'{"hi": 23}'])
+        with self.assertRaises(TypeError):
+            self.cn.json_loads = 'loads'
+
+    def test_bit_as(self):
+        self.assertEqual(self.cn.bit_as, 'int')
+        self.cn.bit_as = 'bitstring'
+        try:
+            for fmt in (0, 1):
+                res = self.cn.execute(
+                    "SELECT B'1011001110'::varbit", result_format=fmt)
+                val = res.getvalue(0, 0)
+                self.assertIsInstance(val, self.poque.BitString)
+                self.assertEqual(str(val), '1011001110')
+                self.assertEqual(len(val), 10)
+                self.assertEqual(int(val), 0b1011001110)
+                self.assertEqual(val.popcount(), 6)
+                self.assertEqual(bytes(val), b'\xb3\x80')
+        finally:
+            self.cn.bit_as = 'int'
+
+    def test_array_as(self):
+        self.assertEqual(self.cn.array_as, 'list')
+        with self.assertRaises(ValueError):
+            self.cn.array_as = 'tuple'
+        self.cn.array_as = 'buffer'
+        try:
+            res = self.cn.execute(
+                "SELECT '{{1,2,3},{4,5,6}}'::int4[], '{1.5,-2}'::float8[], "
+                "'{}'::int8[], '{1,NULL}'::int4[], '{a}'::text[]",
+                result_format=1)
+            val = res.getvalue(0, 0)
+            self.assertIsInstance(val, self.poque.ArrayBuffer)
+            self.assertEqual(val.shape, (2, 3))
+            self.assertEqual(val.format, 'i')
+            self.assertEqual(val.tolist(), [[1, 2, 3], [4, 5, 6]])
+            view = memoryview(val)
+            self.assertEqual(view.shape, (2, 3))
+            self.assertTrue(view.readonly)
+
+            # a plain buffer request can not describe two dimensions
+            with self.assertRaises(TypeError):
+                b''.join([val])
+            val = res.getvalue(0, 1)
+            self.assertEqual(array('d', val), array('d', [1.5, -2]))
+            self.assertEqual(len(b''.join([val])), 16)
+            val = res.getvalue(0, 2)
+            self.assertEqual((val.format, val.shape), ('q', (0,)))
+
+            # NULLs and variable width items still give lists
+            self.assertEqual(res.getvalue(0, 3), [1, None])
+            self.assertEqual(res.getvalue(0, 4), ['a'])
+        finally:
+            self.cn.array_as = 'list'
+
+    def test_geometry_as(self):
+        self.assertEqual(self.cn.geometry_as, 'tuple')
+        with self.assertRaises(ValueError):
+            self.cn.geometry_as = 'list'
+        self.cn.geometry_as = 'buffer'
+        try:
+            res = self.cn.execute(
+                "SELECT '((1.3, 3.45), (2, 5.6), (-1.3, -4))'::polygon, "
+                "'[(1.3, 3.45), (2, 5.6)]'::path, "
+                "'((1.3, 3.45))'::path, '(1, 2)'::point",
+                result_format=1)
+            val = res.getvalue(0, 0)
+            self.assertIsInstance(val, self.poque.Polygon)
+            self.assertEqual(len(val), 3)
+            view = memoryview(val)
+            self.assertEqual((view.format, view.shape), ('d', (3, 2)))
+            self.assertEqual(
+                view.tolist(), [[1.3, 3.45], [2, 5.6], [-1.3, -4]])
+            val = res.getvalue(0, 1)
+            self.assertIsInstance(val, self.poque.Path)
+            self.assertFalse(val.closed)
+            self.assertEqual(val.points.tolist(), [[1.3, 3.45], [2, 5.6]])
+            self.assertTrue(res.getvalue(0, 2).closed)
+
+            # other geometric types are not affected
+            self.assertEqual(res.getvalue(0, 3), (1, 2))
+        finally:
+            self.cn.geometry_as = 'tuple'
+
+    def test_inet_attributes(self):
+        # values are created without the ipaddress constructors
+        for fmt in (0, 1):
+            res = self.cn.execute(
+                "SELECT '192.168.10.1/24'::inet, '192.168.10.0/31'::cidr, "
+                "'2001:db8::1'::inet, '2001:db8::/128'::cidr",
+                result_format=fmt)
+            for val, expected in zip(res[0], [
+                    IPv4Interface('192.168.10.1/24'),
+                    IPv4Network('192.168.10.0/31'),
+                    IPv6Interface('2001:db8::1'),
+                    IPv6Network('2001:db8::/128')]):
+                self.assertEqual(val, expected)
+                self.assertEqual(str(val), str(expected))
+                self.assertEqual(hash(val), hash(expected))
+                self.assertEqual(sorted(vars(val)), sorted(vars(expected)))
+                if isinstance(val, (IPv4Network, IPv6Network)):
+                    self.assertEqual(list(val.hosts()),
+                                     list(expected.hosts()))
+                else:
+                    self.assertEqual(val.network, expected.network)
+                    self.assertEqual(val.ip, expected.ip)
+
+    def test_record_value_bin(self):
+        res = self.cn.execute(
+            "SELECT ROW(1, 'a'::text, NULL::int4), "
+            "ROW(ROW(2, true), ARRAY[3, NULL]), "
+            "ARRAY[ROW(4, 'b'::text), NULL], ROW()",
+            result_format=1)
+        self.assertEqual(res.ftype(0), self.poque.RECORDOID)
+        self.assertEqual(res.getvalue(0, 0), (1, 'a', None))
+        self.assertEqual(res.getvalue(0, 1), ((2, True), [3, None]))
+        self.assertEqual(res.ftype(2), self.poque.RECORDARRAYOID)
+        self.assertEqual(res.getvalue(0, 2), [(4, 'b'), None])
+        self.assertEqual(res.getvalue(0, 3), ())
+
+    def test_register_composite(self):
+        self.cn.execute(
+            "CREATE TYPE pg_temp.poque_point AS (x int4, label text)")
+        self.cn.execute(
+            "CREATE TYPE pg_temp.poque_shape AS "
+            "(origin pg_temp.poque_point, class text)")
+
+        # the oid alone does not tell it is a composite type
+        res = self.cn.execute(
+            "SELECT ROW(1, 'a')::pg_temp.poque_point", result_format=1)
+        self.assertIsInstance(res.getvalue(0, 0), memoryview)
+
+        point_type = self.cn.register_composite('pg_temp.poque_point')
+        self.assertEqual(point_type._fields, ('x', 'label'))
+        shape_type = self.cn.register_composite('pg_temp.poque_shape')
+        self.assertEqual(shape_type._fields, ('origin', '_1'))
+        res = self.cn.execute(
+            "SELECT ROW(ROW(1, 'a'), 'b')::pg_temp.poque_shape, "
+            "ARRAY[ROW(2, NULL)::pg_temp.poque_point], "
+            "ROW(ROW(3, 'c')::pg_temp.poque_point)",
+            result_format=1)
+        val = res.getvalue(0, 0)
+        self.assertIsInstance(val, shape_type)
+        self.assertIsInstance(val.origin, point_type)
+        self.assertEqual(val, ((1, 'a'), 'b'))
+        self.assertEqual(res.getvalue(0, 1), [point_type(2, None)])
+        self.assertIsInstance(res.getvalue(0, 2)[0], point_type)
+
+        # text values are not affected
+        res = self.cn.execute(
+            "SELECT ROW(1, 'a')::pg_temp.poque_point", result_format=0)
+        self.assertEqual(res.getvalue(0, 0), '(1,a)')
+
+        with self.assertRaises(self.poque.Error):
+            self.cn.register_composite('int4')
+
+    def test_range_value(self):
+        Range = self.poque.Range
+        for fmt in (0, 1):
+            res = self.cn.execute(
+                "SELECT int4range(1, 5), '(,7]'::int8range, "
+                "'empty'::numrange, '[1.5,)'::numrange, "
+                "daterange('2020-01-01', '2021-01-01'), "
+                "ARRAY[int4range(1, 3), NULL]",
+                result_format=fmt)
+            self.assertEqual(res.ftype(0), self.poque.INT4RANGEOID)
+            self.assertEqual(res.getvalue(0, 0), Range(1, 5))
+            val = res.getvalue(0, 1)
+            self.assertEqual(val, Range(None, 8, '()'))
+            self.assertTrue(val.lower_inf)
+            self.assertFalse(val.upper_inc)
+            val = res.getvalue(0, 2)
+            self.assertTrue(val.isempty)
+            self.assertFalse(val)
+            self.assertEqual(
+                res.getvalue(0, 3), Range(Decimal('1.5'), None, '[)'))
+            self.assertEqual(
+                res.getvalue(0, 4),
+                Range(datetime.date(2020, 1, 1), datetime.date(2021, 1, 1)))
+            self.assertEqual(res.ftype(5), self.poque.INT4RANGEARRAYOID)
+            self.assertEqual(res.getvalue(0, 5), [Range(1, 3), None])
+
+    def test_multirange_value(self):
+        if self.cn.server_version < 140000:
+            self.skipTest("multiranges require PostgreSQL 14")
+        Range = self.poque.Range
+        for fmt in (0, 1):
+            res = self.cn.execute(
+                "SELECT '{[1,3), [5,)}'::int4multirange, "
+                "'{}'::datemultirange",
+                result_format=fmt)
+            self.assertEqual(res.ftype(0), self.poque.INT4MULTIRANGEOID)
+            self.assertEqual(res.getvalue(0, 0), [Range(1, 3), Range(5)])
+            self.assertEqual(res.getvalue(0, 1), [])
+
+    def test_hstore_value(self):
+        try:
+            self.cn.execute("CREATE EXTENSION IF NOT EXISTS hstore")
+        except self.poque.Error:
+            self.skipTest("hstore extension not available")
+        self.cn.register_hstore()
+        for fmt in (0, 1):
+            res = self.cn.execute(
+                """SELECT 'a=>1, "b c"=>NULL, ü=>"x\\"y"'::hstore, """
+                "''::hstore, ARRAY['k=>v'::hstore, NULL]",
+                result_format=fmt)
+            self.assertEqual(
+                res.getvalue(0, 0), {'a': '1', 'b c': None, 'ü': 'x"y'})
+            self.assertEqual(res.getvalue(0, 1), {})
+            self.assertEqual(res.getvalue(0, 2), [{'k': 'v'}, None])
+
+        with self.assertRaises(self.poque.Error):
+            self.cn.register_hstore('int4')
+
+    def test_vector_value(self):
+        try:
+            self.cn.execute("CREATE EXTENSION IF NOT EXISTS vector")
+        except self.poque.Error:
+            self.skipTest("vector extension not available")
+        self.cn.register_vector()
+        for fmt in (0, 1):
+            res = self.cn.execute(
+                "SELECT '[1,2.5,-3]'::vector, ARRAY['[0.5]'::vector, NULL]",
+                result_format=fmt)
+            val = res.getvalue(0, 0)
+            self.assertIsInstance(val, self.poque.Vector)
+            self.assertFalse(val.half)
+            self.assertEqual(len(val), 3)
+            self.assertEqual(memoryview(val).tolist(), [1, 2.5, -3])
+            val = res.getvalue(0, 1)
+            self.assertEqual(memoryview(val[0]).tolist(), [0.5])
+            self.assertIsNone(val[1])
+
+    def test_inet_as(self):
+        self.assertEqual(self.cn.inet_as, 'ipaddress')
+        with self.assertRaises(ValueError):
+            self.cn.inet_as = 'str'
+        self.cn.inet_as = 'raw'
+        try:
+            for fmt in (0, 1):
+                res = self.cn.execute(
+                    "SELECT '192.168.10.1/24'::inet, "
+                    "'2001:db8::/32'::cidr, "
+                    "ARRAY['10.0.0.1'::inet]",
+                    result_format=fmt)
+                self.assertEqual(res.getvalue(0, 0), (4, 0xC0A80A01, 24))
+                self.assertEqual(
+                    res.getvalue(0, 1), (6, 0x20010DB8 << 96, 32))
+                self.assertEqual(res.getvalue(0, 2), [(4, 0x0A000001, 32)])
+        finally:
+            self.cn.inet_as = 'ipaddress'
+
     def test_int4_array_value_text(self):
         self._test_value_and_type_str(
             "SELECT '{{1,NULL,3},{4,5,6}}'::int4[][]",
             [[1, None, 3], [4, 5, 6]],
             self.poque.INT4ARRAYOID)
 
+    def test_text_array_value_str(self):
+        self._test_value_and_type_str(
+            r"""SELECT '{{"a,b","NULL",NULL},{"q\"t","b\\s",""}}'::text[]""",
+            [['a,b', 'NULL', None], ['q"t', 'b\\s', '']],
+            self.poque.TEXTARRAYOID)
+        self._test_value_and_type_str(
+            "SELECT '{{},{}}'::text[]", [], self.poque.TEXTARRAYOID)
+
     def test_int2_array_value_str(self):
         self._test_value_and_type_str("SELECT '{6, NULL, -4}'::int2[]",
                                       [6, None, -4], self.poque.INT2ARRAYOID)